@@ -0,0 +1,168 @@
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "Config.hpp"
+#include "http/Connection.hpp"
+
+/**
+ * Pipelined requests through a real connection, over a socket pair.
+ *
+ * Each round writes a batch of GETs to the client end, lets the connection
+ * read and queue them, answers them alternately with an in-memory page and
+ * a small cached file, sends the responses and drains them on the client
+ * end. Every operator new of the program is counted, separately while the
+ * requests are received and queued and while they are answered and sent.
+ * Once the connection and its thread have warmed up, receiving and queueing
+ * is expected to allocate nothing.
+ */
+
+namespace {
+	constexpr std::size_t PIPELINE_DEPTH = 8;
+
+	const std::string RAW_REQUEST(
+		"GET /static/index.html HTTP/1.1\r\n"
+		"Host: localhost:8080\r\n"
+		"Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+		"Connection: keep-alive\r\n"
+		"\r\n"
+	);
+
+	std::size_t allocations = 0;
+
+	struct Counts {
+		std::size_t requests { 0 };
+		std::size_t receiveAllocations { 0 };
+		std::size_t respondAllocations { 0 };
+	};
+
+	struct Client {
+		int sockets[2];
+
+		Client() {
+			if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) < 0) {
+				throw std::runtime_error("socketpair() failed");
+			}
+		}
+
+		~Client() {
+			::close(sockets[0]);
+			::close(sockets[1]);
+		}
+
+		int server() const {
+			return sockets[0];
+		}
+
+		int client() const {
+			return sockets[1];
+		}
+	};
+
+	void runRound(http::Connection& connection, const Client& client, const std::string& batch, const std::filesystem::path& file, const std::string& page, Counts& counts) {
+		static char sink[64 * 1024];
+
+		if (write(client.client(), batch.data(), batch.size()) != static_cast<ssize_t>(batch.size())) {
+			throw std::runtime_error("write() failed");
+		}
+
+		std::size_t before = allocations;
+
+		connection.read();
+		counts.receiveAllocations += allocations - before;
+		before = allocations;
+
+		while (http::Connection::Exchange* exchange = connection.getPendingExchange()) {
+			http::Response& response = exchange->second;
+
+			response.setStatus(http::Response::Status::IN_PROGRESS);
+
+			if (counts.requests % 2 == 0) {
+				response.setText(http::StatusCode::OK_200, page);
+			} else {
+				response.setFile(http::StatusCode::OK_200, file);
+			}
+
+			counts.requests++;
+		}
+
+		while (connection.hasReadyResponse()) {
+			connection.sendResponse();
+		}
+
+		counts.respondAllocations += allocations - before;
+
+		while (recv(client.client(), sink, sizeof(sink), MSG_DONTWAIT) > 0) {
+		}
+	}
+
+	void printPerRequest(const std::string& name, std::size_t count, std::size_t requests) {
+		std::cout << std::left << std::setw(28) << name << std::right << std::setw(12) << std::fixed << std::setprecision(3)
+			<< static_cast<double>(count) / requests << " /req" << std::endl;
+	}
+}
+
+void* operator new(std::size_t size) {
+	allocations++;
+
+	if (void* memory = std::malloc(size == 0 ? 1 : size)) {
+		return memory;
+	}
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+	std::free(memory);
+}
+
+int main(int argc, char** argv) {
+	const std::size_t rounds = argc > 1 ? std::stoul(argv[1]) : 50000;
+	const std::filesystem::path file = std::filesystem::temp_directory_path() / ("webserv-bench-" + std::to_string(::getpid()) + ".html");
+	const std::string page(100, 'p');
+	const ServerConfig serverConfig;
+	const Client client;
+	http::Connection connection(client.server(), serverConfig);
+	std::string batch;
+	Counts warmUp;
+	Counts counts;
+
+	std::ofstream(file) << std::string(2 * 1024, 's');
+
+	for (std::size_t i = 0; i < PIPELINE_DEPTH; i++) {
+		batch += RAW_REQUEST;
+	}
+
+	for (std::size_t i = 0; i < 10; i++) {
+		runRound(connection, client, batch, file, page, warmUp);
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+
+	for (std::size_t i = 0; i < rounds; i++) {
+		runRound(connection, client, batch, file, page, counts);
+	}
+
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	std::filesystem::remove(file);
+
+	std::cout
+		<< std::left << std::setw(28) << "pipelined connection"
+		<< std::right << std::setw(12) << std::fixed << std::setprecision(0) << counts.requests / elapsed.count() << " req/s"
+		<< std::setw(10) << std::setprecision(1) << elapsed.count() * 1e9 / counts.requests << " ns/req" << std::endl;
+	printPerRequest("allocations receiving", counts.receiveAllocations, counts.requests);
+	printPerRequest("allocations responding", counts.respondAllocations, counts.requests);
+
+	return counts.receiveAllocations == 0 ? 0 : 1;
+}
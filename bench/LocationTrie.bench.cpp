@@ -0,0 +1,123 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "LocationTrie.hpp"
+
+/**
+ * Longest-prefix location matching over synthetic configs of 10, 1k and
+ * 10k locations, nested a few levels deep like generated configs are.
+ * The trie is timed against the linear scan it replaced, which compares
+ * every location path with a substring of the request path.
+ */
+
+namespace {
+	constexpr std::size_t LOOKUP_PATHS = 1024;
+
+	Location locationAt(const std::string& path) {
+		Location location;
+
+		location.path = path;
+		return location;
+	}
+
+	std::vector<Location> makeLocations(std::size_t count) {
+		std::vector<Location> locations;
+
+		locations.push_back(locationAt("/"));
+
+		for (std::size_t i = 0; locations.size() < count; i++) {
+			const std::string app = "/app" + std::to_string(i % 100) + "/";
+
+			locations.push_back(locationAt(app + "v" + std::to_string(i / 100) + "/"));
+
+			if (locations.size() < count) {
+				locations.push_back(locationAt(app + "v" + std::to_string(i / 100) + "/static/"));
+			}
+		}
+
+		return locations;
+	}
+
+	// Half the paths fall under a random location, the others only match "/"
+	std::vector<std::string> makePaths(const std::vector<Location>& locations) {
+		std::mt19937 rng(1);
+		std::vector<std::string> paths;
+
+		for (std::size_t i = 0; i < LOOKUP_PATHS; i++) {
+			if (i % 2 == 0) {
+				paths.push_back(locations[rng() % locations.size()].path + "assets/main.css/");
+			} else {
+				paths.push_back("/missing/" + std::to_string(rng()) + "/");
+			}
+		}
+
+		return paths;
+	}
+
+	const Location* scanLinearly(const std::unordered_map<std::string, Location>& locations, const std::string& url) {
+		const Location* bestMatch = nullptr;
+		std::size_t longestMatch = 0;
+
+		for (const auto& [path, config] : locations) {
+			if (url.substr(0, path.size()) == path && path.length() > longestMatch) {
+				bestMatch = &config;
+				longestMatch = path.length();
+			}
+		}
+
+		return bestMatch;
+	}
+
+	template <typename Function>
+	void run(const std::string& name, const std::vector<std::string>& paths, std::size_t iterations, Function&& match) {
+		std::size_t matched = 0;
+		const auto start = std::chrono::steady_clock::now();
+
+		for (std::size_t i = 0; i < iterations; i++) {
+			for (const std::string& path : paths) {
+				matched += (match(path) != nullptr);
+			}
+		}
+
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+		std::cout
+			<< std::left << std::setw(32) << name
+			<< std::right << std::setw(12) << std::fixed << std::setprecision(1)
+			<< elapsed.count() * 1e9 / (iterations * paths.size()) << " ns/lookup"
+			<< (matched == 0 ? " " : "") << std::endl;
+	}
+}
+
+int main(int argc, char** argv) {
+	const std::size_t budget = argc > 1 ? std::stoul(argv[1]) : 20000000;
+
+	for (std::size_t count : { 10, 1000, 10000 }) {
+		const std::vector<Location> locations = makeLocations(count);
+		const std::vector<std::string> paths = makePaths(locations);
+		const LocationTrie trie(locations);
+		std::unordered_map<std::string, Location> locationByPath;
+
+		for (const Location& location : locations) {
+			locationByPath[location.path] = location;
+		}
+
+		// Both are given about the same number of location comparisons
+		const std::size_t trieIterations = std::max<std::size_t>(budget / (LOOKUP_PATHS * 10), 1);
+		const std::size_t scanIterations = std::max<std::size_t>(budget / (LOOKUP_PATHS * count), 1);
+		const std::string suffix = " (" + std::to_string(count) + " locations)";
+
+		run("trie" + suffix, paths, trieIterations, [&](const std::string& path) {
+			return trie.findLongestPrefix(path);
+		});
+		run("linear scan" + suffix, paths, scanIterations, [&](const std::string& path) {
+			return scanLinearly(locationByPath, path);
+		});
+	}
+
+	return 0;
+}
@@ -0,0 +1,193 @@
+#include <chrono>
+#include <cstdarg>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+# include <sys/syscall.h>
+#endif
+#include "http/parser.hpp"
+#include "http/Request.hpp"
+#include "http/Response.hpp"
+#include "utils/ReceiveBuffer.hpp"
+
+/**
+ * A request's trip through a connection, minus the sockets.
+ *
+ * Each round parses a batch of pipelined GETs from a receive buffer,
+ * queues the exchanges as the connection does, answers them with a small
+ * cached file, a large file and an in-memory page, moves them all to
+ * another container and gathers what would be sent. Besides the time, it
+ * counts the files opened and the in-memory bodies that are no longer
+ * sent from where they were produced, i.e. were copied on the way; both
+ * are expected to be 0 per request once the caches are warm.
+ */
+
+namespace {
+	using Exchange = std::pair<http::Request, http::Response>;
+
+	static_assert(!std::is_copy_constructible_v<http::Request>);
+	static_assert(!std::is_copy_constructible_v<http::Response>);
+	static_assert(!std::is_copy_constructible_v<utils::Payload>);
+	static_assert(std::is_nothrow_move_constructible_v<Exchange>);
+
+	constexpr std::size_t PIPELINE_DEPTH = 16;
+	constexpr int SOCKET = -1;	// Nothing is sent
+
+	const std::string RAW_REQUEST(
+		"GET /static/index.html HTTP/1.1\r\n"
+		"Host: localhost:8080\r\n"
+		"Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+		"Connection: keep-alive\r\n"
+		"\r\n"
+	);
+
+	std::size_t fileOpens = 0;
+
+	struct Files {
+		std::filesystem::path directory;
+		std::filesystem::path small;
+		std::filesystem::path large;
+
+		Files() : directory(std::filesystem::temp_directory_path() / ("webserv-bench-" + std::to_string(::getpid()))) {
+			std::filesystem::create_directories(directory);
+			small = directory / "small.html";
+			large = directory / "large.bin";
+			std::ofstream(small) << std::string(2 * 1024, 's');
+			std::ofstream(large) << std::string(256 * 1024, 'l');
+		}
+
+		~Files() {
+			std::filesystem::remove_all(directory);
+		}
+	};
+
+	struct Counts {
+		std::size_t requests { 0 };
+		std::size_t bodyCopies { 0 };
+	};
+
+	// Where the body of a response is sent from, if it is in memory
+	const void* bodyBytesOf(const http::Response& response) {
+		std::vector<iovec> iovecs;
+
+		if (response.getBody() == nullptr || !response.getBody()->gather(iovecs) || iovecs.empty()) {
+			return nullptr;
+		}
+
+		return iovecs.front().iov_base;
+	}
+
+	void runRound(const Files& files, http::RequestParser& parser, utils::ReceiveBuffer& buffer, Counts& counts) {
+		const std::string page(4 * 1024, 'p');
+		std::deque<Exchange> queue;
+		std::vector<const void*> bodyBytes;
+
+		for (std::size_t i = 0; i < PIPELINE_DEPTH; i++) {
+			buffer.append(reinterpret_cast<const std::uint8_t*>(RAW_REQUEST.data()), RAW_REQUEST.size());
+		}
+
+		while (!buffer.empty()) {
+			http::Request request;
+
+			parser.parseHeader(buffer, request);
+			queue.emplace_back(std::move(request), http::Response(SOCKET));
+		}
+
+		for (std::size_t i = 0; i < queue.size(); i++) {
+			http::Response& response = queue[i].second;
+
+			switch (i % 3) {
+				case 0: response.setFile(http::StatusCode::OK_200, files.small); break;
+				case 1: response.setFile(http::StatusCode::OK_200, files.large); break;
+				default: response.setText(http::StatusCode::OK_200, page); break;
+			}
+
+			bodyBytes.push_back(bodyBytesOf(response));
+		}
+
+		// Grown one at a time, the vector moves every exchange a few times
+		std::vector<Exchange> moved;
+
+		for (Exchange& exchange : queue) {
+			moved.push_back(std::move(exchange));
+		}
+
+		queue.clear();
+
+		for (std::size_t i = 0; i < moved.size(); i++) {
+			std::vector<iovec> iovecs;
+			std::size_t bytes = 0;
+
+			counts.bodyCopies += (bodyBytesOf(moved[i].second) != bodyBytes[i]);
+			moved[i].second.gather(iovecs);
+
+			for (const iovec& chunk : iovecs) {
+				bytes += chunk.iov_len;
+			}
+
+			moved[i].second.consume(bytes);
+			counts.requests++;
+		}
+	}
+}
+
+#ifdef __linux__
+// Every open() made by the server code linked in is counted on its way
+// to the kernel
+extern "C" int open(const char* path, int flags, ...) {
+	mode_t mode = 0;
+
+	if (flags & O_CREAT) {
+		va_list args;
+
+		va_start(args, flags);
+		mode = va_arg(args, mode_t);
+		va_end(args);
+	}
+
+	fileOpens++;
+	return static_cast<int>(::syscall(SYS_openat, AT_FDCWD, path, flags, mode));
+}
+#endif
+
+int main(int argc, char** argv) {
+	const std::size_t rounds = argc > 1 ? std::stoul(argv[1]) : 50000;
+	const Files files;
+	http::RequestParser parser;
+	utils::ReceiveBuffer buffer;
+	Counts warmUp;
+	Counts counts;
+
+	runRound(files, parser, buffer, warmUp);
+	fileOpens = 0;
+
+	const auto start = std::chrono::steady_clock::now();
+
+	for (std::size_t i = 0; i < rounds; i++) {
+		runRound(files, parser, buffer, counts);
+	}
+
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	std::cout
+		<< std::left << std::setw(28) << "request lifecycle"
+		<< std::right << std::setw(12) << std::fixed << std::setprecision(0) << counts.requests / elapsed.count() << " req/s"
+		<< std::setw(10) << std::setprecision(1) << elapsed.count() * 1e9 / counts.requests << " ns/req" << std::endl;
+#ifdef __linux__
+	std::cout << std::left << std::setw(28) << "file opens" << std::right << std::setw(12) << std::setprecision(3)
+		<< static_cast<double>(fileOpens) / counts.requests << " /req" << std::endl;
+#endif
+	std::cout << std::left << std::setw(28) << "body copies" << std::right << std::setw(12) << std::setprecision(3)
+		<< static_cast<double>(counts.bodyCopies) / counts.requests << " /req" << std::endl;
+
+	return counts.bodyCopies == 0 ? 0 : 1;
+}
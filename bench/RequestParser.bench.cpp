@@ -0,0 +1,73 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include "http/parser.hpp"
+#include "utils/ReceiveBuffer.hpp"
+
+/**
+ * Single-core throughput of the request header parser.
+ *
+ * Each scenario parses the same browser-like GET over and over and reports
+ * requests parsed per second, either with the whole header available at
+ * once or delivered in small slices as a slow client would send it.
+ */
+
+namespace {
+	const std::string RAW_REQUEST(
+		"GET /static/index.html?lang=en HTTP/1.1\r\n"
+		"Host: localhost:8080\r\n"
+		"User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:128.0) Gecko/20100101 Firefox/128.0\r\n"
+		"Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+		"Accept-Language: en-US,en;q=0.5\r\n"
+		"Accept-Encoding: gzip, deflate, br, zstd\r\n"
+		"Connection: keep-alive\r\n"
+		"Cache-Control: max-age=0\r\n"
+		"\r\n"
+	);
+
+	template <typename Function>
+	void run(const std::string& name, std::size_t iterations, Function&& parseOnce) {
+		const auto start = std::chrono::steady_clock::now();
+
+		for (std::size_t i = 0; i < iterations; i++) {
+			parseOnce();
+		}
+
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+		std::cout
+			<< std::left << std::setw(28) << name
+			<< std::right << std::setw(12) << std::fixed << std::setprecision(0) << iterations / elapsed.count() << " req/s"
+			<< std::setw(10) << std::setprecision(1) << elapsed.count() * 1e9 / iterations << " ns/req" << std::endl;
+	}
+}
+
+int main(int argc, char** argv) {
+	const std::size_t iterations = argc > 1 ? std::stoul(argv[1]) : 1000000;
+	const std::uint8_t* raw = reinterpret_cast<const std::uint8_t*>(RAW_REQUEST.data());
+	http::RequestParser parser;
+	utils::ReceiveBuffer buffer;
+
+	run("whole header", iterations, [&] {
+		http::Request request;
+
+		buffer.append(raw, RAW_REQUEST.size());
+		parser.parseHeader(buffer, request);
+	});
+
+	for (const std::size_t sliceSize : { 64, 8 }) {
+		run("slices of " + std::to_string(sliceSize) + " bytes", iterations, [&] {
+			http::Request request;
+
+			for (std::size_t offset = 0; request.getStatus() == http::Request::Status::PENDING; offset += sliceSize) {
+				const std::size_t end = std::min(offset + sliceSize, RAW_REQUEST.size());
+
+				buffer.append(raw + offset, end - offset);
+				parser.parseHeader(buffer, request);
+			}
+		});
+	}
+
+	return 0;
+}
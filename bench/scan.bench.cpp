@@ -0,0 +1,97 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "utils/scan.hpp"
+
+/**
+ * Throughput of the byte scanning kernels at every SIMD level the CPU
+ * supports, over a request header block and a large multipart body.
+ */
+
+namespace {
+	const std::string HEADER(
+		"GET /static/index.html?lang=en HTTP/1.1\r\n"
+		"Host: localhost:8080\r\n"
+		"User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:128.0) Gecko/20100101 Firefox/128.0\r\n"
+		"Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+		"Accept-Language: en-US,en;q=0.5\r\n"
+		"Accept-Encoding: gzip, deflate, br, zstd\r\n"
+		"Connection: keep-alive\r\n"
+		"Cache-Control: max-age=0\r\n"
+		"\r\n"
+	);
+
+	const char* levelName(utils::SimdLevel level) {
+		switch (level) {
+			case utils::SimdLevel::AVX2: return "avx2";
+			case utils::SimdLevel::SSE42: return "sse4.2";
+			default: return "scalar";
+		}
+	}
+
+	template <typename Function>
+	void run(const std::string& name, std::size_t bytesPerRun, std::size_t iterations, Function&& scanOnce) {
+		std::size_t sink = 0;
+		const auto start = std::chrono::steady_clock::now();
+
+		for (std::size_t i = 0; i < iterations; i++) {
+			sink += scanOnce();
+		}
+
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+		std::cout
+			<< std::left << std::setw(40) << name
+			<< std::right << std::setw(10) << std::fixed << std::setprecision(2)
+			<< bytesPerRun * iterations / elapsed.count() / 1e9 << " GB/s"
+			<< (sink == 0 ? " " : "") << std::endl;
+	}
+}
+
+int main(int argc, char** argv) {
+	const std::size_t iterations = argc > 1 ? std::stoul(argv[1]) : 200;
+	const auto* header = reinterpret_cast<const std::uint8_t*>(HEADER.data());
+	const std::string boundary("--------------------------boundary4f2a9c");
+	std::vector<std::uint8_t> body(8 << 20);
+	std::mt19937 rng(1);
+
+	for (auto& byte : body) {
+		byte = static_cast<std::uint8_t>(rng());
+	}
+
+	std::copy(boundary.begin(), boundary.end(), body.end() - boundary.size());
+
+	for (int level = 0; level <= static_cast<int>(utils::getMaxSimdLevel()); level++) {
+		utils::setSimdLevel(static_cast<utils::SimdLevel>(level));
+		const std::string prefix(levelName(utils::getSimdLevel()));
+
+		run(prefix + " header line feeds", HEADER.size(), iterations * 10000, [&] {
+			std::size_t lines = 0;
+
+			for (auto* current = header; current != header + HEADER.size(); current++, lines++) {
+				current = utils::findByte(current, header + HEADER.size(), '\n');
+			}
+
+			return lines;
+		});
+
+		run(prefix + " header names", HEADER.size(), iterations * 10000, [&] {
+			std::size_t names = 0;
+
+			for (auto* current = header; current < header + HEADER.size(); names++) {
+				current = utils::findNonToken(current, header + HEADER.size()) + 1;
+			}
+
+			return names;
+		});
+
+		run(prefix + " 8 MiB multipart boundary", body.size(), iterations, [&] {
+			return static_cast<std::size_t>(utils::findSequence(body.data(), body.data() + body.size(), boundary) - body.data());
+		});
+	}
+
+	return 0;
+}
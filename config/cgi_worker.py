@@ -0,0 +1,166 @@
+#!/usr/bin/env python3
+"""CGI worker for Python scripts, kept running by webserv (cgi_worker).
+
+It speaks FastCGI on stdin, a socket connected to the server, and runs
+the scripts it is asked for in this interpreter, one at a time: startup
+and the modules the scripts import are paid for once per worker instead
+of once per request. Each script gets the CGI environment, its request
+body as stdin, and its stdout sent back as it is written.
+
+The worker exits when the server closes the socket.
+"""
+
+import io
+import os
+import runpy
+import socket
+import struct
+import sys
+import traceback
+
+VERSION = 1
+BEGIN_REQUEST, ABORT_REQUEST, END_REQUEST, PARAMS, STDIN, STDOUT, STDERR = 1, 2, 3, 4, 5, 6, 7
+GET_VALUES, GET_VALUES_RESULT, UNKNOWN_TYPE = 9, 10, 11
+RESPONDER = 1
+REQUEST_COMPLETE, CANT_MPX_CONN, OVERLOADED, UNKNOWN_ROLE = 0, 1, 2, 3
+MAX_CONTENT = 65535
+
+
+def record(type, request_id, content=b""):
+    padding = (8 - len(content) % 8) % 8
+    return struct.pack("!BBHHBx", VERSION, type, request_id, len(content), padding) + content + b"\0" * padding
+
+
+def end_request(request_id, app_status=0, protocol_status=REQUEST_COMPLETE):
+    return record(END_REQUEST, request_id, struct.pack("!IB3x", app_status & 0xffffffff, protocol_status))
+
+
+def encode_length(length):
+    return bytes([length]) if length < 128 else struct.pack("!I", length | 0x80000000)
+
+
+def parse_name_values(data):
+    pairs, i = {}, 0
+    while i < len(data):
+        lengths = []
+        for _ in range(2):
+            if data[i] < 128:
+                lengths.append(data[i])
+                i += 1
+            else:
+                lengths.append(struct.unpack("!I", data[i:i + 4])[0] & 0x7fffffff)
+                i += 4
+        name, value = data[i:i + lengths[0]], data[i + lengths[0]:i + sum(lengths)]
+        pairs[name.decode("latin-1")] = value.decode("latin-1")
+        i += sum(lengths)
+    return pairs
+
+
+class RecordWriter(io.RawIOBase):
+    """Raw stream turning what is written into STDOUT or STDERR records."""
+
+    def __init__(self, sock, type, request_id):
+        self.sock, self.type, self.request_id = sock, type, request_id
+
+    def writable(self):
+        return True
+
+    def write(self, data):
+        data = bytes(data)
+        for offset in range(0, len(data), MAX_CONTENT):
+            self.sock.sendall(record(self.type, self.request_id, data[offset:offset + MAX_CONTENT]))
+        return len(data)
+
+
+class Worker:
+    def __init__(self, sock):
+        self.sock = sock
+        self.environ = dict(os.environ)
+        self.requests = {}
+
+    def run_script(self, request_id, params, body):
+        script = params.get("SCRIPT_FILENAME", "")
+        stdout = io.TextIOWrapper(io.BufferedWriter(RecordWriter(self.sock, STDOUT, request_id), 64 * 1024), encoding="utf-8")
+        saved = sys.stdin, sys.stdout, sys.argv, os.getcwd()
+        status = 0
+
+        os.environ.clear()
+        os.environ.update(self.environ)
+        os.environ.update(params)
+        sys.stdin = io.TextIOWrapper(io.BytesIO(body), encoding="utf-8")
+        sys.stdout, sys.argv = stdout, [script]
+
+        try:
+            os.chdir(os.path.dirname(script) or ".")
+            runpy.run_path(script, run_name="__main__")
+        except SystemExit as e:
+            status = e.code if isinstance(e.code, int) else (0 if e.code is None else 1)
+        except BaseException:
+            status = 1
+            RecordWriter(self.sock, STDERR, request_id).write(traceback.format_exc().encode())
+        finally:
+            try:
+                stdout.flush()
+            except (OSError, ValueError):
+                pass
+            sys.stdin, sys.stdout, sys.argv = saved[:3]
+            os.chdir(saved[3])
+
+        self.sock.sendall(end_request(request_id, status))
+
+    def handle(self, type, request_id, content):
+        if type == GET_VALUES:
+            values = {"FCGI_MAX_CONNS": "1", "FCGI_MAX_REQS": "1", "FCGI_MPXS_CONNS": "0"}
+            reply = b"".join(
+                encode_length(len(name)) + encode_length(len(values[name])) + name.encode() + values[name].encode()
+                for name in parse_name_values(content) if name in values
+            )
+            self.sock.sendall(record(GET_VALUES_RESULT, 0, reply))
+        elif type == BEGIN_REQUEST:
+            role = struct.unpack("!H", content[:2])[0]
+            if role != RESPONDER:
+                self.sock.sendall(end_request(request_id, protocol_status=UNKNOWN_ROLE))
+            elif self.requests:
+                self.sock.sendall(end_request(request_id, protocol_status=CANT_MPX_CONN))
+            else:
+                self.requests[request_id] = [b"", b""]
+        elif type == PARAMS and request_id in self.requests:
+            self.requests[request_id][0] += content
+        elif type == STDIN and request_id in self.requests:
+            if content:
+                self.requests[request_id][1] += content
+                return
+            params, body = self.requests.pop(request_id)
+            self.run_script(request_id, parse_name_values(params), body)
+        elif type == ABORT_REQUEST and request_id in self.requests:
+            del self.requests[request_id]
+            self.sock.sendall(end_request(request_id))
+        elif type not in (PARAMS, STDIN, ABORT_REQUEST):
+            self.sock.sendall(record(UNKNOWN_TYPE, 0, bytes([type]) + b"\0" * 7))
+
+    def run(self):
+        buffer = b""
+        while True:
+            data = self.sock.recv(65536)
+            if not data:
+                return
+            buffer += data
+            while len(buffer) >= 8:
+                _, type, request_id, length, padding = struct.unpack("!BBHHBx", buffer[:8])
+                if len(buffer) < 8 + length + padding:
+                    break
+                content = buffer[8:8 + length]
+                buffer = buffer[8 + length + padding:]
+                self.handle(type, request_id, content)
+
+
+if __name__ == "__main__":
+    sock = socket.socket(fileno=os.dup(0))
+    sock.setblocking(True)
+    # Scripts printing to the real stdin/stdout would corrupt the protocol
+    devnull = os.open(os.devnull, os.O_RDWR)
+    os.dup2(devnull, 0)
+    try:
+        Worker(sock).run()
+    except (BrokenPipeError, ConnectionResetError):
+        pass
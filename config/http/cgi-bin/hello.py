@@ -0,0 +1,17 @@
+#!/usr/bin/env python3
+# Example CGI script: echoes the request it was run for
+
+import os
+import sys
+
+body = sys.stdin.read()
+
+print("Content-Type: text/plain; charset=utf-8")
+print()
+print("Hello from CGI")
+
+for name in ("REQUEST_METHOD", "QUERY_STRING", "SCRIPT_NAME", "PATH_INFO", "CONTENT_LENGTH", "CONTENT_TYPE", "HTTP_HOST"):
+	print(f"{name}={os.environ.get(name, '')}")
+
+if body:
+	print(f"body={body}")
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Config.hpp"
+#include "http/Request.hpp"
+#include "http/Response.hpp"
+
+struct CgiScript {
+	std::filesystem::path path;		// SCRIPT_FILENAME
+	std::string interpreter;		// Empty when the script is executed itself
+	std::string name;				// SCRIPT_NAME
+	std::string pathInfo;			// PATH_INFO
+	std::string extension;			// The cgi_extension it matched
+};
+
+/** The script `urlPath` names in a CGI location, if it exists. */
+std::optional<CgiScript> findCgiScript(const Location& loc, std::string_view urlPath);
+
+/** The meta-variables of RFC 3875, section 4.1, as NAME=value strings. */
+std::vector<std::string> makeCgiEnv(const CgiScript& script, const ServerConfig& serverConfig, const http::Request& request, int clientFd);
+
+/**
+ * Turns the output of a CGI script into its response, as it arrives.
+ *
+ * The CGI header fields become the response header, Status and Location
+ * included (RFC 3875, 6.3), and the rest is streamed to the client,
+ * chunked unless the script gave a Content-Length. Whether the output
+ * comes from a pipe or from FastCGI records makes no difference here.
+ */
+class CgiOutput {
+	public:
+		static constexpr std::size_t MAX_HEADER_SIZE = 8 * 1024;
+
+		CgiOutput(http::Response& response, const std::map<int, std::string>& errorPages);
+
+		void append(const std::uint8_t* data, std::size_t size);
+
+		/** Ends the response; a script that stopped before its header failed. */
+		void finish();
+
+		/**
+		 * Answers `statusCode` instead, or, once the header is out, cuts the
+		 * body short and has the connection closed after it.
+		 */
+		void fail(http::StatusCode statusCode);
+
+		/** Answers 503 before anything was sent, asking to retry after `retryAfter` seconds. */
+		void reject(std::size_t retryAfter);
+
+		/** Lets go of the response, which is being dropped. */
+		void detach();
+
+		bool isAttached() const;
+		int getClientFd() const;
+
+		/** Output waiting for the client, to hold the script back when it is behind. */
+		std::size_t getBufferedBytes() const;
+
+	private:
+		int _clientFd;
+		const std::map<int, std::string>* _errorPages;
+		http::Response* _response;
+		utils::StreamPayload* _body { nullptr };
+		std::string _header;
+
+		void _parseHeader(const std::uint8_t* data, std::size_t size);
+		bool _buildResponse(std::string_view header);
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "Cgi.hpp"
+#include "Process.hpp"
+#include "Upstream.hpp"
+
+/**
+ * A CGI/1.1 script (RFC 3875) running for one exchange.
+ *
+ * The request body goes to the script's stdin as it is received, and its
+ * output comes back from its stdout, both through non-blocking pipes the
+ * event loop polls.
+ *
+ * The pipes are closed by the event loop once they are done with, and the
+ * child is reaped after that.
+ */
+class CgiProcess : public Upstream, public Process {
+	public:
+		static constexpr std::size_t READ_BUFFER_SIZE = 64 * 1024;
+		// Output held for a slow client before the script is read from again
+		static constexpr std::size_t MAX_BUFFERED_OUTPUT = 1024 * 1024;
+
+		/** Forks and executes `script`, throwing std::runtime_error if it cannot be started. */
+		CgiProcess(const CgiScript& script, const ServerConfig& serverConfig, const http::Request& request, http::Response& response);
+		CgiProcess(const CgiProcess&) = delete;
+		~CgiProcess();
+
+		CgiProcess& operator=(const CgiProcess&) = delete;
+
+		short getEvents(int fd) const override;
+		bool isPipeOpen(int fd) const override;
+		void closePipe(int fd) override;
+		void process(int fd, short revents, std::vector<int>& clientFds) override;
+
+		/** Kills the script and lets go of the exchange, which is being dropped. */
+		void abort(int clientFd) override;
+
+		bool isDone() const override;
+
+		void writeInput();
+		void readOutput();
+
+		int getClientFd() const;
+		int getInputFd() const;
+		int getOutputFd() const;
+
+	private:
+		int _inputFd { -1 };
+		int _outputFd { -1 };
+		bool _isInputOpen { false };
+		bool _isOutputOpen { false };
+		std::shared_ptr<http::RequestBody> _input;
+		CgiOutput _output;
+
+		void _finishOutput();
+};
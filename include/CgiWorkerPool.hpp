@@ -0,0 +1,108 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Config.hpp"
+#include "FastCgi.hpp"
+#include "Process.hpp"
+
+/**
+ * A process kept running to serve the scripts of a CGI location, one at a
+ * time, so that they do not pay for starting their interpreter.
+ *
+ * The server speaks FastCGI to it over a socket pair, the worker's end
+ * being its stdin. Closing that socket is how it is told to exit. A worker
+ * whose request is aborted is killed instead, as it may well be stuck in
+ * the script.
+ */
+class CgiWorker : public Process, public Upstream {
+	public:
+		/** Starts `args` in `directory`, throwing std::runtime_error if it cannot. */
+		CgiWorker(std::vector<std::string> args, const std::string& directory);
+
+		/** True once the event loop closed the socket. */
+		bool isDone() const override;
+
+		short getEvents(int fd) const override;
+		bool isPipeOpen(int fd) const override;
+		void closePipe(int fd) override;
+		void process(int fd, short revents, std::vector<int>& clientFds) override;
+		void abort(int clientFd) override;
+
+		void begin(const fastcgi::NameValues& params, std::shared_ptr<http::RequestBody> input, CgiOutput output);
+
+		/** Requests sent to the worker since it started. */
+		std::size_t getServedRequests() const;
+
+		/** True once killed for an aborted request, after which it takes no more. */
+		bool isAborted() const;
+
+		const std::shared_ptr<FastCgiConnection>& getConnection() const;
+
+	private:
+		std::shared_ptr<FastCgiConnection> _connection;
+		std::size_t _servedRequests { 0 };
+		bool _isAborted { false };
+};
+
+/**
+ * The workers of one `cgi_worker` program in a location.
+ *
+ * `cgiWorkersMin` workers are started ahead of requests. A request goes to
+ * an idle worker, or to a new one while there are fewer than
+ * `cgiWorkersMax`, and waits otherwise. Once `cgiQueueSize` requests are
+ * waiting, new ones are answered 503 with a Retry-After.
+ *
+ * A worker is replaced after `cgiWorkerRequests` requests, which bounds
+ * what a leaking script costs. Workers that die are replaced as well, the
+ * request they were running answered 502.
+ */
+class CgiWorkerPool {
+	public:
+		// Seconds a rejected client is asked to wait
+		static constexpr std::size_t RETRY_AFTER = 1;
+
+		/** Starts the minimum number of workers, registering them for the event loop. */
+		CgiWorkerPool(
+			const Location& loc,
+			const std::string& extension,
+			std::unordered_map<int, std::shared_ptr<Upstream>>& upstreamByFd,
+			std::vector<std::shared_ptr<Process>>& processes
+		);
+
+		void submit(fastcgi::NameValues params, std::shared_ptr<http::RequestBody> input, CgiOutput output);
+
+		/**
+		 * Retires and replaces workers, and sends waiting requests to those
+		 * that are idle again, adding the clients answered here to `clientFds`.
+		 */
+		void dispatch(std::vector<int>& clientFds);
+
+		/** Drops the waiting requests of `clientFd`; the workers are aborted as upstreams. */
+		void abort(int clientFd);
+
+	private:
+		struct Request {
+			fastcgi::NameValues params;
+			std::shared_ptr<http::RequestBody> input;
+			CgiOutput output;
+		};
+
+		std::vector<std::string> _args;
+		std::string _directory;
+		std::size_t _minWorkers;
+		std::size_t _maxWorkers;
+		std::size_t _maxRequests;
+		std::size_t _maxQueued;
+		std::unordered_map<int, std::shared_ptr<Upstream>>& _upstreamByFd;
+		std::vector<std::shared_ptr<Process>>& _processes;
+		std::vector<std::shared_ptr<CgiWorker>> _workers;
+		std::deque<Request> _queue;
+
+		CgiWorker* _findWorker();
+		CgiWorker& _startWorker();
+		bool _isWorn(const CgiWorker& worker) const;
+};
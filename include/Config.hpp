@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <functional> 	// std::function
 #include <string>
 #include <vector>
@@ -15,6 +16,12 @@
 # define BLUE "\033[0;34m"
 # define RESET "\033[0m"
 
+// Readiness notification backend driving the event loop
+enum class EventBackend : std::uint8_t {
+	POLL,	// poll(2), available everywhere
+	EPOLL	// epoll(7), Linux only
+};
+
 // Server struct
 struct Location {
 	std::string path;						// Location path (/, /static/, /static/index.html, /cgi-bin)
@@ -24,7 +31,16 @@ struct Location {
 	bool isAutoIndex = false;				// Enbale or disable directory listing
 	std::vector<std::string> methods; 		// Allowed methods
 	std::vector<std::string> cgiExtension; 	// CGI extensions
+	std::map<std::string, std::string> cgiInterpreter;	// Extension -> interpreter, the script runs itself otherwise
+	std::string fastcgiPass;				// unix:/path or host:port of a FastCGI server running the scripts instead
+	std::size_t fastcgiConnections = 8;		// Persistent connections kept to that server
+	std::map<std::string, std::filesystem::path> cgiWorker;	// Extension -> worker program kept running for its scripts
+	std::size_t cgiWorkersMin = 1;			// Workers started ahead of requests
+	std::size_t cgiWorkersMax = 4;			// Workers running at most
+	std::size_t cgiWorkerRequests = 1000;	// Requests a worker serves before it is replaced, 0 for no limit
+	std::size_t cgiQueueSize = 64;			// Requests waiting for a worker before new ones get 503
 	std::vector<std::string> returnUrl; 	// Redirect URLs (if any)
+	std::string cacheControl = "no-cache";	// Cache-Control of the files served, revalidated by default
 };
 
 struct ServerConfig {
@@ -34,6 +50,7 @@ struct ServerConfig {
 	std::map<int, std::string> errorPages;
 	std::string clientMaxBodySizeStr;
 	size_t clientMaxBodySize = 10 * 1024 * 1024;	// 10MB
+	std::size_t clientBufferSize = 16 * 1024;	// Receive buffer of each connection, larger than a request header may be
 	std::vector<Location> locations;
 
 	// Timeout settings (in milliseconds)
@@ -47,6 +64,17 @@ struct ServerConfig {
 struct Config {
 	std::vector<int> ports;
 	std::vector<ServerConfig> servers;
+#ifdef __linux__
+	EventBackend eventBackend = EventBackend::EPOLL;
+#else
+	EventBackend eventBackend = EventBackend::POLL;
+#endif
+	std::size_t workerThreads = 1;	// Event loops running in parallel
+	std::size_t openFileCacheSize = 1000;	// Open files kept per worker, 0 disables the cache
+	std::size_t openFileCacheValid = 1000;	// Milliseconds before a cached file is stat()ed again
+	std::size_t responseCacheSize = 16 * 1024 * 1024;	// Bytes of serialized responses per worker, 0 disables it
+	std::size_t responseCacheMaxFile = 64 * 1024;		// Largest file served from the response cache
+	std::map<std::string, std::vector<std::string>> mimeTypes;	// MIME type -> its extensions, from the types block, on top of the built-in ones
 };
 
 // Define types for parsers
@@ -65,7 +93,9 @@ public:
 	void parseHttpBlock(std::ifstream &file, Config &config);
 	void parseServerBlock(std::ifstream &file, ServerConfig &server);
 	void parseLocationBlock(std::ifstream &file, Location &location);
+	void parseTypesBlock(std::ifstream &file, Config &config);
 	void parseConfig(const std::string &filename, Config &config);
+	void parseHttp(const std::string &line, Config &config);
 	void parseGlobal(const std::string &line, ServerConfig &server);
 	void parseLocation(const std::string &line, Location &currentLocation);
 	Config load();
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include "Config.hpp"
+#include "Poller.hpp"
+#include "Server.hpp"
+#include "TimerWheel.hpp"
+
+/**
+ * Owns a set of Servers and drives them from a single Poller.
+ *
+ * Each registered fd gets an EventHandle which is stored by address in the
+ * poller, so a ready event leads straight to its Server and Connection
+ * without looking anything up by fd.
+ *
+ * Client handles also carry a timer for the timeout of the phase their
+ * connection is in. The wait timeout is the time left until the next
+ * deadline, so an idle loop does not wake up at all. A listener uses its
+ * timer to resume accepting after the process ran out of fds.
+ */
+class EventLoop {
+	public:
+		EventLoop(const Config& config, bool isReusePort);
+		EventLoop(const EventLoop&) = delete;
+		~EventLoop() = default;
+
+		EventLoop& operator=(const EventLoop&) = delete;
+
+		// How often CGI children that outlived their pipes are reaped
+		static constexpr int REAP_INTERVAL_MS = 100;
+
+		// How long a listener rests after accepting failed for want of fds
+		static constexpr int ACCEPT_BACKOFF_MS = 100;
+
+		void run();
+
+	private:
+		struct EventHandle {
+			enum class Type : uint8_t {
+				LISTENER,	// A passive socket of a Server
+				CLIENT,		// An accepted client socket
+				PIPE		// A CGI pipe or a connection to a FastCGI server
+			};
+
+			int fd;
+			Type type;
+			short events;
+			Server* server;
+			http::Connection* connection;
+			http::Connection::Phase phase { http::Connection::Phase::IDLE };
+			TimerWheel::Timer timer {};
+		};
+
+		std::uint64_t _now;
+		bool _hasExitingProcesses { false };
+		std::size_t _openFileCacheSize;
+		std::size_t _openFileCacheValid;
+		std::size_t _responseCacheSize;
+		std::size_t _responseCacheMaxFile;
+		TimerWheel _timers;
+		std::unique_ptr<Poller> _poller;
+		std::vector<std::unique_ptr<Server>> _servers;
+		std::unordered_map<int, EventHandle> _handleByFd;
+		std::vector<Poller::Event> _readyEvents;
+		std::vector<int> _changedClientFds;
+
+		void _addHandle(int fd, EventHandle::Type type, Server& server, http::Connection* connection);
+		void _removeHandle(int fd);
+		void _dispatch(EventHandle& handle, short revents);
+		void _accept(EventHandle& handle);
+		void _processClient(EventHandle& handle, short revents);
+		void _updateClient(EventHandle& handle, short previousEvents, bool isActive);
+		void _armTimer(EventHandle& handle, bool isActive);
+		void _onTimeout(EventHandle& handle);
+		void _processPipe(EventHandle& handle, short revents);
+		void _wakeClients();
+		void _updatePipeConnections(Server& server);
+};
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Cgi.hpp"
+#include "Upstream.hpp"
+
+/**
+ * Records of the FastCGI protocol, version 1.
+ *
+ * A record is an 8 byte header followed by its content and padding. The
+ * content of PARAMS and GET_VALUES records is a list of name-value pairs,
+ * each length taking 1 byte below 128 and 4 bytes with the high bit set
+ * otherwise.
+ */
+namespace fastcgi {
+	constexpr std::uint8_t VERSION = 1;
+	constexpr std::size_t HEADER_SIZE = 8;
+	constexpr std::size_t MAX_CONTENT_SIZE = 0xffff;
+
+	enum class RecordType : std::uint8_t {
+		BEGIN_REQUEST = 1,
+		ABORT_REQUEST,
+		END_REQUEST,
+		PARAMS,
+		STDIN,
+		STDOUT,
+		STDERR,
+		DATA,
+		GET_VALUES,
+		GET_VALUES_RESULT,
+		UNKNOWN_TYPE
+	};
+
+	enum class ProtocolStatus : std::uint8_t {
+		REQUEST_COMPLETE,
+		CANT_MPX_CONN,
+		OVERLOADED,
+		UNKNOWN_ROLE
+	};
+
+	struct Header {
+		RecordType type;
+		std::uint16_t requestId;
+		std::uint16_t contentLength;
+		std::uint8_t paddingLength;
+	};
+
+	using NameValues = std::vector<std::pair<std::string, std::string>>;
+
+	/** Appends a record, `content` being at most MAX_CONTENT_SIZE bytes. */
+	void appendRecord(std::string& out, RecordType type, std::uint16_t requestId, std::string_view content);
+
+	/** Appends the BEGIN_REQUEST record of a responder on a kept connection. */
+	void appendBeginRequest(std::string& out, std::uint16_t requestId);
+
+	/** Appends `nameValues` as PARAMS records, ending with the empty one. */
+	void appendParams(std::string& out, std::uint16_t requestId, const NameValues& nameValues);
+
+	void appendNameValue(std::string& out, std::string_view name, std::string_view value);
+
+	/** Reads a record header, throwing std::invalid_argument if it is not version 1. */
+	Header parseHeader(const std::uint8_t* data);
+
+	/** Throws std::invalid_argument if a length runs past `content`. */
+	NameValues parseNameValues(std::string_view content);
+}
+
+/**
+ * A persistent connection to a FastCGI server, over a Unix socket or TCP.
+ *
+ * Requests are multiplexed when the server says it can take more than one
+ * at a time, which is asked with GET_VALUES right after connecting; until
+ * the answer comes, one request at a time is sent. The connection is kept
+ * open between requests (FCGI_KEEP_CONN).
+ *
+ * Request bodies are sent as STDIN records as they are received and the
+ * socket drains, and STDOUT records go straight to the output of their
+ * request. While the client of any request is behind, nothing is read
+ * from the server, as the records of all requests share the socket.
+ */
+class FastCgiConnection : public Upstream {
+	public:
+		static constexpr std::size_t READ_BUFFER_SIZE = 64 * 1024;
+		// Output held for a slow client before the server is read from again
+		static constexpr std::size_t MAX_BUFFERED_OUTPUT = 1024 * 1024;
+		// Request bodies are only added once less than this is left to send
+		static constexpr std::size_t MAX_BUFFERED_INPUT = 64 * 1024;
+
+		/** Starts connecting to `address`, throwing std::runtime_error if it cannot. */
+		explicit FastCgiConnection(const std::string& address);
+
+		/** Takes over `fd`, already connected to a FastCGI server. */
+		explicit FastCgiConnection(int fd);
+
+		FastCgiConnection(const FastCgiConnection&) = delete;
+		~FastCgiConnection();
+
+		FastCgiConnection& operator=(const FastCgiConnection&) = delete;
+
+		/** Sends a request, its body, if any, following as it is received. */
+		void begin(const fastcgi::NameValues& params, std::shared_ptr<http::RequestBody> input, CgiOutput output);
+
+		/** How many more requests can be sent now. */
+		std::size_t getCapacity() const;
+
+		/** Stops using an idle connection, for the event loop to close it. */
+		void shutdown();
+
+		std::size_t getRequestCount() const;
+
+		/** Whether a request of `clientFd` is running. */
+		bool isServing(int clientFd) const;
+
+		bool isOpen() const;
+		int getFd() const;
+
+		short getEvents(int fd) const override;
+		bool isPipeOpen(int fd) const override;
+		void closePipe(int fd) override;
+		void process(int fd, short revents, std::vector<int>& clientFds) override;
+		void abort(int clientFd) override;
+
+	private:
+		struct Exchange {
+			CgiOutput output;
+			std::shared_ptr<http::RequestBody> input;
+			bool isInputSent;
+		};
+
+		int _fd { -1 };
+		bool _isConnecting { false };
+		bool _isOpen { false };
+		std::size_t _maxRequests { 1 };
+		std::uint16_t _lastRequestId { 0 };
+		std::string _out;
+		std::size_t _outOffset { 0 };
+		std::string _in;
+		std::map<std::uint16_t, Exchange> _exchanges;
+
+		void _connect(const std::string& address);
+		void _askValues();
+		void _send();
+		void _receive(std::vector<int>& clientFds);
+		void _addInput(std::vector<int>& clientFds);
+		void _handleRecord(const fastcgi::Header& header, std::string_view content, std::vector<int>& clientFds);
+		void _handleValues(std::string_view content);
+		void _endRequest(std::uint16_t requestId, std::string_view content, std::vector<int>& clientFds);
+		void _fail(std::vector<int>& clientFds);
+		std::uint16_t _nextRequestId();
+};
+
+/**
+ * The connections kept to one FastCGI server.
+ *
+ * A request goes to the connection with room for it, a new connection is
+ * opened while there are fewer than `maxConnections`, and it waits for
+ * one otherwise. Connections are registered in `upstreamByFd` for the
+ * event loop to poll, and forgotten once it closed them.
+ */
+class FastCgiPool {
+	public:
+		// Requests waiting for a connection before new ones are answered 503
+		static constexpr std::size_t MAX_QUEUED_REQUESTS = 1024;
+
+		FastCgiPool(const std::string& address, std::size_t maxConnections, std::unordered_map<int, std::shared_ptr<Upstream>>& upstreamByFd);
+
+		void submit(fastcgi::NameValues params, std::shared_ptr<http::RequestBody> input, CgiOutput output);
+
+		/**
+		 * Sends waiting requests to connections that have room again, adding
+		 * the clients of those that failed to `clientFds`.
+		 */
+		void dispatch(std::vector<int>& clientFds);
+
+		/** Drops the waiting requests of `clientFd`; the connections are aborted as upstreams. */
+		void abort(int clientFd);
+
+	private:
+		struct Request {
+			fastcgi::NameValues params;
+			std::shared_ptr<http::RequestBody> input;
+			CgiOutput output;
+		};
+
+		std::string _address;
+		std::size_t _maxConnections;
+		std::unordered_map<int, std::shared_ptr<Upstream>>& _upstreamByFd;
+		std::vector<std::shared_ptr<FastCgiConnection>> _connections;
+		std::deque<Request> _queue;
+
+		FastCgiConnection* _findConnection();
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Config.hpp"
+
+/**
+ * The locations of a server, compiled into a radix tree for matching
+ * request paths by their longest prefix.
+ *
+ * Each node holds the bytes of the edge leading to it and, when a location
+ * path ends there, that location. Its children are kept sorted by their
+ * first byte, so a lookup walks at most one edge per byte of the path,
+ * compares with no copies and allocates nothing, however many locations
+ * there are.
+ *
+ * Paths are matched as plain byte prefixes: "/static" matches
+ * "/static-files/" as well. A location inserted again with the same path
+ * replaces the earlier one.
+ */
+class LocationTrie {
+	public:
+		LocationTrie();
+		explicit LocationTrie(const std::vector<Location>& locations);
+
+		void insert(const Location& location);
+
+		/** The location with the longest path `path` starts with, or null. */
+		const Location* findLongestPrefix(std::string_view path) const;
+
+		std::size_t size() const;
+
+	private:
+		static constexpr std::uint32_t NONE = UINT32_MAX;
+
+		struct Edge {
+			char first;
+			std::uint32_t node;
+		};
+
+		struct Node {
+			std::string label;					// Bytes from the parent, the first one in its edge
+			std::vector<Edge> edges;			// Sorted by first byte
+			std::uint32_t location { NONE };	// Index in _locations
+		};
+
+		std::vector<Node> _nodes;
+		std::vector<Location> _locations;
+
+		std::uint32_t _findChild(std::uint32_t node, char first) const;
+		std::uint32_t _addNode(std::string_view label);
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <poll.h>
+#include "Config.hpp"
+
+#ifdef __linux__
+# include <sys/epoll.h>
+#endif
+
+/**
+ * Readiness notification backend used by the EventLoop.
+ *
+ * Interest and readiness are both expressed with the poll(2) flags
+ * (`POLLIN`, `POLLOUT`, `POLLHUP`, `POLLERR`) whatever the backend, so the
+ * loop does not need to know which one it is talking to. Every registered
+ * fd carries an opaque `data` pointer which is handed back untouched in the
+ * ready events, letting the caller dispatch without any fd lookup.
+ */
+class Poller {
+	public:
+		struct Event {
+			void* data;
+			short revents;
+		};
+
+		Poller() = default;
+		Poller(const Poller&) = delete;
+		virtual ~Poller() = default;
+
+		Poller& operator=(const Poller&) = delete;
+
+		virtual void add(int fd, short events, void* data) = 0;
+		virtual void modify(int fd, short events, void* data) = 0;
+		virtual void remove(int fd) = 0;
+
+		/**
+		 * Wait up to `timeoutMs` milliseconds and fill `events` with the fds
+		 * that are ready. Returns the number of ready fds, or -1 on error.
+		 */
+		virtual int wait(std::vector<Event>& events, int timeoutMs) = 0;
+
+		static std::unique_ptr<Poller> create(EventBackend backend);
+};
+
+class PollPoller : public Poller {
+	public:
+		PollPoller() = default;
+		~PollPoller() = default;
+
+		void add(int fd, short events, void* data) override;
+		void modify(int fd, short events, void* data) override;
+		void remove(int fd) override;
+		int wait(std::vector<Event>& events, int timeoutMs) override;
+
+	private:
+		std::vector<struct ::pollfd> _pollFds;
+		std::vector<void*> _dataByIndex;
+		std::unordered_map<int, std::size_t> _indexByFd;
+};
+
+#ifdef __linux__
+class EpollPoller : public Poller {
+	public:
+		EpollPoller();
+		~EpollPoller();
+
+		void add(int fd, short events, void* data) override;
+		void modify(int fd, short events, void* data) override;
+		void remove(int fd) override;
+		int wait(std::vector<Event>& events, int timeoutMs) override;
+
+	private:
+		int _epollFd;
+		std::vector<struct ::epoll_event> _epollEvents;
+};
+#endif
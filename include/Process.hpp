@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+/**
+ * A child process of the server.
+ *
+ * Nothing here waits for the child: once isDone(), the Server reaps it
+ * with WNOHANG, as many times as it takes.
+ */
+class Process {
+	public:
+		Process() = default;
+		Process(const Process&) = delete;
+		virtual ~Process();
+
+		Process& operator=(const Process&) = delete;
+
+		/** True once the server is done with the child, which may then be reaped. */
+		virtual bool isDone() const = 0;
+
+		/** Sends SIGKILL, unless the child was already reaped. */
+		void kill();
+
+		/** Reaps the child without waiting, true once it is gone. */
+		bool reap();
+
+		pid_t getPid() const;
+
+	protected:
+		pid_t _pid { -1 };
+		bool _isReaped { false };
+
+		/**
+		 * Forks and executes `args` in `directory`, with `inputFd` and
+		 * `outputFd` as stdin and stdout unless negative. Throws
+		 * std::runtime_error if the child cannot be forked.
+		 */
+		void _spawn(std::vector<std::string> args, std::vector<std::string> env, const std::string& directory, int inputFd, int outputFd);
+};
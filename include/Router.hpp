@@ -9,6 +9,8 @@
 
 #include "http/index.hpp"
 #include "Config.hpp"
+#include "Cgi.hpp"
+#include "LocationTrie.hpp"
 
 // Forward declaration
 void handleGetRequest(const Location& loc, const std::string& requestPath, http::Request& request, http::Response& response);
@@ -18,6 +20,7 @@ void handleDeleteRequest(const Location& loc, const std::string& requestPath, ht
 class Router {
 	public:
 		using Handler = std::function<void(const Location&, const std::string&, http::Request&, http::Response&)>;
+		using CgiHandler = std::function<void(const Location&, const CgiScript&, http::Request&, http::Response&)>;
 
 		Router(const ServerConfig& serverConfig) : _serverConfig(serverConfig) {
 			addLocations(serverConfig);
@@ -26,6 +29,7 @@ class Router {
 		void get(Handler handler);
 		void post(Handler handler);
 		void del(Handler handler);
+		void cgi(CgiHandler handler);
 		void handle(http::Request& req, http::Response& res);
 
 		void addLocations(const ServerConfig& serverConfig);
@@ -35,7 +39,8 @@ class Router {
 		std::string requestPath;
 
 		std::unordered_map<std::string, Handler> _routes; // method -> handler
-		std::unordered_map<std::string, Location> _locationConfigs; // route -> location config
+		CgiHandler _cgiHandler;
+		LocationTrie _locations; // route -> location config, by longest prefix
 
 		const Location* findBestMatchingLocation(const std::string& url) const;
 };
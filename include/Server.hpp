@@ -9,44 +9,70 @@
 #include <unordered_set>
 #include <algorithm>
 #include <functional>
+#include <memory>
+#include <vector>
 #include <poll.h>
 #include "http/Connection.hpp"
+#include "CgiProcess.hpp"
+#include "CgiWorkerPool.hpp"
+#include "FastCgi.hpp"
 #include "Router.hpp"
 
-struct Process {
-	int pipeFd;
-	int clientFd;
-	bool isPipeClosed { false };
-	pid_t pid;
-};
-
 class Server {
 	public:
 		Server() = default;
-		Server(const ServerConfig& serverConfig);
+		Server(const ServerConfig& serverConfig, bool isReusePort = false);
 		~Server();
 
-		void addClientTo(int serverFd);
+		http::Connection* addClientTo(int serverFd);
 		void close(int fd);
-		void process(int fd, short& events);
-		void sendResponse(int fd, short& events);
+		void process(http::Connection& con, short& events);
+		void sendResponse(http::Connection& con, short& events);
+
+		/** Carries on with a body whose consumer caught up. */
+		void resume(http::Connection& con, short& events);
+
+		/** Gives up on the exchanges of `con` whose phase timed out. */
+		void timeOut(http::Connection& con);
+
+		/**
+		 * Drops a closed client, killing the scripts still running for it,
+		 * and closes its socket, which the event loop must no longer watch.
+		 */
+		void removeClient(int fd);
 
+		/**
+		 * Handles events on a CGI pipe or FastCGI connection, adding the
+		 * clients whose response changed to `clientFds`.
+		 */
+		void processPipe(int fd, short revents, std::vector<int>& clientFds);
+
+		/** Sends the requests waiting for a FastCGI connection or CGI worker that has room again. */
+		void dispatchUpstreams(std::vector<int>& clientFds);
+
+		/**
+		 * Reaps the scripts and workers the server is done with, without
+		 * blocking. Returns true while some of them have not exited yet.
+		 */
+		bool reapProcesses();
+
+		const ServerConfig& getConfig() const;
 		const std::unordered_set<int>& getServerFds() const;
 		std::unordered_map<int, http::Connection>& getClients();
-		std::unordered_map<int, Process>& getPipeProcess();
+		std::unordered_map<int, std::shared_ptr<Upstream>>& getUpstreams();
 
 	private:
 		const ServerConfig& _serverConfig;
 		Router _router;
 		std::unordered_set<int> _serverFds;
 		std::unordered_map<int, http::Connection> _connectionByClientFd;
-		std::unordered_map<int, Process> _processByPipeFd;
-
-		// void _read(struct ::pollfd& pollFd, http::Connection& con);
-		// void _readFromPipe(struct ::pollfd& pollFd, http::Connection& con);
-		// void _readFromSocket(struct ::pollfd& pollFd, http::Connection& con);
-		// void _handle(struct ::pollfd& pollFd, http::Connection& con);
-		// void _cgiHandler(http::Request &req, http::Response &res);
-		void _closePipeFd(int fd);
+		std::unordered_map<int, std::shared_ptr<Upstream>> _upstreamByFd;
+		std::vector<std::shared_ptr<Process>> _processes;
+		std::unordered_map<std::string, std::unique_ptr<FastCgiPool>> _fastCgiPoolByAddress;
+		std::unordered_map<std::string, std::unique_ptr<CgiWorkerPool>> _workerPoolByName;
+
+		void _handleRequests(http::Connection& con, short& events);
+		void _startCgi(const Location& loc, const CgiScript& script, http::Request& req, http::Response& res);
+		void _abortUpstreams(int clientFd);
 		void _cleanup();
 };
@@ -1,11 +1,9 @@
 #pragma once
 
+#include <memory>
 #include <vector>
-#include <functional>
-#include <unordered_set>
-#include <poll.h>
 #include "Config.hpp"
-#include "Server.hpp"
+#include "EventLoop.hpp"
 
 class ServerManager {
 	public:
@@ -16,15 +14,5 @@ class ServerManager {
 
 	private:
 		const Config& _config;
-		std::vector<Server>	_servers;
-		std::vector<struct ::pollfd> _pollFds;
-		std::unordered_map<int, std::size_t> _pollFdIndexByFd;
-		std::unordered_map<int, std::reference_wrapper<Server>> _serverByFd;
-
-		void _addPollFd(int fd, Server& server);
-		void _removePollFd(int fd);
-		void _updatePollFds();
-		void _processPollFds();
-		void _updateClientConnections(Server& server);
-		void _updatePipeConnections(Server& server);
+		std::vector<std::unique_ptr<EventLoop>> _eventLoops;	// One per worker thread
 };
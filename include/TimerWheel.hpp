@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+/**
+ * Hierarchical timing wheel with millisecond ticks.
+ *
+ * Four levels of 64 slots cover deadlines up to 2^24 ms (~4.6 hours) ahead;
+ * longer ones are clamped. A timer sits in the level whose span contains its
+ * deadline and is cascaded into a finer level when its slot comes due, so
+ * arming, re-arming and cancelling are O(1) and expiring costs O(1) per
+ * timer. Occupancy bitmaps make the next deadline cheap to find, which is
+ * what the event loop uses as its wait timeout.
+ *
+ * Timers are intrusive: the owner embeds a Timer and must cancel it before
+ * the Timer is destroyed.
+ */
+class TimerWheel {
+	public:
+		/** The furthest ahead, in ms, a deadline can be; later ones are clamped. */
+		static constexpr std::uint64_t MAX_TIMEOUT_MS = (std::uint64_t { 1 } << 24) - 1;
+
+		struct Timer {
+			Timer* prev { nullptr };
+			Timer* next { nullptr };
+			void* data { nullptr };
+			std::uint64_t expiry { 0 };
+			std::uint16_t slot { 0 };
+
+			Timer() = default;
+			explicit Timer(void* data) : data(data) {}
+			Timer(const Timer&) = delete;
+			Timer& operator=(const Timer&) = delete;
+
+			bool isArmed() const { return next != nullptr; }
+		};
+
+		explicit TimerWheel(std::uint64_t nowMs);
+		TimerWheel(const TimerWheel&) = delete;
+		~TimerWheel() = default;
+
+		TimerWheel& operator=(const TimerWheel&) = delete;
+
+		void schedule(Timer& timer, std::uint64_t expiryMs);
+		void cancel(Timer& timer);
+
+		/**
+		 * Move the wheel forward to `nowMs`, calling `onExpire(timer)` for
+		 * every timer whose deadline has passed. The callback may schedule
+		 * or cancel any timer, including the one it was called for.
+		 */
+		template <typename Callback>
+		void advance(std::uint64_t nowMs, Callback&& onExpire) {
+			while (_currentTick < nowMs) {
+				const std::uint64_t nextTick = _nextEventTick();
+
+				if (nextTick > nowMs) {
+					_currentTick = nowMs;
+					break;
+				}
+
+				_currentTick = nextTick - 1;
+				_step();
+
+				while (_expired.next != &_expired) {
+					Timer& timer = *_expired.next;
+					cancel(timer);
+					onExpire(timer);
+				}
+			}
+		}
+
+		/** Milliseconds until the wheel next needs to advance, -1 if never. */
+		int getTimeout(std::uint64_t nowMs) const;
+		std::size_t size() const;
+
+	private:
+		static constexpr std::size_t LEVELS = 4;
+		static constexpr std::size_t SLOT_BITS = 6;
+		static constexpr std::size_t SLOTS = 1 << SLOT_BITS;
+		static constexpr std::uint64_t SLOT_MASK = SLOTS - 1;
+		static_assert(MAX_TIMEOUT_MS == (std::uint64_t { 1 } << (LEVELS * SLOT_BITS)) - 1, "The wheel spans MAX_TIMEOUT_MS");
+		static constexpr std::uint16_t EXPIRED_SLOT = LEVELS * SLOTS;
+		static constexpr std::uint64_t NEVER = std::numeric_limits<std::uint64_t>::max();
+
+		std::uint64_t _currentTick;
+		std::size_t _size { 0 };
+		std::array<std::array<Timer, SLOTS>, LEVELS> _slots;
+		std::array<std::uint64_t, LEVELS> _occupied {};
+		Timer _expired;
+
+		Timer& _listOf(std::uint16_t slot);
+		void _place(Timer& timer);
+		void _cascade(std::size_t level, std::size_t index);
+		void _step();
+		std::uint64_t _nextEventTick() const;
+};
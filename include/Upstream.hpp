@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+
+/**
+ * A source of responses the event loop polls on behalf of a Server: the
+ * pipes of a CGI process or a connection to a FastCGI server.
+ *
+ * The event loop only closes an fd once isPipeOpen() turned false for it,
+ * after a round of events, so no ready event can refer to a handle that
+ * is gone or to an fd number reused in the meantime.
+ */
+class Upstream {
+	public:
+		virtual ~Upstream() = default;
+
+		/** What to poll `fd` for. */
+		virtual short getEvents(int fd) const = 0;
+
+		/** False once `fd` is done with and may be closed. */
+		virtual bool isPipeOpen(int fd) const = 0;
+
+		virtual void closePipe(int fd) = 0;
+
+		/** Handles `revents` on `fd`, adding the clients whose response changed to `clientFds`. */
+		virtual void process(int fd, short revents, std::vector<int>& clientFds) = 0;
+
+		/** Lets go of the exchanges of a client that timed out or went away. */
+		virtual void abort(int clientFd) = 0;
+};
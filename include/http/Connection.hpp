@@ -1,41 +1,105 @@
 #pragma once
 
 #include <vector>
-#include <queue>
+#include <list>
 #include <utility>
-#include <chrono>
 #include <functional>
+#include <memory>
 #include "Request.hpp"
 #include "Response.hpp"
+#include "parser.hpp"
 #include "Config.hpp"
+#include "utils/ReceiveBuffer.hpp"
 
 namespace http {
+	/**
+	 * A client connection and its queue of exchanges.
+	 *
+	 * Pipelined requests are parsed as soon as they are buffered, up to
+	 * MAX_PIPELINE_DEPTH at a time, and the ready responses at the head of
+	 * the queue are written together with a single sendmsg().
+	 *
+	 * A request with a body is queued as soon as its header is parsed, and
+	 * its body handed over while it is received. The next request is only
+	 * parsed once the body is complete, and nothing is read from the client
+	 * while the body's consumer is behind, or while its receive buffer of
+	 * `client_buffer_size` bytes is full of requests waiting their turn.
+	 *
+	 * Exchanges are recycled rather than freed: a sent one is cleared in one
+	 * go and spliced onto a list of spares kept by the thread, from which
+	 * the next request parsed by any of its connections is queued. With its
+	 * header block borrowed from a pool as well, a request in the steady
+	 * state is received and queued without allocating.
+	 */
 	class Connection {
 		public:
+			static constexpr std::size_t MAX_PIPELINE_DEPTH = 16;
+			static constexpr std::size_t MAX_SPARE_EXCHANGES = 1024;	// Per thread
+
+			using Exchange = std::pair<Request, Response>;
+
+			enum class Phase : uint8_t {
+				IDLE,			// Kept alive, waiting for the next request.
+				READING_HEADER,	// Receiving the request line and header fields.
+				READING_BODY,	// Receiving the request body.
+				HANDLING,		// The response is being produced.
+				SENDING			// The response is being sent.
+			};
+
 			Connection(int clientSocket, const ServerConfig& serverConfig);
-			Connection(const Connection&) = default;
+			Connection(const Connection&) = delete;
 			~Connection() = default;
 
-			Connection& operator=(const Connection&) = default;
+			Connection& operator=(const Connection&) = delete;
 
 			void read();
 			bool sendResponse();
 			void close();
+			void timeOut();
 
 			bool isClosed() const;
-			bool isTimedOut() const;
+
+			/** False while the body being received waits for its consumer. */
+			bool canRead() const;
+
+			/** Takes in what is buffered, once the body's consumer caught up. */
+			void resume();
+
+			/** True once the body being received turned out bad. */
+			bool hasBadBody() const;
+
+			/**
+			 * Fails the body being received and answers its exchange with
+			 * `code`, or closes the connection if that is no longer possible.
+			 */
+			void rejectBody(StatusCode code);
+
+			int getClientSocket() const;
+			Phase getPhase() const;
 
 			Request* getRequest();
 			Response* getResponse();
 
+			/** The oldest queued exchange whose response is not yet produced. */
+			Exchange* getPendingExchange();
+			bool hasReadyResponse() const;
+
 		private:
 			int _clientSocket;
+			bool _isClosed { false };
 			const ServerConfig& _serverConfig;
 			Request _request { Request::Status::PENDING };
-			std::vector<std::uint8_t> _buffer;
-			std::queue<std::pair<Request, Response>> _queue;
-			std::chrono::steady_clock::time_point _lastReceived;
+			RequestParser _parser;
+			utils::ReceiveBuffer _buffer;
+			std::list<Exchange> _queue;
+			std::shared_ptr<RequestBody> _body;
+			ChunkDecoder _chunkDecoder;
 
+			void _queueRequest();
 			void _processBuffer();
+			void _processPipeline();
+			void _processBody();
+			void _releaseBuffer();
+			void _finishResponse();
 	};
 }
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace http {
+	/**
+	 * File extensions and MIME types, looked up either way.
+	 *
+	 * The built-in types are a constexpr table, sorted at compile time once
+	 * by extension and once by type, and copied into the registry as they
+	 * are; the `types` block of the config is merged into the same sorted
+	 * tables at startup. A lookup is then a binary search comparing bytes
+	 * in place, ignoring case, and returns a view of the table's storage.
+	 *
+	 * A type with several extensions is saved under the first one listed,
+	 * e.g. "html" rather than "htm". The registry is only modified before
+	 * the worker threads start, and only read afterwards.
+	 */
+	class MimeTypes {
+		public:
+			static constexpr std::string_view DEFAULT_TYPE = "text/plain; charset=utf-8";
+			static constexpr std::string_view DEFAULT_EXTENSION = "bin";
+
+			/** The registry used by the server. */
+			static MimeTypes& global();
+
+			MimeTypes();
+			MimeTypes(const MimeTypes&) = delete;
+			MimeTypes& operator=(const MimeTypes&) = delete;
+
+			/** Maps `extensions` to `type`, the first one becoming its extension. */
+			void add(std::string_view type, const std::vector<std::string>& extensions);
+
+			/** The type of files ending in `.extension`, or DEFAULT_TYPE. */
+			std::string_view typeOf(std::string_view extension) const;
+
+			/** The extension, without a dot, for `type` with or without parameters, or DEFAULT_EXTENSION. */
+			std::string_view extensionOf(std::string_view type) const;
+
+		private:
+			struct Entry {
+				std::string_view key;
+				std::string_view value;
+			};
+
+			std::vector<Entry> _typeByExtension;
+			std::vector<Entry> _extensionByType;
+			std::deque<std::string> _names;		// Storage of the added names, which never moves
+
+			std::string_view _store(std::string_view name);
+	};
+}
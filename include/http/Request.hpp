@@ -1,16 +1,33 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 
 #include "data_types.hpp"
 #include "constants.hpp"
 #include "utils.hpp"
+#include "RequestBody.hpp"
+#include "utils/SlabPool.hpp"
 
 namespace http {
+	/**
+	 * The request line and header fields are views into a header block owned
+	 * by the request, filled by the parser through `storeHeaderBytes()`. The
+	 * block is a MAX_REQUEST_HEADER_SIZE slab borrowed from the pool on the
+	 * first store and given back by `clear()`; it never moves or grows, so
+	 * the views stay valid until then and survive moving the request. Known
+	 * headers live in a flat table indexed by `Header`.
+	 *
+	 * Requests are move-only: a copy would point into the original's block.
+	 *
+	 * A request with a body is handled as soon as its header is complete,
+	 * the body arriving afterwards through `getBody()`.
+	 */
 	class Request {
 		public:
 			enum class Status : uint8_t {
@@ -22,57 +39,60 @@ namespace http {
 
 			Request() = default;
 			explicit Request(Status status);
-			Request(const Request&) = default;
-			Request(Request&&) noexcept = default;
-			~Request() = default;
-			Request& operator=(const Request&) = default;
-			Request& operator=(Request&&) noexcept = default;
+			Request(const Request&) = delete;
+			Request(Request&& other) noexcept;
+			~Request();
+			Request& operator=(const Request&) = delete;
+			Request& operator=(Request&& other) noexcept;
 
 			void clear();
 
 			bool isChunkEncoding() const;
 			bool isMultipart() const;
 
-			const std::string& getMethod() const;
-			const std::string& getUri() const;
+			/** Whether a body follows the header, by Content-Length or chunks. */
+			bool hasBody() const;
+
+			std::string_view getMethod() const;
+			std::string_view getUri() const;
 			const Url& getUrl() const;
-			const std::string& getVersion() const;
-			std::string getBoundary() const;
+			std::string_view getVersion() const;
+			std::string_view getBoundary() const;
 			std::size_t getContentLength() const;
-			std::optional<std::string> getHeader(Header header) const;
-			const std::vector<std::uint8_t>& getRawBody() const;
+			std::optional<std::string_view> getHeader(Header header) const;
 			// MultipartFile getMultipartBody() const;
+
+			/** The body being received, null for a request without one. */
+			const std::shared_ptr<RequestBody>& getBody() const;
 			Request::Status getStatus() const;
 
-			Request& setRawBody(
-				std::vector<uint8_t>::const_iterator begin,
-				std::vector<uint8_t>::const_iterator end,
-				bool append
-			);
+			/** Copies `bytes` into the header block and returns the copy. */
+			std::string_view storeHeaderBytes(std::string_view bytes);
 
-			Request& setRawBody(
-				std::move_iterator<std::vector<uint8_t>::iterator> begin,
-				std::move_iterator<std::vector<uint8_t>::iterator> end,
-				bool append
-			) noexcept;
+			Request& setBody(std::shared_ptr<RequestBody> body);
 
+			// The views passed to the setters must outlive the request,
+			// which holds for the header block and string literals.
 			Request& setContentLength(std::size_t bytes);
-			Request& setHeader(const std::string& name, const std::string& value);
-			Request& setHeader(Header header, const std::string& value);
-			Request& setMethod(const std::string& method);
-			Request& setUri(const std::string& uri);
+			Request& setHeader(Header header, std::string_view value);
+			Request& setMethod(std::string_view method);
+			Request& setUri(std::string_view uri);
 			Request& setStatus(Request::Status status);
 			Request& setUrl(const Url& url);
-			Request& setVersion(const std::string& version);
+			Request& setVersion(std::string_view version);
 
 		private:
-			std::string _method;
-			std::string _uri;
-			std::string _version;
+			static constexpr std::size_t HEADER_COUNT = static_cast<std::size_t>(Header::LENGTH);
+
+			utils::SlabPool::Slab _headerBlock;
+			std::size_t _headerSize { 0 };
+			std::string_view _method;
+			std::string_view _uri;
+			std::string_view _version;
 			Url _url;
-			std::unordered_map<std::string, std::string> _headerFields;
+			std::array<std::optional<std::string_view>, HEADER_COUNT> _headerFields;
 			std::size_t _contentLength { 0 };
-			std::vector<std::uint8_t> _rawBody;
+			std::shared_ptr<RequestBody> _body;
 			Request::Status _status { Request::Status::PENDING };
 	};
 }
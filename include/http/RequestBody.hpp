@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace http {
+	/**
+	 * The body of a request, handed to its consumer while it is received.
+	 *
+	 * The connection appends the decoded bytes as they come in and stops
+	 * reading from the client once MAX_BUFFERED bytes are waiting, which
+	 * holds the client back through TCP flow control until the consumer
+	 * catches up. A consumer either pulls the bytes when it can take them,
+	 * as the CGI upstreams do, or is pushed them by `setConsumer()`.
+	 *
+	 * The body is shared by the request and the connection receiving it, so
+	 * that one no longer wanted by anyone can be discarded as it arrives.
+	 * It keeps its own framing for that, a Content-Length or chunks.
+	 */
+	class RequestBody {
+		public:
+			// Bytes waiting for the consumer before the client is not read from
+			static constexpr std::size_t MAX_BUFFERED = 64 * 1024;
+
+			// The length of a chunked body, known once its last chunk arrived
+			static constexpr std::size_t UNKNOWN_LENGTH = SIZE_MAX;
+
+			using Consumer = std::function<void(RequestBody&)>;
+
+			explicit RequestBody(std::size_t length = UNKNOWN_LENGTH);
+			RequestBody(const RequestBody&) = delete;
+			RequestBody& operator=(const RequestBody&) = delete;
+
+			/** The bytes received and not yet consumed. */
+			const std::uint8_t* data() const;
+			std::size_t size() const;
+
+			void consume(std::size_t size);
+
+			/**
+			 * Calls `consumer` whenever bytes were appended, and a last time
+			 * once the body is complete or failed, after which it is dropped.
+			 * It is called right away if bytes are already waiting.
+			 */
+			void setConsumer(Consumer consumer);
+
+			/** Lifts the bound, for a consumer that needs the whole body first. */
+			void gather();
+
+			void append(const std::uint8_t* data, std::size_t size);
+			void complete();
+			void fail();
+
+			/** True while the consumer has not caught up with the bound. */
+			bool isFull() const;
+
+			/** True once every byte was received. */
+			bool isComplete() const;
+
+			/** True once complete and consumed. */
+			bool isDrained() const;
+
+			/** True if the body was cut short, by a timeout or a bad chunk. */
+			bool isFailed() const;
+
+			/** Bytes received so far, consumed or not. */
+			std::size_t getReceived() const;
+
+			/** The Content-Length, or UNKNOWN_LENGTH for a chunked body. */
+			std::size_t getLength() const;
+
+		private:
+			std::vector<std::uint8_t> _buffer;
+			std::size_t _length;
+			std::size_t _offset { 0 };
+			std::size_t _received { 0 };
+			std::size_t _limit { MAX_BUFFERED };
+			bool _isComplete { false };
+			bool _isFailed { false };
+			Consumer _consumer;
+
+			void _notify();
+	};
+}
@@ -1,13 +1,25 @@
 #pragma once
 
+#include <bitset>
 #include <string>
+#include <string_view>
+#include <map>
 #include <memory>
-#include <unordered_map>
 #include <filesystem>
 #include "constants.hpp"
 #include "utils/Payload.hpp"
 
 namespace http {
+	class Request;
+
+	/**
+	 * The header fields are kept serialized, "Name: value\r\n" after one
+	 * another in the order they were first set, in a buffer that keeps its
+	 * capacity when the response is cleared for reuse. `build()` writes the
+	 * precomputed status line, the cached Date field, the fields and the
+	 * final CRLF straight into the header payload's own buffer, so a
+	 * recycled response is serialized without allocating.
+	 */
 	class Response {
 		public:
 			enum class Status : uint8_t {
@@ -17,14 +29,38 @@ namespace http {
 			};
 
 			Response(int clientSocket);
-			Response(const Response& other);
+			Response(const Response&) = delete;
 			Response(Response&&) noexcept = default;
 			~Response() = default;
 
-			Response& operator=(const Response& other);
+			Response& operator=(const Response&) = delete;
+			Response& operator=(Response&&) noexcept = default;
 
 			bool send();
 
+			/**
+			 * Appends the unsent part of the response to `iovecs`. Returns
+			 * false when the body is a file, which is left to send().
+			 */
+			bool gather(std::vector<iovec>& iovecs) const;
+
+			/** Marks up to `bytes` as sent, header first, and returns how many were used. */
+			std::size_t consume(std::size_t bytes);
+
+			bool isSent() const;
+
+			/** False while the body is still being produced, e.g. by a CGI script. */
+			bool isComplete() const;
+
+			bool hasPendingBytes() const;
+
+			/**
+			 * Marks the body as cut short once the header is out: the client
+			 * can only tell from the connection closing after what was sent.
+			 */
+			void abort();
+			bool isAborted() const;
+
 			void build();
 
 			int getClientSocket() const;
@@ -33,22 +69,51 @@ namespace http {
 			const utils::StringPayload& getHeader() const;
 			const std::unique_ptr<utils::Payload>& getBody() const;
 
+			/** Makes it a pending response again, keeping its storage for reuse. */
 			Response& clear();
+			Response& setClientSocket(int clientSocket);
 			Response& setStatus(const Status status);
 			Response& setStatusCode(const StatusCode statusCode);
-			Response& setHeader(Header header, const std::string& value);
+			/** Sets a field, replacing the value it had, if any, in place of its line. */
+			Response& setHeader(Header header, std::string_view value);
+			Response& setHeader(std::string_view name, std::string_view value);
 			Response& setBody(std::unique_ptr<utils::Payload> body);
 			Response& appendBody(const std::uint8_t* data, size_t size);
 
 			void setText(StatusCode statusCode, const std::string& text);
 			void setFile(StatusCode statusCode, const std::filesystem::path &filePath);
 
+			/**
+			 * Fields set before are sent ahead of the file's own and are not
+			 * kept with it in the ResponseCache. Without a Cache-Control among
+			 * them, the response is not to be stored.
+			 */
+			void setFile(StatusCode statusCode, std::shared_ptr<const utils::CachedFile> file);
+
+			/**
+			 * Answers a GET for a static file with its validators and
+			 * `cacheControl`: a bodiless 304 when the request's If-None-Match,
+			 * or else If-Modified-Since, shows the client has it already
+			 * (RFC 9110, 13.2.2), the file otherwise.
+			 */
+			void setResource(const Request& request, std::shared_ptr<const utils::CachedFile> file, std::string_view cacheControl);
+
+			/** The configured error page for `statusCode`, or its reason phrase as text. */
+			void setError(StatusCode statusCode, const std::map<int, std::string>& errorPages);
+
 		private:
 			int _clientSocket;
 			Status _status { Status::PENDING };
 			StatusCode _statusCode { StatusCode::NONE_0 };
-			std::unordered_map<std::string, std::string> _headerByName;
+			bool _isAborted { false };
+			std::string _fields;
+			std::bitset<static_cast<std::size_t>(Header::LENGTH)> _knownFields;	// Known headers set in _fields
 			utils::StringPayload _header;
 			std::unique_ptr<utils::Payload> _body;
+
+			void _buildHead();
+			void _appendField(std::string_view name, std::string_view value);
+			void _eraseField(std::string_view name);
+			void _appendHeader(std::string_view bytes);
 	};
 }
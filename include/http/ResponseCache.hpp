@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "constants.hpp"
+#include "utils/FileCache.hpp"
+
+namespace http {
+	/**
+	 * Cache of responses (header fields and body in one buffer, everything
+	 * after the status line and Date field) for small files and error pages,
+	 * bounded by total size with LRU eviction. A hit is handed to the
+	 * response as a shared buffer, so every connection sending it shares
+	 * one copy.
+	 *
+	 * Entries are keyed by path and status code and remember the identity of
+	 * the file they were built from; once the FileCache sees the file change,
+	 * the next lookup misses and the entry is rebuilt. Each worker thread has
+	 * its own cache.
+	 */
+	class ResponseCache {
+		public:
+			static constexpr std::size_t DEFAULT_CAPACITY = 16 * 1024 * 1024;
+			static constexpr std::size_t DEFAULT_MAX_FILE_SIZE = 64 * 1024;
+
+			ResponseCache() = default;
+			ResponseCache(const ResponseCache&) = delete;
+			~ResponseCache() = default;
+
+			ResponseCache& operator=(const ResponseCache&) = delete;
+
+			static ResponseCache& local();
+
+			/** A capacity of 0 disables the cache. */
+			void configure(std::size_t capacity, std::size_t maxFileSize);
+
+			bool isCacheable(const utils::CachedFile& file) const;
+
+			std::shared_ptr<const std::string> find(const utils::CachedFile& file, StatusCode statusCode);
+
+			/** Stores `header` followed by the content of `file` and returns it. */
+			std::shared_ptr<const std::string> insert(
+				const utils::CachedFile& file,
+				StatusCode statusCode,
+				std::string_view header
+			);
+
+			void clear();
+			std::size_t size() const;
+			std::size_t getSizeInBytes() const;
+
+		private:
+			struct Key {
+				std::string_view path;
+				StatusCode statusCode;
+
+				bool operator==(const Key&) const = default;
+			};
+
+			struct KeyHash {
+				std::size_t operator()(const Key& key) const;
+			};
+
+			struct Entry {
+				std::string path;	// Owns the text `Key::path` refers to
+				StatusCode statusCode;
+				dev_t device;
+				ino_t inode;
+				timespec mtime;
+				std::size_t fileSize;
+				std::shared_ptr<const std::string> response;
+			};
+
+			using LruList = std::list<Entry>;
+
+			std::size_t _capacity { DEFAULT_CAPACITY };
+			std::size_t _maxFileSize { DEFAULT_MAX_FILE_SIZE };
+			std::size_t _sizeInBytes { 0 };
+			LruList _lru;	// Most recently used first
+			std::unordered_map<Key, LruList::iterator, KeyHash> _entryByKey;
+
+			void _erase(LruList::iterator it);
+	};
+}
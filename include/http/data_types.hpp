@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <cstdint>
 
@@ -18,16 +19,18 @@ namespace http {
 	 * - query = `search=apple&limit=10`
 	 * - fragment = `section2`
 	 *
+	 * The components are views into the parsed text, normally the header
+	 * block of the request, and are only valid as long as it is.
 	*/
 	struct Url {
-		std::string scheme;
-        std::string user;
-        std::string password;
-        std::string host;
-        std::string port;
-        std::string path;
-        std::string query;
-        std::string fragment;
+		std::string_view scheme;
+        std::string_view user;
+        std::string_view password;
+        std::string_view host;
+        std::string_view port;
+        std::string_view path;
+        std::string_view query;
+        std::string_view fragment;
 
 		Url() = default;
 		Url(const Url&) = default;
@@ -39,6 +42,5 @@ namespace http {
 		std::string name;
 		std::string fileName;
 		std::string contentType;
-		std::vector<uint8_t> rawData;
 	};
 }
\ No newline at end of file
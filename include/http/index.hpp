@@ -3,6 +3,7 @@
 #include "constants.hpp"
 #include "data_types.hpp"
 #include "utils.hpp"
+#include "MimeTypes.hpp"
 #include "Request.hpp"
 #include "Response.hpp"
 #include "Connection.hpp"
@@ -1,18 +1,156 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <array>
+#include <functional>
 #include <vector>
 #include <unordered_map>
 
 #include "data_types.hpp"
 #include "Request.hpp"
+#include "utils/ReceiveBuffer.hpp"
 
 namespace http {
-	Url parseUrl(const std::string& fullUrl);
+	/**
+	 * Incremental parser for the request line and header fields.
+	 *
+	 * Each call only looks at the bytes appended to the buffer since the
+	 * previous one, so a header arriving over many reads is scanned exactly
+	 * once. Once the empty line ending the header is found, the header bytes
+	 * are consumed from the buffer, the request becomes HEADER_COMPLETE and
+	 * the parser is ready for the next request.
+	 *
+	 * Throws std::invalid_argument on a malformed or oversized header.
+	 */
+	class RequestParser {
+		public:
+			enum class State : uint8_t {
+				REQUEST_LINE,	// Waiting for the request line.
+				HEADER_FIELDS	// Reading header field lines until an empty one.
+			};
 
-	void parseRequestHeader(std::vector<uint8_t>& buffer, Request& request);
-	void parseRequestBody(std::vector<uint8_t>& buffer, Request& request, std::size_t clientMaxBodySize);
+			RequestParser() = default;
 
-	std::vector<MultipartElement> parseMultipart(const std::vector<uint8_t>& rawMultipart, const std::string& boundary);
+			void parseHeader(utils::ReceiveBuffer& buffer, Request& request);
+			void reset();
+
+		private:
+			State _state { State::REQUEST_LINE };
+			std::size_t _lineStart { 0 };	// Offset of the first byte of the current line
+			std::size_t _scanned { 0 };		// Bytes already searched for a line feed
+
+			void _parseRequestLine(std::string_view line, Request& request);
+			void _parseHeaderField(std::string_view line, Request& request);
+			void _finish(Request& request);
+	};
+
+	/**
+	 * Incremental parser for a multipart/form-data body (RFC 7578).
+	 *
+	 * The body is handed over as it arrives, and the content of each part
+	 * is passed on as soon as it is known not to be part of a boundary, so
+	 * nothing but the header fields of a part is ever held. `parse()` takes
+	 * what it can and returns how much that was; the rest, a partial
+	 * boundary or header, is to be passed again with the bytes after it.
+	 *
+	 * Throws std::invalid_argument on a malformed boundary line or part
+	 * header, or one longer than MAX_HEADER_SIZE.
+	 */
+	class MultipartParser {
+		public:
+			static constexpr std::size_t MAX_HEADER_SIZE = 8 * 1024;
+
+			enum class State : uint8_t {
+				PREAMBLE,		// Before the first boundary, ignored.
+				BOUNDARY,		// After a boundary: another part follows, or the end.
+				PART_HEADER,	// Reading the header fields of a part.
+				PART_DATA,		// Passing on the content of a part.
+				EPILOGUE		// After the final boundary, ignored.
+			};
+
+			using PartHandler = std::function<void(const MultipartElement& part)>;
+			using DataHandler = std::function<void(const std::uint8_t* data, std::size_t size)>;
+			using EndHandler = std::function<void()>;
+
+			MultipartParser(std::string_view boundary, PartHandler onPart, DataHandler onData, EndHandler onPartEnd);
+
+			std::size_t parse(const std::uint8_t* data, std::size_t size);
+
+			/** True once the final boundary was parsed. */
+			bool isComplete() const;
+
+		private:
+			State _state { State::PREAMBLE };
+			bool _isAtStart { true };
+			std::string _delimiter;		// CRLF, "--" and the boundary
+			PartHandler _onPart;
+			DataHandler _onData;
+			EndHandler _onPartEnd;
+
+			std::size_t _parseStep(const std::uint8_t* data, std::size_t size);
+			std::size_t _parsePreamble(const std::uint8_t* data, std::size_t size);
+			std::size_t _parseBoundary(const std::uint8_t* data, std::size_t size);
+			std::size_t _parsePartHeader(const std::uint8_t* data, std::size_t size);
+			std::size_t _parsePartData(const std::uint8_t* data, std::size_t size);
+	};
+
+	Url parseUrl(std::string_view fullUrl);
+
+	/**
+	 * Resumable decoder for a chunked body (RFC 9112, 7.1).
+	 *
+	 * The framing is parsed a byte at a time, so a chunk size line, a CRLF
+	 * or the trailer section may be split across reads anywhere, while the
+	 * data of a chunk is appended to the body as it arrives, without waiting
+	 * for the rest of the chunk. `decode()` takes what it can and returns how
+	 * much that was, stopping once the body is full or complete; nothing is
+	 * ever held back, so the bytes it did not take are the ones to pass again.
+	 *
+	 * Chunk extensions and trailer fields are ignored.
+	 *
+	 * Throws std::invalid_argument on a malformed chunk, a size line or
+	 * trailer section longer than MAX_LINE_SIZE, or chunks adding up to
+	 * `maxBodySize`.
+	 */
+	class ChunkDecoder {
+		public:
+			static constexpr std::size_t MAX_LINE_SIZE = 4 * 1024;
+
+			enum class State : uint8_t {
+				SIZE,			// The hex digits of the chunk size.
+				EXTENSION,		// Chunk extensions, up to the end of the size line.
+				SIZE_LF,		// The line feed ending the size line.
+				DATA,			// The data of the chunk.
+				DATA_CR,		// The CRLF after it.
+				DATA_LF,
+				TRAILER,		// At the start of a trailer line, or of the empty one.
+				TRAILER_FIELD,	// Within a trailer field line.
+				TRAILER_LF,		// The line feed ending the chunked body.
+				DONE
+			};
+
+			explicit ChunkDecoder(std::size_t maxBodySize = SIZE_MAX);
+
+			std::size_t decode(const std::uint8_t* data, std::size_t size, RequestBody& body);
+
+			/** True once the last chunk and the trailer section were parsed. */
+			bool isComplete() const;
+
+		private:
+			State _state { State::SIZE };
+			std::size_t _maxBodySize;
+			std::size_t _remaining { 0 };	// Bytes of the current chunk still to come
+			std::size_t _lineSize { 0 };	// Bytes of the size line, or trailer section, so far
+
+			void _parseFraming(std::uint8_t byte, const RequestBody& body);
+	};
+
+	/**
+	 * Moves the body bytes at the front of `data` into `body`, through
+	 * `decoder` for a chunked one, and completes the body once all of it
+	 * arrived. Returns how many bytes were taken, none once the body is
+	 * full. Throws std::invalid_argument on a bad chunk.
+	 */
+	std::size_t parseRequestBody(const std::uint8_t* data, std::size_t size, RequestBody& body, ChunkDecoder& decoder);
 }
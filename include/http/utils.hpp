@@ -1,16 +1,29 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <optional>
 #include <array>
 #include <unordered_map>
 #include "constants.hpp"
 
 namespace http {
-	std::string getMimeType(const std::string &extension);
-	std::string getExtensionFromMimeType(const std::string& mime);
-	std::string stringOf(Header header);
-	std::string stringOf(StatusCode code);
+	/** The MIME type of files ending in `.extension`, from MimeTypes::global(). */
+	std::string_view getMimeType(std::string_view extension);
 
-	bool hasHeaderName(const std::string &headerName);
-	bool isValidHeaderField(const std::string &headerField);
+	/** The extension, without a dot, to save a body of type `mime` under. */
+	std::string_view getExtensionFromMimeType(std::string_view mime);
+
+	std::string_view stringOf(Header header);
+
+	/** The reason phrase of `code`, "Unknown" if it has none. */
+	std::string_view stringOf(StatusCode code);
+
+	/** "HTTP/1.1 <code> <reason>\r\n", precomputed, or empty for a code without a reason phrase. */
+	std::string_view statusLineOf(StatusCode code);
+
+	std::optional<Header> findHeader(std::string_view headerName);
+	bool hasHeaderName(std::string_view headerName);
+	bool isToken(std::string_view value);
+	bool isValidHeaderField(std::string_view headerField);
 }
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <optional>
+#include <string_view>
+
+namespace utils {
+	/**
+	 * The time as of the current event-loop iteration, read once per
+	 * iteration by the loop instead of by everything that needs it.
+	 *
+	 * It also keeps the current date preformatted for the Date field
+	 * (RFC 9110, 6.6.1), formatted again only when the second changes, so
+	 * that responses copy it in as it is. Each worker thread has its own.
+	 */
+	class CoarseClock {
+		public:
+			using Clock = std::chrono::steady_clock;
+			using HttpDate = std::array<char, 29>;	// "Sun, 06 Nov 1994 08:49:37 GMT"
+
+			CoarseClock();
+			CoarseClock(const CoarseClock&) = delete;
+			~CoarseClock() = default;
+
+			CoarseClock& operator=(const CoarseClock&) = delete;
+
+			static CoarseClock& local();
+
+			/** The IMF-fixdate (RFC 9110, 5.6.7) of `time`. */
+			static HttpDate formatHttpDate(std::time_t time);
+
+			/** The time of an IMF-fixdate, or nothing for any other text. */
+			static std::optional<std::time_t> parseHttpDate(std::string_view date);
+
+			/** Reads the clocks again, once per event-loop iteration. */
+			void update();
+
+			Clock::time_point now() const;
+			std::uint64_t nowMs() const;
+
+			/** The wall-clock second the current date is for. */
+			std::time_t wallTime() const;
+
+			/** The current date as an IMF-fixdate, to the second. */
+			std::string_view httpDate() const;
+
+		private:
+			Clock::time_point _now;
+			std::time_t _dateTime { -1 };
+			HttpDate _date {};
+	};
+}
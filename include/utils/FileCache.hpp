@@ -0,0 +1,103 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <sys/types.h>
+
+namespace utils {
+	/**
+	 * An opened file or a directory, with the metadata needed to answer for
+	 * it. The fd is closed when the last owner (the cache or a payload still
+	 * sending it) lets go, so eviction never cuts a transfer short.
+	 */
+	struct CachedFile {
+		enum class Type : uint8_t {
+			FILE,
+			DIRECTORY
+		};
+
+		std::filesystem::path path;
+		Type type { Type::FILE };
+		int fd { -1 };			// Only open for FILE
+		std::size_t size { 0 };
+		timespec mtime {};
+		dev_t device { 0 };
+		ino_t inode { 0 };
+		std::string_view mimeType;	// Viewed in http::MimeTypes::global()
+		std::string contentLength;
+		std::string entityTag;		// W/"inode-size-mtime", the strong ETag without the W/
+		std::string lastModified;	// mtime as an HTTP date
+
+		CachedFile() = default;
+		CachedFile(const CachedFile&) = delete;
+		~CachedFile();
+
+		CachedFile& operator=(const CachedFile&) = delete;
+
+		bool isDirectory() const;
+	};
+
+	/**
+	 * Bounded LRU cache of opened files and directories, keyed by path.
+	 *
+	 * An entry is trusted for `validity` after it was last checked, as told
+	 * by the event loop's CoarseClock; after that, the next lookup stat()s
+	 * the path and reopens it if the size, mtime or inode changed. Each
+	 * worker thread has its own cache, so lookups take no locks.
+	 */
+	class FileCache {
+		public:
+			static constexpr std::size_t DEFAULT_CAPACITY = 1000;
+			static constexpr std::size_t DEFAULT_VALIDITY_MS = 1000;
+
+			FileCache() = default;
+			FileCache(const FileCache&) = delete;
+			~FileCache() = default;
+
+			FileCache& operator=(const FileCache&) = delete;
+
+			static FileCache& local();
+
+			/** A capacity of 0 disables caching; lookups still work. */
+			void configure(std::size_t capacity, std::size_t validityMs);
+
+			/**
+			 * Returns the file or directory at `path`, or nullptr if there is
+			 * none. Throws std::ios_base::failure if it exists but cannot be
+			 * opened.
+			 */
+			std::shared_ptr<const CachedFile> find(const std::filesystem::path& path);
+
+			/** Like find(), but throws FileNotFoundException when missing. */
+			std::shared_ptr<const CachedFile> open(const std::filesystem::path& path);
+
+			void clear();
+			std::size_t size() const;
+
+		private:
+			using Clock = std::chrono::steady_clock;
+
+			struct Entry {
+				std::shared_ptr<const CachedFile> file;
+				Clock::time_point validatedAt;
+			};
+
+			using LruList = std::list<std::pair<std::string, Entry>>;
+
+			std::size_t _capacity { DEFAULT_CAPACITY };
+			Clock::duration _validity { std::chrono::milliseconds(DEFAULT_VALIDITY_MS) };
+			LruList _lru;	// Most recently used first
+			std::unordered_map<std::string, LruList::iterator> _entryByPath;
+
+			int _open(const std::filesystem::path& path);
+			void _insert(const std::string& key, std::shared_ptr<const CachedFile> file, Clock::time_point now);
+			void _erase(LruList::iterator it);
+	};
+}
@@ -4,25 +4,46 @@
 #include <string.h>
 #include <filesystem>
 #include <fstream>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include <sys/uio.h>
+#include "FileCache.hpp"
 
 namespace utils {
 	class Payload {
 		public:
 			explicit Payload(int socket);
-			Payload(const Payload&) = default;
-			Payload(Payload &&) noexcept = default;
+			Payload(const Payload&) = delete;
+			Payload(Payload&&) noexcept = default;
 			virtual ~Payload() = default;
 
-			Payload& operator=(const Payload&) = default;
+			Payload& operator=(const Payload&) = delete;
+			Payload& operator=(Payload&&) noexcept = default;
 
 			virtual void send() = 0;
 			virtual void append(const std::uint8_t* data, size_t size) = 0;
 			virtual std::string toString() const = 0;
-			virtual std::unique_ptr<Payload> clone() const = 0;
 
-			bool isSent() const;
+			/**
+			 * Appends the unsent bytes to `iovecs` for a vectored send. Returns
+			 * false, adding nothing, when they are not in memory (a file).
+			 */
+			virtual bool gather(std::vector<iovec>& iovecs) const;
+
+			/** Marks up to `bytes` as sent and returns how many were used. */
+			std::size_t consume(std::size_t bytes);
+
+			virtual bool isSent() const;
+
+			/** False while more bytes may still be appended, e.g. a CGI output stream. */
+			virtual bool isComplete() const;
+
+			bool hasPendingBytes() const;
 			std::size_t getSizeInBytes() const;
 
+			void setSocket(int socket);
+
 		protected:
 			int _socket;
 			std::size_t _totalBytes { 0 };
@@ -32,39 +53,124 @@ namespace utils {
 	class StringPayload : public Payload {
 		public:
 			StringPayload(int socket, const std::string &message);
-			StringPayload(const StringPayload&) = default;
-			StringPayload(StringPayload &&) noexcept = default;
+			StringPayload(const StringPayload&) = delete;
+			StringPayload(StringPayload&&) noexcept = default;
 			~StringPayload() = default;
 
-			StringPayload& operator=(const StringPayload&) = default;
+			StringPayload& operator=(const StringPayload&) = delete;
+			StringPayload& operator=(StringPayload&&) noexcept = default;
 
 			void send() override;
 			void append(const std::uint8_t* data, size_t size) override;
 			std::string toString() const override;
-			std::unique_ptr<Payload> clone() const override;
+			bool gather(std::vector<iovec>& iovecs) const override;
 
-			void setMessage(const std::string &message);
+			/** Replaces the message, none of it sent, reusing the storage. */
+			void setMessage(std::string_view message);
 
 		private:
 			std::string _message;
 	};
 
+	/**
+	 * Sends an immutable buffer shared with other payloads, e.g. a response
+	 * from the ResponseCache.
+	 */
+	class SharedPayload : public Payload {
+		public:
+			SharedPayload(int socket, std::shared_ptr<const std::string> data);
+			SharedPayload(const SharedPayload&) = delete;
+			SharedPayload(SharedPayload&&) noexcept = default;
+			~SharedPayload() = default;
+
+			SharedPayload& operator=(const SharedPayload&) = delete;
+			SharedPayload& operator=(SharedPayload&&) noexcept = default;
+
+			void send() override;
+			void append(const std::uint8_t* data, size_t size) override;
+			std::string toString() const override;
+			bool gather(std::vector<iovec>& iovecs) const override;
+
+		private:
+			std::shared_ptr<const std::string> _data;
+	};
+
+	/**
+	 * A body produced while it is being sent, such as the output of a CGI
+	 * script. Bytes are appended as they arrive, framed as HTTP/1.1 chunks
+	 * when the length is not known up front, and dropped from the buffer
+	 * once sent. The payload is sent only after finish() was called and
+	 * everything appended went out.
+	 */
+	class StreamPayload : public Payload {
+		public:
+			StreamPayload(int socket, bool isChunked);
+			StreamPayload(const StreamPayload&) = delete;
+			StreamPayload(StreamPayload&&) noexcept = default;
+			~StreamPayload() = default;
+
+			StreamPayload& operator=(const StreamPayload&) = delete;
+			StreamPayload& operator=(StreamPayload&&) noexcept = default;
+
+			void send() override;
+			void append(const std::uint8_t* data, size_t size) override;
+			std::string toString() const override;
+			bool gather(std::vector<iovec>& iovecs) const override;
+			bool isSent() const override;
+			bool isComplete() const override;
+
+			/** Ends the stream, with the last chunk when chunked. */
+			void finish();
+
+			/** Ends the stream where it is, short of its length or last chunk. */
+			void abort();
+
+			/** Bytes appended but not yet sent. */
+			std::size_t getBufferedBytes() const;
+
+		private:
+			std::string _buffer;
+			std::size_t _bufferOffset { 0 };	// Stream offset of _buffer[0]
+			bool _isChunked;
+			bool _isFinished { false };
+
+			void _compact();
+	};
+
+	/**
+	 * Streams a file to the socket straight from the page cache with
+	 * sendfile(2), as much as the socket accepts per call. Where sendfile is
+	 * unavailable, or refuses the file, it falls back to large pread/send
+	 * rounds.
+	 *
+	 * The fd comes from the FileCache and is shared with every other payload
+	 * sending the same file; reads use explicit offsets so they never touch
+	 * the shared file position.
+	 */
 	class FilePayload : public Payload {
 		public:
+			static constexpr std::size_t FALLBACK_BUFFER_SIZE = 64 * 1024;
+
 			FilePayload(int socket, const std::filesystem::path &filePath);
-			FilePayload(const FilePayload& other);
-			FilePayload(FilePayload &&) noexcept = default;
+			FilePayload(int socket, std::shared_ptr<const CachedFile> file);
+			FilePayload(const FilePayload&) = delete;
+			FilePayload(FilePayload&&) noexcept = default;
 			~FilePayload() = default;
 
-			FilePayload& operator=(const FilePayload& other);
+			FilePayload& operator=(const FilePayload&) = delete;
+			FilePayload& operator=(FilePayload&&) noexcept = default;
 
 			void send() override;
 			void append(const std::uint8_t* data, size_t size) override;
 			std::string toString() const override;
-			std::unique_ptr<Payload> clone() const override;
+
+			const CachedFile& getFile() const;
 
 		private:
-			std::filesystem::path _filePath;
-			mutable std::ifstream _ifstream;
+			std::shared_ptr<const CachedFile> _file;
+			bool _isSendfileEnabled { true };
+
+			bool _sendWithSendfile();
+			bool _sendWithBuffer();
 	};
 }
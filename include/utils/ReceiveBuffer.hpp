@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "SlabPool.hpp"
+
+namespace utils {
+	/**
+	 * A fixed-capacity buffer for the bytes received from a client.
+	 *
+	 * Bytes are received straight into the free space at its end and taken
+	 * from its front, both by moving an offset, so the parsers get a single
+	 * contiguous view of what is buffered with nothing copied on the way in
+	 * or moved on the way out. The bytes left unparsed, at most a partial
+	 * message, are only moved back to the front once the free space at the
+	 * end runs short.
+	 *
+	 * Its storage is a slab borrowed from the pool for its capacity when
+	 * bytes are first received, and given back by `release()` once none are
+	 * left. Buffers are move-only, as the slab is.
+	 */
+	class ReceiveBuffer {
+		public:
+			static constexpr std::size_t DEFAULT_CAPACITY = 16 * 1024;
+
+			explicit ReceiveBuffer(std::size_t capacity = DEFAULT_CAPACITY);
+			ReceiveBuffer(ReceiveBuffer&& other) noexcept;
+			~ReceiveBuffer();
+
+			ReceiveBuffer& operator=(ReceiveBuffer&& other) noexcept;
+
+			/** The bytes received and not yet consumed. */
+			const std::uint8_t* data() const;
+			std::size_t size() const;
+
+			bool empty() const;
+			bool isFull() const;
+
+			/**
+			 * The free space to receive into, `available()` bytes long, to be
+			 * followed by `commit()` with how many bytes were written there.
+			 */
+			std::uint8_t* prepare();
+			std::size_t available() const;
+			void commit(std::size_t size);
+
+			/** Copies in as much of `data` as fits and returns how much that was. */
+			std::size_t append(const std::uint8_t* data, std::size_t size);
+
+			void consume(std::size_t size);
+			void clear();
+
+			/** Gives the slab back to the pool, if nothing is buffered. */
+			void release();
+
+			/** True while a slab is borrowed. */
+			bool hasStorage() const;
+
+		private:
+			SlabPool* _pool;
+			SlabPool::Slab _slab;
+			std::size_t _capacity;
+			std::size_t _begin { 0 };	// Offset of the first byte not consumed
+			std::size_t _end { 0 };		// Offset of the first free byte
+	};
+}
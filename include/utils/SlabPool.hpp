@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace utils {
+	/**
+	 * A pool of fixed-size byte slabs, shared by every event loop.
+	 *
+	 * A connection only holds a receive buffer while bytes are waiting to
+	 * be parsed, so an idle client costs nothing beyond its connection and
+	 * the slabs go from one busy client to the next. Released slabs are
+	 * kept for reuse, up to MAX_IDLE_SLABS, and freed past that so a burst
+	 * of clients does not pin its memory forever.
+	 */
+	class SlabPool {
+		public:
+			static constexpr std::size_t MAX_IDLE_SLABS = 1024;
+
+			using Slab = std::unique_ptr<std::uint8_t[]>;
+
+			/** The pool of slabs of `slabSize` bytes, created on first use. */
+			static SlabPool& of(std::size_t slabSize);
+
+			explicit SlabPool(std::size_t slabSize);
+			SlabPool(const SlabPool&) = delete;
+			SlabPool& operator=(const SlabPool&) = delete;
+
+			Slab acquire();
+			void release(Slab slab);
+
+			std::size_t getSlabSize() const;
+
+			/** Slabs acquired and not yet released. */
+			std::size_t getBorrowed() const;
+
+			/** Slabs kept for reuse. */
+			std::size_t getIdle() const;
+
+		private:
+			std::size_t _slabSize;
+			mutable std::mutex _mutex;
+			std::vector<Slab> _idle;
+			std::size_t _borrowed { 0 };
+	};
+}
@@ -7,6 +7,7 @@
 #include <algorithm>
 #include <iterator>
 #include "http/Request.hpp"
+#include "utils/scan.hpp"
 
 namespace utils {
 	using LineHandler = std::function<void(const std::string&)>;
@@ -19,6 +20,7 @@ namespace utils {
     std::string trim(const std::string &str);
 
     int parsePort(const std::string &value);
+    std::size_t parseTimeout(const std::string &value);
 
 	bool isValidPath(const std::string& rawPath);
     bool isValidFilePath(const std::string &path);
@@ -47,7 +49,12 @@ namespace utils {
 		const Iterator end,
 		std::initializer_list<typename std::iterator_traits<Iterator>::value_type> delimiter
 	) {
-		return std::search(begin, end, delimiter.begin(), delimiter.end());
+		if constexpr (std::contiguous_iterator<Iterator> && sizeof(*delimiter.begin()) == 1) {
+			const std::string_view needle(reinterpret_cast<const char*>(delimiter.begin()), delimiter.size());
+			return findSequence(begin, end, needle);
+		} else {
+			return std::search(begin, end, delimiter.begin(), delimiter.end());
+		}
 	}
 
 	// FOR TESTING
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "CoarseClock.hpp"
 #include "common.hpp"
+#include "FileCache.hpp"
 #include "Payload.hpp"
+#include "scan.hpp"
 #include "socket.hpp"
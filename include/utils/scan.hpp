@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string_view>
+
+/**
+ * Byte scanning primitives used by the HTTP parsers.
+ *
+ * Each function has a scalar, an SSE4.2 and an AVX2 implementation. The
+ * best one the CPU supports is picked once at startup, so the same binary
+ * runs everywhere and still scans at memory speed where it can.
+ */
+namespace utils {
+	enum class SimdLevel : uint8_t {
+		SCALAR,
+		SSE42,
+		AVX2
+	};
+
+	SimdLevel getSimdLevel();
+	SimdLevel getMaxSimdLevel();
+
+	/** Switch implementations, clamped to what the CPU supports (tests, benchmarks). */
+	void setSimdLevel(SimdLevel level);
+
+	/** First occurrence of `byte` in [begin, end), or `end`. */
+	const std::uint8_t* findByte(const std::uint8_t* begin, const std::uint8_t* end, std::uint8_t byte);
+
+	/** First occurrence of `needle` in [begin, end), or `end`. */
+	const std::uint8_t* findSequence(const std::uint8_t* begin, const std::uint8_t* end, std::string_view needle);
+
+	/** First byte in [begin, end) that is not a token character (RFC 9110, 5.6.2), or `end`. */
+	const std::uint8_t* findNonToken(const std::uint8_t* begin, const std::uint8_t* end);
+
+	inline const char* findByte(const char* begin, const char* end, char byte) {
+		auto* first = reinterpret_cast<const std::uint8_t*>(begin);
+		auto* last = reinterpret_cast<const std::uint8_t*>(end);
+		return reinterpret_cast<const char*>(findByte(first, last, static_cast<std::uint8_t>(byte)));
+	}
+
+	inline const char* findSequence(const char* begin, const char* end, std::string_view needle) {
+		auto* first = reinterpret_cast<const std::uint8_t*>(begin);
+		auto* last = reinterpret_cast<const std::uint8_t*>(end);
+		return reinterpret_cast<const char*>(findSequence(first, last, needle));
+	}
+
+	inline const char* findNonToken(const char* begin, const char* end) {
+		auto* first = reinterpret_cast<const std::uint8_t*>(begin);
+		auto* last = reinterpret_cast<const std::uint8_t*>(end);
+		return reinterpret_cast<const char*>(findNonToken(first, last));
+	}
+
+	/** findSequence over any contiguous byte range, e.g. std::vector<uint8_t> iterators. */
+	template <std::contiguous_iterator Iterator>
+		requires (sizeof(std::iter_value_t<Iterator>) == 1)
+	Iterator findSequence(Iterator begin, Iterator end, std::string_view needle) {
+		auto* first = reinterpret_cast<const std::uint8_t*>(std::to_address(begin));
+		auto* last = first + (end - begin);
+		return begin + (findSequence(first, last, needle) - first);
+	}
+}
@@ -3,8 +3,17 @@
 #include "Config.hpp"
 #include "Server.hpp"
 #include <functional>
+#include <vector>
+#include <sys/uio.h>
 
 namespace utils {
 	bool setNonBlocking(int fd);
-	int createPassiveSocket(const char* host, int port, int backlog, bool isNonBlocking);
+
+	/**
+	 * sendmsg() of `iovecs` without SIGPIPE. `isMore` hints that more data
+	 * follows right away (MSG_MORE where available), so a header sent ahead
+	 * of a sendfile() body can share its packet.
+	 */
+	ssize_t sendVector(int socket, const std::vector<iovec>& iovecs, bool isMore = false);
+	int createPassiveSocket(const char* host, int port, int backlog, bool isNonBlocking, bool isReusePort = false);
 }
@@ -0,0 +1,112 @@
+#include <algorithm>
+#include "LocationTrie.hpp"
+
+namespace {
+	std::size_t commonPrefixSize(std::string_view a, std::string_view b) {
+		const auto mismatch = std::mismatch(a.begin(), a.end(), b.begin(), b.end());
+
+		return static_cast<std::size_t>(mismatch.first - a.begin());
+	}
+}
+
+// The root has an empty label and holds the location for "", if any
+LocationTrie::LocationTrie() {
+	_addNode("");
+}
+
+LocationTrie::LocationTrie(const std::vector<Location>& locations) : LocationTrie() {
+	for (const Location& location : locations) {
+		insert(location);
+	}
+}
+
+// Walks down as far as the path follows the tree, splitting the edge it
+// leaves in the middle, if any, and hangs the rest of the path below.
+void LocationTrie::insert(const Location& location) {
+	std::string_view rest = location.path;
+	std::uint32_t node = 0;
+
+	while (!rest.empty()) {
+		const std::uint32_t child = _findChild(node, rest.front());
+
+		if (child == NONE) {
+			const std::uint32_t leaf = _addNode(rest);
+			std::vector<Edge>& edges = _nodes[node].edges;
+			const auto position = std::lower_bound(edges.begin(), edges.end(), rest.front(), [](const Edge& candidate, char byte) {
+				return candidate.first < byte;
+			});
+
+			edges.insert(position, Edge { rest.front(), leaf });
+			node = leaf;
+			break;
+		}
+
+		const std::size_t common = commonPrefixSize(_nodes[child].label, rest);
+
+		if (common < _nodes[child].label.size()) {
+			const std::string label = _nodes[child].label.substr(0, common);
+			const std::uint32_t middle = _addNode(label);
+
+			_nodes[child].label.erase(0, common);
+			_nodes[middle].edges.push_back(Edge { _nodes[child].label.front(), child });
+
+			for (Edge& edge : _nodes[node].edges) {
+				if (edge.node == child) {
+					edge.node = middle;
+				}
+			}
+
+			node = middle;
+		} else {
+			node = child;
+		}
+
+		rest.remove_prefix(common);
+	}
+
+	if (_nodes[node].location == NONE) {
+		_nodes[node].location = static_cast<std::uint32_t>(_locations.size());
+		_locations.push_back(location);
+	} else {
+		_locations[_nodes[node].location] = location;
+	}
+}
+
+const Location* LocationTrie::findLongestPrefix(std::string_view path) const {
+	std::uint32_t best = _nodes[0].location;
+	std::uint32_t node = 0;
+
+	while (!path.empty()) {
+		node = _findChild(node, path.front());
+
+		if (node == NONE || !path.starts_with(_nodes[node].label)) {
+			break;
+		}
+
+		path.remove_prefix(_nodes[node].label.size());
+
+		if (_nodes[node].location != NONE) {
+			best = _nodes[node].location;
+		}
+	}
+
+	return best == NONE ? nullptr : &_locations[best];
+}
+
+std::size_t LocationTrie::size() const {
+	return _locations.size();
+}
+
+std::uint32_t LocationTrie::_findChild(std::uint32_t node, char first) const {
+	const std::vector<Edge>& edges = _nodes[node].edges;
+	const auto edge = std::lower_bound(edges.begin(), edges.end(), first, [](const Edge& candidate, char byte) {
+		return candidate.first < byte;
+	});
+
+	return edge != edges.end() && edge->first == first ? edge->node : NONE;
+}
+
+std::uint32_t LocationTrie::_addNode(std::string_view label) {
+	_nodes.push_back(Node { std::string(label), {}, NONE });
+	return static_cast<std::uint32_t>(_nodes.size() - 1);
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "Config.hpp"
 #include "Router.hpp"
 #include "http/index.hpp"
@@ -17,37 +18,180 @@ namespace fs = std::filesystem;
 */
 
 namespace {
-	void handleMultipartPostRequest(fs::path uploadPath, fs::path rootPath, Request& req, Response& res) {
-		auto elements = http::parseMultipart(req.getRawBody(), req.getBoundary());
-		std::string responseMessage;
+	// Uploads are answered by their body's consumer, after the router, so
+	// a page missing from the location root cannot be left to its catch
+	void setErrorPage(Response& res, StatusCode code, const fs::path& page) {
+		try {
+			res.setFile(code, page);
+		} catch (const std::exception& e) {
+			res.setError(code, {});
+		}
+	}
 
-		for (auto& element : elements) {
-			try {
-				std::ofstream file(uploadPath.string() + utils::generate_random_string() + "_" + element.fileName, std::ios::binary);
+	// Each file part is written to its own file as the body arrives, the
+	// other parts being form fields; the upload is answered once the final
+	// boundary is in. One that fails removes the files it wrote.
+	class MultipartUpload {
+		public:
+			MultipartUpload(fs::path uploadPath, fs::path rootPath, std::string_view boundary, Response& res)
+				: _uploadPath(std::move(uploadPath))
+				, _rootPath(std::move(rootPath))
+				, _res(res)
+				, _parser(
+					boundary,
+					[this](const http::MultipartElement& part) { _beginPart(part); },
+					[this](const std::uint8_t* data, std::size_t size) { _write(data, size); },
+					[this]() { _endPart(); }
+				) {
+			}
 
-				if (!file) {
-					std::cerr<< YELLOW "Failed to open file" RESET << std::endl;
-					res.setFile(StatusCode::INTERNAL_SERVER_ERROR_500, rootPath / "500.html");
+			MultipartUpload(const MultipartUpload&) = delete;
+			MultipartUpload& operator=(const MultipartUpload&) = delete;
+
+			void receive(http::RequestBody& body) {
+				if (!_isFailed && !body.isFailed()) {
+					try {
+						body.consume(_parser.parse(body.data(), body.size()));
+					} catch (const std::invalid_argument& e) {
+						_fail(StatusCode::BAD_REQUEST_400, "400.html");
+					}
+				}
+
+				if (_isFailed || body.isFailed()) {
+					body.consume(body.size());
+					_removeFiles();
+				} else if (body.isComplete() && !_parser.isComplete()) {
+					_fail(StatusCode::BAD_REQUEST_400, "400.html");
+				} else if (body.isComplete()) {
+					_res.setText(StatusCode::OK_200, _message);
+				}
+			}
+
+		private:
+			fs::path _uploadPath;
+			fs::path _rootPath;
+			Response& _res;
+			http::MultipartParser _parser;
+			std::ofstream _file;
+			std::string _fileName;
+			std::vector<fs::path> _filePaths;
+			std::string _message;
+			bool _isFailed { false };
+
+			void _beginPart(const http::MultipartElement& part) {
+				if (_isFailed || part.fileName.empty()) {
 					return;
 				}
 
-				file.write(reinterpret_cast<const char*>(element.rawData.data()), element.rawData.size());
-				file.close();
-				responseMessage += "File '" + element.fileName + "' uploaded successfully\n";
-			} catch (const std::exception& e) {
-				res.setFile(http::StatusCode::INTERNAL_SERVER_ERROR_500, rootPath / "500.html");
-				return;
+				// Only the name is kept of what the client calls its file
+				_fileName = fs::path(part.fileName).filename().string();
+				_filePaths.push_back(_uploadPath.string() + utils::generate_random_string() + "_" + _fileName);
+				_file.open(_filePaths.back(), std::ios::binary);
+
+				if (!_file) {
+					std::cerr << YELLOW "Failed to open file" RESET << std::endl;
+					_fail(StatusCode::INTERNAL_SERVER_ERROR_500, "500.html");
+				}
+			}
+
+			void _write(const std::uint8_t* data, std::size_t size) {
+				if (_isFailed || !_file.is_open()) {
+					return;
+				}
+
+				if (!_file.write(reinterpret_cast<const char*>(data), size)) {
+					_fail(StatusCode::INTERNAL_SERVER_ERROR_500, "500.html");
+				}
+			}
+
+			void _endPart() {
+				if (_isFailed || !_file.is_open()) {
+					return;
+				}
+
+				_file.close();
+
+				if (!_file) {
+					return _fail(StatusCode::INTERNAL_SERVER_ERROR_500, "500.html");
+				}
+
+				_message += "File '" + _fileName + "' uploaded successfully\n";
 			}
+
+			void _fail(StatusCode code, const char* page) {
+				_isFailed = true;
+				_removeFiles();
+				setErrorPage(_res, code, _rootPath / page);
+			}
+
+			void _removeFiles() {
+				std::error_code error;
+
+				_file.close();
+
+				for (const fs::path& filePath : _filePaths) {
+					fs::remove(filePath, error);
+				}
+
+				_filePaths.clear();
+			}
+	};
+
+	void receiveMultipartPostRequest(fs::path uploadPath, fs::path rootPath, Request& req, Response& res) {
+		const std::shared_ptr<http::RequestBody>& body = req.getBody();
+
+		if (body == nullptr) {
+			res.setFile(StatusCode::BAD_REQUEST_400, rootPath / "400.html");
+			return;
 		}
 
-		res.setText(http::StatusCode::OK_200, responseMessage);
+		auto upload = std::make_shared<MultipartUpload>(std::move(uploadPath), std::move(rootPath), req.getBoundary(), res);
+
+		body->setConsumer([upload](http::RequestBody& received) {
+			upload->receive(received);
+		});
+	}
+
+	// Written to the file as it is received, the upload is only answered
+	// once complete; a failed one is removed, and what follows a failed
+	// write is discarded.
+	void receiveUpload(const fs::path& filePath, const fs::path& rootPath, http::RequestBody& body, Response& res) {
+		auto file = std::make_shared<std::ofstream>(filePath, std::ios::binary);
+
+		if (!*file) {
+			std::cerr << YELLOW "Failed to open file" RESET << std::endl;
+			res.setFile(StatusCode::INTERNAL_SERVER_ERROR_500, rootPath / "500.html");
+			return;
+		}
+
+		body.setConsumer([filePath, rootPath, file, &res](http::RequestBody& received) {
+			if (*file && !received.isFailed()) {
+				file->write(reinterpret_cast<const char*>(received.data()), received.size());
+
+				if (!*file) {
+					setErrorPage(res, StatusCode::INTERNAL_SERVER_ERROR_500, rootPath / "500.html");
+				}
+			}
+
+			received.consume(received.size());
+
+			if (!*file || received.isFailed()) {
+				std::error_code error;
+
+				file->close();
+				fs::remove(filePath, error);
+			} else if (received.isComplete()) {
+				file->close();
+				res.setText(http::StatusCode::OK_200, "File uploaded successfully\n");
+			}
+		});
 	}
 }
 
 void Router::addLocations(const ServerConfig& serverConfig) {
 	_serverConfig = serverConfig;
 	for (const auto& location : serverConfig.locations) {
-		_locationConfigs[location.path] = location;
+		_locations.insert(location);
 	}
 }
 
@@ -63,16 +207,12 @@ void Router::del(Handler handler) {
 	_routes["DELETE"] = handler;
 }
 
+void Router::cgi(CgiHandler handler) {
+	_cgiHandler = handler;
+}
+
 const Location* Router::findBestMatchingLocation(const string& url) const {
-	const Location* bestMatch = nullptr;
-	size_t longestMatch = 0;
-	for (const auto& [path, config] : _locationConfigs) {
-		if (url.substr(0, path.size()) == path && path.length() > longestMatch) {
-			bestMatch = &config;
-			longestMatch = path.length();
-		}
-	}
-	return bestMatch;
+	return _locations.findLongestPrefix(url);
 }
 
 std::string getFileExtension(const std::string& filePath) {
@@ -99,14 +239,16 @@ fs::path computeFilePath(const Location& loc, const string& requestPath) {
 	return loc.root / requestPath.substr(loc.path.size());
 }
 
-void handleDirectoryRequest(const Location& loc, const fs::path& filePath, Response& res) {
-	fs::path indexPath = filePath / loc.index;
-	if (!fs::exists(indexPath)) {
-		indexPath = loc.root / loc.index;
+void handleDirectoryRequest(const Location& loc, const fs::path& filePath, const Request& req, Response& res) {
+	utils::FileCache& cache = utils::FileCache::local();
+	std::shared_ptr<const utils::CachedFile> index = cache.find(filePath / loc.index);
+
+	if (index == nullptr || index->isDirectory()) {
+		index = cache.find(loc.root / loc.index);
 	}
 
-	if (fs::exists(indexPath)) {
-		res.setFile(StatusCode::OK_200, indexPath);
+	if (index != nullptr && !index->isDirectory()) {
+		res.setResource(req, index, loc.cacheControl);
 	} else if (loc.isAutoIndex) {
 		res.setFile(StatusCode::OK_200, generateDirectoryListing(filePath));
 	} else {
@@ -124,16 +266,17 @@ void handleRedirectRequest(const Location& loc, Response& res, Request& req) {
 
 // Function to handle GET requests
 void handleGetRequest(const Location& loc, const string& requestPath, Request& req, Response& res) {
-	(void) req;
 	try {
 		// Compute the full file path by appending the request subpath
 		fs::path filePath = computeFilePath(loc, requestPath);
-		if (fs::is_directory(filePath)) {
+		std::shared_ptr<const utils::CachedFile> file = utils::FileCache::local().find(filePath);
+
+		if (file != nullptr && file->isDirectory()) {
 			std::cout << YELLOW "Directory request detected" RESET << std::endl;
-			handleDirectoryRequest(loc, filePath, res);
-		} else if (fs::is_regular_file(filePath)) {
+			handleDirectoryRequest(loc, filePath, req, res);
+		} else if (file != nullptr) {
 			std::cout << YELLOW "File request detected" RESET << std::endl;
-			res.setFile(StatusCode::OK_200, filePath);
+			res.setResource(req, file, loc.cacheControl);
 		} else {
 			std::cout << YELLOW "File not found" RESET << std::endl;
 			res.setFile(StatusCode::NOT_FOUND_404, loc.root / "404.html");
@@ -148,14 +291,20 @@ void handlePostRequest(const Location& loc, const string& requestPath, Request&
 	fs::path uploadPath = computeFilePath(loc, requestPath);
 
 	if (req.isMultipart()) {
-		return handleMultipartPostRequest(uploadPath, loc.root, req, res);
+		return receiveMultipartPostRequest(uploadPath, loc.root, req, res);
 	}
 
 	try {
-		const std::string& contentType = req.getHeader(http::Header::CONTENT_TYPE).value_or("");
-		const std::string& ext = http::getExtensionFromMimeType(contentType);
+		const std::string_view contentType = req.getHeader(http::Header::CONTENT_TYPE).value_or("");
+		fs::path filePath = uploadPath.string() + utils::generate_random_string() + ".";
 
-		std::ofstream file(uploadPath.string() + utils::generate_random_string() + ext, std::ios::binary);
+		filePath += http::getExtensionFromMimeType(contentType);
+
+		if (req.getBody() != nullptr) {
+			return receiveUpload(filePath, loc.root, *req.getBody(), res);
+		}
+
+		std::ofstream file(filePath, std::ios::binary);
 
 		if (!file) {
 			std::cerr << YELLOW "Failed to open file" RESET << std::endl;
@@ -163,7 +312,6 @@ void handlePostRequest(const Location& loc, const string& requestPath, Request&
 			return;
 		}
 
-		file.write(reinterpret_cast<const char*>(req.getRawBody().data()), req.getRawBody().size());
 		res.setText(http::StatusCode::OK_200, "File uploaded successfully\n");
 	} catch (const std::exception& e) {
 		res.setFile(http::StatusCode::INTERNAL_SERVER_ERROR_500, loc.root / "500.html");
@@ -221,8 +369,32 @@ void Router::handle(Request& request, Response& response) {
 		return;
 	}
 
+	// Scripts in a CGI location are run for the methods it allows, the
+	// handler leaving the response in progress until the script answers
+	if (_cgiHandler) {
+		if (auto script = findCgiScript(*location, std::string(request.getUrl().path))) {
+			const std::string method(request.getMethod());
+			const auto& methods = location->methods;
+
+			if (!methods.empty() && std::find(methods.begin(), methods.end(), method) == methods.end()) {
+				response.setFile(StatusCode::METHOD_NOT_ALLOWED_405, _serverConfig.errorPages[405]);
+				return;
+			}
+
+			try {
+				_cgiHandler(*location, *script, request, response);
+				request.setStatus(Request::Status::COMPLETE);
+			} catch (const std::exception& e) {
+				std::cerr << "Failed to run " << script->path << ": " << e.what() << std::endl;
+				response.clear();
+				response.setFile(StatusCode::INTERNAL_SERVER_ERROR_500, _serverConfig.errorPages[500]);
+			}
+			return;
+		}
+	}
+
 	// Find the handler for the requested http method
-	const auto it = _routes.find(request.getMethod());
+	const auto it = _routes.find(std::string(request.getMethod()));
 
 	// Matched a route
 	if (it != _routes.end()) {
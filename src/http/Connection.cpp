@@ -11,20 +11,34 @@
 #include "http/parser.hpp"
 #include "http/utils.hpp"
 #include "utils/common.hpp"
+#include "utils/socket.hpp"
+
+namespace {
+	// Keeps a gathered batch well under IOV_MAX (1024 on Linux)
+	constexpr std::size_t MAX_IOVECS = 64;
+
+	// Exchanges sent by this thread's connections, cleared for reuse
+	std::list<http::Connection::Exchange>& spareExchanges() {
+		thread_local std::list<http::Connection::Exchange> spares;
+
+		return spares;
+	}
+}
 
 namespace http {
 	Connection::Connection(int clientSocket, const ServerConfig& serverConfig)
 		: _clientSocket(clientSocket)
-		, _serverConfig(serverConfig) {
+		, _serverConfig(serverConfig)
+		, _buffer(serverConfig.clientBufferSize) {
 	}
 
 	void Connection::read() {
-		if (isClosed()) {
+		if (!canRead()) {
 			return;
 		}
 
-		unsigned char buf[4096];
-		ssize_t bytesRead = recv(_clientSocket, buf, sizeof(buf), MSG_NOSIGNAL);
+		std::uint8_t* space = _buffer.prepare();
+		ssize_t bytesRead = recv(_clientSocket, space, _buffer.available(), MSG_NOSIGNAL);
 
 		if (bytesRead == 0) {
 			this->close();
@@ -32,80 +46,202 @@ namespace http {
 		}
 
 		if (bytesRead > 0) {
-			_buffer.reserve(_buffer.size() + bytesRead);
-			_buffer.insert(_buffer.end(), buf, buf + bytesRead);
-			_lastReceived = std::chrono::steady_clock::now();
+			_buffer.commit(static_cast<std::size_t>(bytesRead));
+			_processPipeline();
+			_releaseBuffer();
+		}
+	}
 
-			if (_queue.size() > 0) {
-				return;
+	/**
+	 * Sends the ready responses at the head of the queue. As many as are in
+	 * memory are gathered into one sendmsg(); the first one with a file body
+	 * ends the batch, its header included, and is finished by its own
+	 * send() once everything before it is out. A body still being streamed
+	 * ends the batch as well, after what it has so far.
+	 *
+	 * Returns true when at least one response was completed.
+	 */
+	bool Connection::sendResponse() {
+		if (isClosed() || !hasReadyResponse()) {
+			return false;
+		}
+
+		thread_local std::vector<iovec> iovecs;
+		bool isInMemory = true;
+		bool hasCompleted = false;
+		std::size_t gatheredBytes = 0;
+
+		iovecs.clear();
+
+		for (const auto& [req, res] : _queue) {
+			if (res.getStatus() != Response::Status::READY || iovecs.size() >= MAX_IOVECS) {
+				break;
 			}
 
-			_processBuffer();
+			if (!res.gather(iovecs)) {
+				isInMemory = false;
+				break;
+			}
 
-			if (_request.getStatus() == Request::Status::BAD || _request.getStatus() == Request::Status::COMPLETE) {
-				_queue.emplace(std::move(_request), Response(_clientSocket));
-				_request.clear();
+			if (!res.isComplete()) {
+				break;
 			}
 		}
-	}
 
-	bool Connection::sendResponse() {
-		if (isClosed() || _queue.empty()) {
-			return false;
+		for (const iovec& chunk : iovecs) {
+			gatheredBytes += chunk.iov_len;
 		}
 
-		auto& [req, res] = _queue.front();
+		// Part of the response may already be on the wire, so a failure
+		// while sending (e.g. the file shrank) can only end the connection.
+		try {
+			std::size_t bytesSent = 0;
 
-		if (res.getStatus() != Response::Status::READY) {
-			return false;
-		}
+			if (!iovecs.empty()) {
+				const ssize_t ret = utils::sendVector(_clientSocket, iovecs, !isInMemory);
 
-		if (res.send()) {
-			const StatusCode code = res.getStatusCode();
-			auto connectionHeader = req.getHeader(Header::CONNECTION);
-			_queue.pop();
+				if (ret < 0) {
+					return false;
+				}
 
-			if (
-				connectionHeader.value_or("") == "close"
-				|| code == StatusCode::BAD_REQUEST_400
-				|| code == StatusCode::REQUEST_TIMEOUT_408
-				|| code == StatusCode::INTERNAL_SERVER_ERROR_500
-				|| code == StatusCode::SERVICE_UNAVAILABLE_503
-				|| code == StatusCode::GATEWAY_TIMEOUT_504
-			) {
-				this->close();
+				bytesSent = static_cast<std::size_t>(ret);
 			}
 
-			return true;
+			for (std::size_t remaining = bytesSent; !_queue.empty();) {
+				Response& res = _queue.front().second;
+
+				if (res.getStatus() != Response::Status::READY) {
+					break;
+				}
+
+				remaining -= res.consume(remaining);
+
+				if (!res.isSent() && bytesSent == gatheredBytes && !isInMemory) {
+					res.send();
+				}
+
+				if (!res.isSent()) {
+					break;
+				}
+
+				_finishResponse();
+				hasCompleted = true;
+
+				if (isClosed()) {
+					break;
+				}
+			}
+		} catch (const std::exception& e) {
+			std::cerr << "Failed to send response: " << e.what() << std::endl;
+			this->close();
+			return false;
 		}
 
-		return false;
+		return hasCompleted;
 	}
 
+	// The socket itself is closed by the server once the event loop has
+	// stopped watching it: closed first, it could stay registered with
+	// epoll for as long as a child forked meanwhile still holds it, with
+	// its events pointing at a dropped client.
+	//
+	// A body still being received is failed, as no more of it will come,
+	// and whatever is buffered dropped.
 	void Connection::close() {
-		if (_clientSocket == -1) {
+		_isClosed = true;
+		_buffer.clear();
+		_buffer.release();
+
+		if (_body) {
+			_body->fail();
+			_body.reset();
+		}
+	}
+
+	bool Connection::isClosed() const {
+		return _isClosed;
+	}
+
+	bool Connection::canRead() const {
+		return !isClosed() && !_buffer.isFull() && !(_body && (_body->isFull() || _body->isFailed()));
+	}
+
+	void Connection::resume() {
+		_processPipeline();
+		_releaseBuffer();
+	}
+
+	bool Connection::hasBadBody() const {
+		return _body && _body->isFailed();
+	}
+
+	// Only an exchange at the head of the queue, with nothing sent for it
+	// yet, can still be answered; its upstream must have been aborted.
+	void Connection::rejectBody(StatusCode code) {
+		if (!_body) {
 			return;
 		}
 
-		if (::close(_clientSocket) < 0) {
-			std::cerr << "Failed to close socket " << _clientSocket << ": " << strerror(errno) << std::endl;
+		_body->fail();
+		_buffer.clear();
+
+		if (!_queue.empty() && _queue.front().first.getBody() == _body && _queue.front().second.getStatus() != Response::Status::READY) {
+			auto& [req, res] = _queue.front();
+
+			req.setStatus(Request::Status::BAD);
+			res.clear();
+			res.setError(code, _serverConfig.errorPages);
+		} else {
+			this->close();
 		}
 
-		_clientSocket = -1;
+		_body.reset();
 	}
 
-	bool Connection::isClosed() const {
-		return (_clientSocket == -1);
+	/**
+	 * Called when the timeout of the current phase expires. A request that
+	 * is still being received gets a 408 and one whose handler did not
+	 * finish gets a 504, both closing the connection once sent. An idle
+	 * connection, or one whose client stopped reading, is simply closed.
+	 */
+	void Connection::timeOut() {
+		switch (getPhase()) {
+			case Phase::READING_BODY:
+				rejectBody(StatusCode::REQUEST_TIMEOUT_408);
+				break;
+			case Phase::READING_HEADER:
+				_buffer.clear();
+				_parser.reset();
+				_queueRequest();
+				_queue.front().second.setError(StatusCode::REQUEST_TIMEOUT_408, _serverConfig.errorPages);
+				break;
+			case Phase::HANDLING:
+				_queue.front().second.clear();
+				_queue.front().second.setError(StatusCode::GATEWAY_TIMEOUT_504, _serverConfig.errorPages);
+				break;
+			default:
+				this->close();
+		}
 	}
 
-	bool Connection::isTimedOut() const {
-		// auto elapsedTime = std::chrono::steady_clock::now() - _lastReceived;
+	int Connection::getClientSocket() const {
+		return _clientSocket;
+	}
+
+	Connection::Phase Connection::getPhase() const {
+		if (!_queue.empty() && _queue.front().second.getStatus() == Response::Status::READY) {
+			return Phase::SENDING;
+		}
+
+		if (_body) {
+			return Phase::READING_BODY;
+		}
 
-		// if (elapsedTime > std::chrono::milliseconds(_serverConfig.timeoutIdle)) {
-		// 	return true;
-		// }
+		if (!_queue.empty()) {
+			return Phase::HANDLING;
+		}
 
-		return false;
+		return _buffer.empty() ? Phase::IDLE : Phase::READING_HEADER;
 	}
 
 	Request* Connection::getRequest() {
@@ -117,6 +253,28 @@ namespace http {
 		return &pair.first;
 	}
 
+	Connection::Exchange* Connection::getPendingExchange() {
+		for (auto& exchange : _queue) {
+			if (exchange.second.getStatus() == Response::Status::PENDING) {
+				return &exchange;
+			}
+		}
+
+		return nullptr;
+	}
+
+	// A streamed response may be ready with nothing to send until more of
+	// it is produced; it counts again once it has bytes or is complete.
+	bool Connection::hasReadyResponse() const {
+		if (_queue.empty()) {
+			return false;
+		}
+
+		const Response& res = _queue.front().second;
+
+		return res.getStatus() == Response::Status::READY && (res.hasPendingBytes() || res.isSent());
+	}
+
 	Response* Connection::getResponse() {
 		if (_queue.size() == 0) {
 			return nullptr;
@@ -126,26 +284,151 @@ namespace http {
 		return &pair.second;
 	}
 
+	// Parses buffered requests until one is incomplete, the queue is full or
+	// a request is bad, after which nothing more is read from this client.
+	// The body of the last one queued comes first.
+	void Connection::_processPipeline() {
+		while (!isClosed()) {
+			if (_body) {
+				_processBody();
+
+				if (_body) {
+					return;
+				}
+			}
+
+			if (_queue.size() >= MAX_PIPELINE_DEPTH) {
+				return;
+			}
+
+			if (!_queue.empty() && _queue.back().first.getStatus() == Request::Status::BAD) {
+				return;
+			}
+
+			_processBuffer();
+
+			if (_request.getStatus() != Request::Status::BAD && _request.getStatus() != Request::Status::COMPLETE) {
+				return;
+			}
+
+			_queueRequest();
+			_body = _queue.back().first.getBody();
+			_chunkDecoder = ChunkDecoder(_serverConfig.clientMaxBodySize);
+		}
+	}
+
+	// A body that nobody but the connection holds any more, its exchange
+	// answered and gone, is still decoded to find where the next request
+	// starts, but dropped as it arrives.
+	void Connection::_processBody() {
+		if (_body->isFailed()) {
+			return;
+		}
+
+		const bool isDropped = (_body.use_count() == 1);
+		std::size_t taken = 0;
+
+		try {
+			do {
+				taken = parseRequestBody(_buffer.data(), _buffer.size(), *_body, _chunkDecoder);
+				_buffer.consume(taken);
+
+				if (isDropped) {
+					_body->consume(_body->size());
+				}
+			} while (isDropped && !_body->isComplete() && taken > 0);
+		} catch (const std::invalid_argument& e) {
+			_body->fail();
+			return;
+		}
+
+		if (_body->isComplete()) {
+			_body.reset();
+		}
+	}
+
+	// The receive buffer is only held while there is something in it to
+	// parse, or a body is being received into it read after read.
+	void Connection::_releaseBuffer() {
+		if (!_body) {
+			_buffer.release();
+		}
+	}
+
+	// Moves the request just parsed to the back of the queue, in a spare
+	// exchange when there is one, leaving a cleared request to parse into.
+	void Connection::_queueRequest() {
+		std::list<Exchange>& spares = spareExchanges();
+
+		if (spares.empty()) {
+			_queue.emplace_back(std::move(_request), Response(_clientSocket));
+		} else {
+			_queue.splice(_queue.end(), spares, spares.begin());
+			std::swap(_queue.back().first, _request);
+			_queue.back().second.setClientSocket(_clientSocket);
+		}
+
+		_request.clear();
+	}
+
+	// Pops the response just sent, closing the connection if it was the
+	// last one it should carry, and lets the next buffered requests in.
+	// The exchange is cleared and kept as a spare, up to MAX_SPARE_EXCHANGES.
+	void Connection::_finishResponse() {
+		auto& [req, res] = _queue.front();
+		const StatusCode code = res.getStatusCode();
+		const bool isClose = req.getHeader(Header::CONNECTION).value_or("") == "close" || res.isAborted();
+		std::list<Exchange>& spares = spareExchanges();
+
+		if (spares.size() < MAX_SPARE_EXCHANGES) {
+			req.clear();
+			res.clear();
+			spares.splice(spares.begin(), _queue, _queue.begin());
+		} else {
+			_queue.pop_front();
+		}
+
+		if (
+			isClose
+			|| code == StatusCode::BAD_REQUEST_400
+			|| code == StatusCode::REQUEST_TIMEOUT_408
+			|| code == StatusCode::INTERNAL_SERVER_ERROR_500
+			|| code == StatusCode::SERVICE_UNAVAILABLE_503
+			|| code == StatusCode::GATEWAY_TIMEOUT_504
+		) {
+			this->close();
+			return;
+		}
+
+		_processPipeline();
+	}
+
 	void Connection::_processBuffer() {
 		using enum Request::Status;
 
 		try {
-			if (_request.getStatus() == PENDING) {
-				parseRequestHeader(_buffer, _request);
+			_parser.parseHeader(_buffer, _request);
+
+			if (_request.getStatus() != HEADER_COMPLETE) {
+				return;
 			}
 
-			if (_request.getStatus() == HEADER_COMPLETE) {
-				if (_request.getMethod() == "GET" || _request.getMethod() == "DELETE") {
-					_request.setStatus(COMPLETE);
-					return;
-				}
+			// Whatever the method, a body is read to keep the requests after
+			// it in step, if only to be discarded
+			if (_request.hasBody()) {
+				const std::size_t length = _request.isChunkEncoding() ? RequestBody::UNKNOWN_LENGTH : _request.getContentLength();
 
-				if (_request.getMethod() == "POST") {
-					parseRequestBody(_buffer, _request, _serverConfig.clientMaxBodySize);
+				if (length != RequestBody::UNKNOWN_LENGTH && length >= _serverConfig.clientMaxBodySize) {
+					throw std::invalid_argument("Exceeded request max body size");
 				}
+
+				_request.setBody(std::make_shared<RequestBody>(length));
 			}
+
+			_request.setStatus(COMPLETE);
 		} catch (const std::invalid_argument &e) {
 			_request.setStatus(BAD);
+			_parser.reset();
 		}
 	}
 }
@@ -0,0 +1,242 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include "http/MimeTypes.hpp"
+
+namespace {
+	struct MimeType {
+		std::string_view type;
+		std::string_view extension;
+	};
+
+	// Lowercase, grouped by type, the extension a type is saved under first
+	constexpr std::array BUILTIN_TYPES = std::to_array<MimeType>({
+		{ "audio/aac", "aac" },
+		{ "application/x-abiword", "abw" },
+		{ "image/apng", "apng" },
+		{ "application/x-freearc", "arc" },
+		{ "image/avif", "avif" },
+		{ "video/x-msvideo", "avi" },
+		{ "application/octet-stream", "bin" },
+		{ "image/bmp", "bmp" },
+		{ "application/x-bzip", "bz" },
+		{ "application/x-bzip2", "bz2" },
+		{ "application/x-cdf", "cda" },
+		{ "application/x-csh", "csh" },
+		{ "text/css; charset=utf-8", "css" },
+		{ "text/csv; charset=utf-8", "csv" },
+		{ "application/msword", "doc" },
+		{ "application/epub+zip", "epub" },
+		{ "application/gzip", "gz" },
+		{ "image/gif", "gif" },
+		{ "text/html; charset=utf-8", "html" },
+		{ "text/html; charset=utf-8", "htm" },
+		{ "application/java-archive", "jar" },
+		{ "image/jpeg", "jpeg" },
+		{ "image/jpeg", "jpg" },
+		{ "text/javascript; charset=utf-8", "js" },
+		{ "text/javascript; charset=utf-8", "mjs" },
+		{ "application/json; charset=utf-8", "json" },
+		{ "application/ld+json; charset=utf-8", "jsonld" },
+		{ "text/markdown; charset=utf-8", "md" },
+		{ "audio/midi", "midi" },
+		{ "audio/midi", "mid" },
+		{ "audio/mpeg", "mp3" },
+		{ "video/mp4", "mp4" },
+		{ "video/mpeg", "mpeg" },
+		{ "audio/ogg", "oga" },
+		{ "audio/ogg", "opus" },
+		{ "video/ogg", "ogv" },
+		{ "application/ogg", "ogx" },
+		{ "font/otf", "otf" },
+		{ "image/png", "png" },
+		{ "application/pdf", "pdf" },
+		{ "application/x-httpd-php", "php" },
+		{ "application/vnd.rar", "rar" },
+		{ "application/rtf", "rtf" },
+		{ "application/x-sh", "sh" },
+		{ "image/svg+xml", "svg" },
+		{ "application/x-tar", "tar" },
+		{ "image/tiff", "tiff" },
+		{ "image/tiff", "tif" },
+		{ "video/mp2t", "ts" },
+		{ "font/ttf", "ttf" },
+		{ "text/plain; charset=utf-8", "txt" },
+		{ "audio/wav", "wav" },
+		{ "audio/webm", "weba" },
+		{ "video/webm", "webm" },
+		{ "image/webp", "webp" },
+		{ "font/woff", "woff" },
+		{ "font/woff2", "woff2" },
+		{ "application/xhtml+xml", "xhtml" },
+		{ "application/xml; charset=utf-8", "xml" },
+		{ "application/zip", "zip" },
+		{ "application/x-7z-compressed", "7z" }
+	});
+
+	struct Key {
+		std::string_view key;
+		std::string_view value;
+		std::size_t order;
+	};
+
+	// A type without its parameters, e.g. "text/html" for "text/html; charset=utf-8"
+	constexpr std::string_view essenceOf(std::string_view type) {
+		type = type.substr(0, type.find(';'));
+
+		while (!type.empty() && (type.back() == ' ' || type.back() == '\t')) {
+			type.remove_suffix(1);
+		}
+
+		while (!type.empty() && (type.front() == ' ' || type.front() == '\t')) {
+			type.remove_prefix(1);
+		}
+
+		return type;
+	}
+
+	// Sorted by key, then by position in BUILTIN_TYPES, so that the first
+	// entry for a type is the extension listed first
+	template <typename Project>
+	constexpr std::array<Key, BUILTIN_TYPES.size()> sortedBy(Project project) {
+		std::array<Key, BUILTIN_TYPES.size()> keys {};
+
+		for (std::size_t i = 0; i < BUILTIN_TYPES.size(); i++) {
+			keys[i] = project(BUILTIN_TYPES[i], i);
+		}
+
+		std::sort(keys.begin(), keys.end(), [](const Key& a, const Key& b) {
+			return a.key != b.key ? a.key < b.key : a.order < b.order;
+		});
+
+		return keys;
+	}
+
+	constexpr auto TYPE_BY_EXTENSION = sortedBy([](const MimeType& mime, std::size_t order) {
+		return Key { mime.extension, mime.type, order };
+	});
+
+	constexpr auto EXTENSION_BY_TYPE = sortedBy([](const MimeType& mime, std::size_t order) {
+		return Key { essenceOf(mime.type), mime.extension, order };
+	});
+
+	constexpr bool hasUniqueKeys(const std::array<Key, BUILTIN_TYPES.size()>& keys) {
+		return std::adjacent_find(keys.begin(), keys.end(), [](const Key& a, const Key& b) {
+			return a.key == b.key;
+		}) == keys.end();
+	}
+
+	constexpr bool isLowerCase(const std::array<Key, BUILTIN_TYPES.size()>& keys) {
+		return std::none_of(keys.begin(), keys.end(), [](const Key& entry) {
+			return std::any_of(entry.key.begin(), entry.key.end(), [](char c) { return c >= 'A' && c <= 'Z'; });
+		});
+	}
+
+	static_assert(hasUniqueKeys(TYPE_BY_EXTENSION), "An extension is listed twice");
+	static_assert(isLowerCase(TYPE_BY_EXTENSION) && isLowerCase(EXTENSION_BY_TYPE), "Names must be lowercase");
+
+	char lowerCase(char c) {
+		return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+	}
+
+	// The tables are lowercase, which is the order of the folded names
+	bool isLess(std::string_view entry, std::string_view name) {
+		return std::lexicographical_compare(entry.begin(), entry.end(), name.begin(), name.end(), [](char a, char b) {
+			return lowerCase(a) < lowerCase(b);
+		});
+	}
+
+	bool isEqual(std::string_view entry, std::string_view name) {
+		return std::equal(entry.begin(), entry.end(), name.begin(), name.end(), [](char a, char b) {
+			return a == lowerCase(b);
+		});
+	}
+}
+
+namespace http {
+	MimeTypes& MimeTypes::global() {
+		static MimeTypes mimeTypes;
+
+		return mimeTypes;
+	}
+
+	MimeTypes::MimeTypes() {
+		_typeByExtension.reserve(TYPE_BY_EXTENSION.size());
+		_extensionByType.reserve(EXTENSION_BY_TYPE.size());
+
+		for (const Key& entry : TYPE_BY_EXTENSION) {
+			_typeByExtension.push_back(Entry { entry.key, entry.value });
+		}
+
+		for (const Key& entry : EXTENSION_BY_TYPE) {
+			_extensionByType.push_back(Entry { entry.key, entry.value });
+		}
+	}
+
+	// An extension already known is moved to the new type, and a type
+	// already known is only saved under its new first extension.
+	void MimeTypes::add(std::string_view type, const std::vector<std::string>& extensions) {
+		const auto byKey = [](const Entry& entry, std::string_view key) {
+			return isLess(entry.key, key);
+		};
+
+		if (extensions.empty()) {
+			return;
+		}
+
+		std::string_view savedExtension;
+
+		type = _store(type);
+
+		for (const std::string& name : extensions) {
+			const std::string_view extension = _store(name);
+
+			if (savedExtension.empty()) {
+				savedExtension = extension;
+			}
+
+			const auto it = std::lower_bound(_typeByExtension.begin(), _typeByExtension.end(), extension, byKey);
+
+			if (it != _typeByExtension.end() && it->key == extension) {
+				it->value = type;
+			} else {
+				_typeByExtension.insert(it, Entry { extension, type });
+			}
+		}
+
+		const std::string_view essence = essenceOf(type);
+		auto first = std::lower_bound(_extensionByType.begin(), _extensionByType.end(), essence, byKey);
+		auto last = first;
+
+		while (last != _extensionByType.end() && last->key == essence) {
+			last++;
+		}
+
+		first = _extensionByType.erase(first, last);
+		_extensionByType.insert(first, Entry { essence, savedExtension });
+	}
+
+	std::string_view MimeTypes::typeOf(std::string_view extension) const {
+		const auto it = std::lower_bound(_typeByExtension.begin(), _typeByExtension.end(), extension, [](const Entry& entry, std::string_view key) {
+			return isLess(entry.key, key);
+		});
+
+		return it != _typeByExtension.end() && isEqual(it->key, extension) ? it->value : DEFAULT_TYPE;
+	}
+
+	std::string_view MimeTypes::extensionOf(std::string_view type) const {
+		const std::string_view essence = essenceOf(type);
+		const auto it = std::lower_bound(_extensionByType.begin(), _extensionByType.end(), essence, [](const Entry& entry, std::string_view key) {
+			return isLess(entry.key, key);
+		});
+
+		return it != _extensionByType.end() && isEqual(it->key, essence) ? it->value : DEFAULT_EXTENSION;
+	}
+
+	std::string_view MimeTypes::_store(std::string_view name) {
+		std::string& stored = _names.emplace_back(name);
+
+		std::transform(stored.begin(), stored.end(), stored.begin(), lowerCase);
+		return stored;
+	}
+}
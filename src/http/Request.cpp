@@ -2,20 +2,71 @@
 #include <cstring>
 #include <array>
 #include <algorithm>
+#include <cctype>
+#include <stdexcept>
+#include <utility>
 #include <sys/socket.h>
 #include "utils/index.hpp"
 #include "http/Request.hpp"
 #include "http/utils.hpp"
 
+namespace {
+	std::size_t findIgnoringCase(std::string_view haystack, std::string_view needle) {
+		auto it = std::search(haystack.begin(), haystack.end(), needle.begin(), needle.end(), [](char a, char b) {
+			return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+		});
+
+		return it == haystack.end() ? std::string_view::npos : static_cast<std::size_t>(it - haystack.begin());
+	}
+
+	utils::SlabPool& headerBlockPool() {
+		static utils::SlabPool& pool = utils::SlabPool::of(http::MAX_REQUEST_HEADER_SIZE);
+
+		return pool;
+	}
+}
+
 namespace http {
 	Request::Request(Status status) : _status(status) {}
 
+	Request::Request(Request&& other) noexcept {
+		*this = std::move(other);
+	}
+
+	Request::~Request() {
+		headerBlockPool().release(std::move(_headerBlock));
+	}
+
+	Request& Request::operator=(Request&& other) noexcept {
+		if (this != &other) {
+			headerBlockPool().release(std::move(_headerBlock));
+			_headerBlock = std::move(other._headerBlock);
+			_headerSize = std::exchange(other._headerSize, 0);
+			_method = other._method;
+			_uri = other._uri;
+			_version = other._version;
+			_url = std::move(other._url);
+			_headerFields = other._headerFields;
+			_contentLength = other._contentLength;
+			_body = std::move(other._body);
+			_status = other._status;
+		}
+
+		return *this;
+	}
+
+	// The header block goes back to the pool, for whichever request is
+	// parsed next.
 	void Request::clear() {
-		_method.clear();
+		headerBlockPool().release(std::move(_headerBlock));
+		_headerSize = 0;
+		_method = {};
+		_uri = {};
 		_url = Url();
-		_version.clear();
-		_headerFields.clear();
-		_rawBody.clear();
+		_version = {};
+		_headerFields.fill(std::nullopt);
+		_contentLength = 0;
+		_body.reset();
 		_status = Request::Status::PENDING;
 	}
 
@@ -27,11 +78,15 @@ namespace http {
 		return (getHeader(Header::CONTENT_TYPE).value_or("").starts_with("multipart/form-data"));
 	}
 
-	const std::string& Request::getMethod() const {
+	bool Request::hasBody() const {
+		return isChunkEncoding() || _contentLength > 0;
+	}
+
+	std::string_view Request::getMethod() const {
 		return _method;
 	}
 
-	const std::string& Request::getUri() const {
+	std::string_view Request::getUri() const {
 		return _uri;
 	}
 
@@ -39,20 +94,19 @@ namespace http {
 		return _url;
 	}
 
-	const std::string& Request::getVersion() const {
+	std::string_view Request::getVersion() const {
 		return _version;
 	}
 
-	std::string Request::getBoundary() const {
-		std::string contentType = getHeader(Header::CONTENT_TYPE).value_or("");
-		std::string lowercaseContentType = utils::lowerCase(contentType);
-		std::size_t pos = lowercaseContentType.find("boundary=");
+	std::string_view Request::getBoundary() const {
+		std::string_view contentType = getHeader(Header::CONTENT_TYPE).value_or("");
+		std::size_t pos = findIgnoringCase(contentType, "boundary=");
 
-		if (pos == std::string::npos) {
+		if (pos == std::string_view::npos) {
 			return "";
 		}
 
-		std::string boundary = contentType.substr(pos + 9);
+		std::string_view boundary = contentType.substr(pos + 9);
 
 		if (boundary.size() > 2 && boundary.front() == '"' && boundary.back() == '"') {
 			boundary = boundary.substr(1, boundary.size() - 2);
@@ -65,74 +119,56 @@ namespace http {
 		return _contentLength;
 	}
 
-	std::optional<std::string> Request::getHeader(Header header) const {
-		auto it = _headerFields.find(stringOf(header));
-
-		if (it == _headerFields.end()) {
-			return std::nullopt;
-		}
-
-		return it->second;
+	std::optional<std::string_view> Request::getHeader(Header header) const {
+		return _headerFields[static_cast<std::size_t>(header)];
 	}
 
-
-	const std::vector<std::uint8_t>& Request::getRawBody() const {
-		return _rawBody;
+	const std::shared_ptr<RequestBody>& Request::getBody() const {
+		return _body;
 	}
 
 	Request::Status Request::getStatus() const {
 		return _status;
 	}
 
-	Request& Request::setRawBody(
-		std::vector<uint8_t>::const_iterator begin,
-		std::vector<uint8_t>::const_iterator end,
-		bool append
-	) {
-		if (append) {
-			_rawBody.insert(_rawBody.end(), begin, end);
-		} else {
-			_rawBody.assign(begin, end);
+	std::string_view Request::storeHeaderBytes(std::string_view bytes) {
+		// Growing the block would move it and leave every view dangling
+		if (_headerSize + bytes.size() > MAX_REQUEST_HEADER_SIZE) {
+			throw std::invalid_argument("Request header too large");
 		}
 
-		return *this;
-	}
-
-	Request& Request::setRawBody(
-		std::move_iterator<std::vector<uint8_t>::iterator> begin,
-		std::move_iterator<std::vector<uint8_t>::iterator> end,
-		bool append
-	) noexcept {
-		if (append) {
-			_rawBody.insert(_rawBody.end(), begin, end);
-		} else {
-			_rawBody.assign(begin, end);
+		if (!_headerBlock) {
+			_headerBlock = headerBlockPool().acquire();
 		}
 
-		return *this;
+		char* stored = reinterpret_cast<char*>(_headerBlock.get()) + _headerSize;
+
+		std::copy(bytes.begin(), bytes.end(), stored);
+		_headerSize += bytes.size();
+		return std::string_view(stored, bytes.size());
 	}
 
-	Request& Request::setContentLength(std::size_t bytes) {
-		_contentLength = bytes;
+	Request& Request::setBody(std::shared_ptr<RequestBody> body) {
+		_body = std::move(body);
 		return *this;
 	}
 
-	Request& Request::setHeader(const std::string& name, const std::string& value) {
-		_headerFields[name] = value;
+	Request& Request::setContentLength(std::size_t bytes) {
+		_contentLength = bytes;
 		return *this;
 	}
 
-	Request& Request::setHeader(Header header, const std::string& value) {
-		_headerFields[stringOf(header)] = value;
+	Request& Request::setHeader(Header header, std::string_view value) {
+		_headerFields[static_cast<std::size_t>(header)] = value;
 		return *this;
 	}
 
-	Request& Request::setMethod(const std::string& method) {
+	Request& Request::setMethod(std::string_view method) {
 		_method = method;
 		return *this;
 	}
 
-	Request& Request::setUri(const std::string& uri) {
+	Request& Request::setUri(std::string_view uri) {
 		_uri = uri;
 		return *this;
 	}
@@ -147,7 +183,7 @@ namespace http {
 		return *this;
 	}
 
-	Request& Request::setVersion(const std::string& version) {
+	Request& Request::setVersion(std::string_view version) {
 		_version = version;
 		return *this;
 	}
@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <limits>
+#include "http/RequestBody.hpp"
+
+namespace http {
+	RequestBody::RequestBody(std::size_t length) : _length(length) {
+	}
+
+	const std::uint8_t* RequestBody::data() const {
+		return _buffer.data() + _offset;
+	}
+
+	std::size_t RequestBody::size() const {
+		return _buffer.size() - _offset;
+	}
+
+	// What was consumed is dropped once it is at least half the buffer, so
+	// a body going through in small pieces does not move its bytes twice.
+	void RequestBody::consume(std::size_t size) {
+		_offset += std::min(size, this->size());
+
+		if (_offset == _buffer.size()) {
+			_buffer.clear();
+			_offset = 0;
+		} else if (_offset * 2 >= _buffer.size()) {
+			_buffer.erase(_buffer.begin(), _buffer.begin() + _offset);
+			_offset = 0;
+		}
+	}
+
+	void RequestBody::setConsumer(Consumer consumer) {
+		_consumer = std::move(consumer);
+
+		if (size() > 0 || _isComplete || _isFailed) {
+			_notify();
+		}
+	}
+
+	void RequestBody::gather() {
+		_limit = std::numeric_limits<std::size_t>::max();
+	}
+
+	void RequestBody::append(const std::uint8_t* data, std::size_t size) {
+		if (size == 0 || _isComplete || _isFailed) {
+			return;
+		}
+
+		_buffer.insert(_buffer.end(), data, data + size);
+		_received += size;
+		_notify();
+	}
+
+	void RequestBody::complete() {
+		if (_isComplete || _isFailed) {
+			return;
+		}
+
+		_isComplete = true;
+		_notify();
+	}
+
+	void RequestBody::fail() {
+		if (_isComplete || _isFailed) {
+			return;
+		}
+
+		_isFailed = true;
+		_buffer.clear();
+		_offset = 0;
+		_notify();
+	}
+
+	bool RequestBody::isFull() const {
+		return size() >= _limit;
+	}
+
+	bool RequestBody::isComplete() const {
+		return _isComplete;
+	}
+
+	bool RequestBody::isDrained() const {
+		return _isComplete && size() == 0;
+	}
+
+	bool RequestBody::isFailed() const {
+		return _isFailed;
+	}
+
+	std::size_t RequestBody::getReceived() const {
+		return _received;
+	}
+
+	std::size_t RequestBody::getLength() const {
+		return _length;
+	}
+
+	// The consumer is moved out for its last call, which may well destroy
+	// what it captured.
+	void RequestBody::_notify() {
+		if (!_consumer) {
+			return;
+		}
+
+		if (_isComplete || _isFailed) {
+			Consumer consumer = std::move(_consumer);
+
+			_consumer = nullptr;
+			consumer(*this);
+			return;
+		}
+
+		_consumer(*this);
+	}
+}
@@ -1,10 +1,60 @@
-#include <sstream>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
 #include <cstdint>
+#include <optional>
+#include <string>
 #include <sys/socket.h>
+#include "http/Request.hpp"
 #include "http/Response.hpp"
 #include "Error.hpp"
 #include "utils/index.hpp"
 #include "http/utils.hpp"
+#include "http/ResponseCache.hpp"
+
+namespace {
+	// Weak comparison (RFC 9110, 8.8.3.2) of each entity-tag listed in
+	// If-None-Match with the strong form of ours, W/ or not.
+	bool matchesEntityTag(std::string_view ifNoneMatch, std::string_view entityTag) {
+		std::size_t pos = ifNoneMatch.find_first_not_of(" \t");
+
+		if (pos != std::string_view::npos && ifNoneMatch.substr(pos).starts_with('*')) {
+			return true;
+		}
+
+		while ((pos = ifNoneMatch.find('"', pos)) != std::string_view::npos) {
+			const std::size_t end = ifNoneMatch.find('"', pos + 1);
+
+			if (end == std::string_view::npos) {
+				return false;
+			}
+
+			if (ifNoneMatch.substr(pos, end - pos + 1) == entityTag) {
+				return true;
+			}
+
+			pos = end + 1;
+		}
+
+		return false;
+	}
+
+	// If-Modified-Since only counts without If-None-Match, and when it is a
+	// date that has passed
+	bool isNotModified(const http::Request& request, const utils::CachedFile& file, std::string_view entityTag) {
+		if (const auto ifNoneMatch = request.getHeader(http::Header::IF_NONE_MATCH)) {
+			return matchesEntityTag(*ifNoneMatch, entityTag);
+		}
+
+		if (const auto ifModifiedSince = request.getHeader(http::Header::IF_MODIFIED_SINCE)) {
+			const std::optional<std::time_t> since = utils::CoarseClock::parseHttpDate(*ifModifiedSince);
+
+			return since.has_value() && *since <= utils::CoarseClock::local().wallTime() && file.mtime.tv_sec <= *since;
+		}
+
+		return false;
+	}
+}
 
 namespace http {
 	Response::Response(int clientSocket)
@@ -12,61 +62,75 @@ namespace http {
 		, _header(utils::StringPayload(clientSocket, "")) {
 	}
 
-	Response::Response(const Response& other)
-		: _clientSocket(other._clientSocket)
-		, _status(other._status)
-		, _statusCode(other._statusCode)
-		, _headerByName(other._headerByName)
-		, _header(other._header)
-		, _body(other._body ? other._body->clone() : nullptr) {
-	}
+	// The header and an in-memory body go out in one sendmsg(). A file body
+	// follows with sendfile() once the header is out, the header being sent
+	// with MSG_MORE so both can share the first packet.
+	bool Response::send() {
+		thread_local std::vector<iovec> iovecs;
+		const bool isInMemory = gather(iovecs);
 
-	Response& Response::operator=(const Response& other) {
-		if (this != &other) {
-			_clientSocket = other._clientSocket;
-			_status = other._status;
-			_statusCode = other._statusCode;
-			_headerByName = other._headerByName;
-			_header = other._header;
-			_body = other._body ? other._body->clone() : nullptr;
-		}
+		if (!iovecs.empty()) {
+			const ssize_t bytesSent = utils::sendVector(_clientSocket, iovecs, !isInMemory);
 
-		return *this;
-	}
+			iovecs.clear();
 
-	bool Response::send() {
-		if (!_header.isSent()) {
-			_header.send();
-			return false;
+			if (bytesSent < 0) {
+				return false;
+			}
+
+			consume(static_cast<std::size_t>(bytesSent));
+
+			if (!_header.isSent()) {
+				return false;
+			}
 		}
 
-		if (_body == nullptr) {
-			return true;
+		if (!isInMemory) {
+			_body->send();
 		}
 
-		_body->send();
+		return isSent();
+	}
 
-		if (_body->isSent()) {
-			return true;
+	bool Response::gather(std::vector<iovec>& iovecs) const {
+		_header.gather(iovecs);
+		return _body == nullptr || _body->gather(iovecs);
+	}
+
+	std::size_t Response::consume(std::size_t bytes) {
+		std::size_t used = _header.consume(bytes);
+
+		if (_body != nullptr) {
+			used += _body->consume(bytes - used);
 		}
 
-		return false;
+		return used;
 	}
 
-	void Response::build() {
-		std::ostringstream ostream;
+	bool Response::isSent() const {
+		return _header.isSent() && (_body == nullptr || _body->isSent());
+	}
 
-		ostream
-			<< "HTTP/1.1 "
-			<< static_cast<std::uint16_t>(_statusCode) << " "
-			<< stringOf(_statusCode) << "\r\n";
+	bool Response::isComplete() const {
+		return _body == nullptr || _body->isComplete();
+	}
 
-		for (const auto& [name, value] : _headerByName) {
-			ostream << name << ": " << value << "\r\n";
-		}
+	bool Response::hasPendingBytes() const {
+		return _header.hasPendingBytes() || (_body != nullptr && _body->hasPendingBytes());
+	}
+
+	void Response::abort() {
+		_isAborted = true;
+	}
+
+	bool Response::isAborted() const {
+		return _isAborted;
+	}
 
-		ostream << "\r\n";
-		_header.setMessage(ostream.str());
+	void Response::build() {
+		_buildHead();
+		_appendHeader(_fields);
+		_appendHeader("\r\n");
 		setStatus(Response::Status::READY);
 	}
 
@@ -90,14 +154,29 @@ namespace http {
 		return _body;
 	}
 
+	// The fields and header keep their storage for the next response.
 	Response& Response::clear() {
+		_status = Status::PENDING;
 		_statusCode = StatusCode::NONE_0;
-		_headerByName.clear();
+		_isAborted = false;
+		_fields.clear();
+		_knownFields.reset();
 		_header.setMessage("");
 		_body.reset();
 		return *this;
 	}
 
+	Response& Response::setClientSocket(int clientSocket) {
+		_clientSocket = clientSocket;
+		_header.setSocket(clientSocket);
+
+		if (_body != nullptr) {
+			_body->setSocket(clientSocket);
+		}
+
+		return *this;
+	}
+
 	Response& Response::setStatus(const Status status) {
 		_status = status;
 		return *this;
@@ -108,8 +187,25 @@ namespace http {
 		return *this;
 	}
 
-	Response& Response::setHeader(Header header, const std::string& value) {
-		_headerByName[stringOf(header)] = value;
+	Response& Response::setHeader(Header header, std::string_view value) {
+		const std::size_t index = static_cast<std::size_t>(header);
+
+		if (_knownFields.test(index)) {
+			_eraseField(stringOf(header));
+		}
+
+		_knownFields.set(index);
+		_appendField(stringOf(header), value);
+		return *this;
+	}
+
+	Response& Response::setHeader(std::string_view name, std::string_view value) {
+		if (const std::optional<Header> header = findHeader(name)) {
+			return setHeader(*header, value);
+		}
+
+		_eraseField(name);
+		_appendField(name, value);
 		return *this;
 	}
 
@@ -124,22 +220,142 @@ namespace http {
 	}
 
 	void Response::setText(StatusCode statusCode, const std::string& text) {
+		char length[24];
+		const auto [end, ec] = std::to_chars(length, length + sizeof(length), text.size());
+
 		setStatusCode(statusCode);
 		setBody(std::make_unique<utils::StringPayload>(_clientSocket, text));
 		setHeader(Header::CONTENT_TYPE, getMimeType("txt"));
-		setHeader(Header::CONTENT_LENGTH, std::to_string(_body->getSizeInBytes()));
+		setHeader(Header::CONTENT_LENGTH, std::string_view(length, end - length));
 		build();
 	}
 
 	void Response::setFile(StatusCode statusCode, const std::filesystem::path &filePath) {
-		std::string ext = filePath.extension().string().erase(0, 1); // Get file extension without '.'
+		setFile(statusCode, utils::FileCache::local().open(filePath));
+	}
+
+	// Small files are answered from the ResponseCache: the header fields
+	// and content go out as one shared buffer, after a header holding only
+	// the status line and Date, in place of the full header and a
+	// FilePayload.
+	void Response::setFile(StatusCode statusCode, std::shared_ptr<const utils::CachedFile> file) {
+		ResponseCache& cache = ResponseCache::local();
 
 		setStatusCode(statusCode);
-		setBody(std::make_unique<utils::FilePayload>(_clientSocket, filePath));
-		setHeader(Header::CONTENT_TYPE, getMimeType(ext));
-		setHeader(Header::CONTENT_LENGTH, std::to_string(_body->getSizeInBytes()));
-		// setHeader(Header::CACHE_CONTROL, "public, max-age=86400");	// For production mode
-		setHeader(Header::CACHE_CONTROL, "no-store"); 				// For test mode
+
+		if (!_knownFields.test(static_cast<std::size_t>(Header::CACHE_CONTROL))) {
+			setHeader(Header::CACHE_CONTROL, "no-store");
+		}
+
+		// The file's own fields must all come after the split, so any the
+		// caller set go rather than be replaced from within its part
+		for (const Header header : { Header::CONTENT_TYPE, Header::CONTENT_LENGTH }) {
+			if (_knownFields.test(static_cast<std::size_t>(header))) {
+				_knownFields.reset(static_cast<std::size_t>(header));
+				_eraseField(stringOf(header));
+			}
+		}
+
+		const std::size_t callerFields = _fields.size();
+
+		setHeader(Header::CONTENT_TYPE, file->mimeType);
+		setHeader(Header::CONTENT_LENGTH, file->contentLength);
+
+		if (cache.isCacheable(*file)) {
+			std::shared_ptr<const std::string> response = cache.find(*file, statusCode);
+
+			if (response == nullptr) {
+				_header.setMessage(std::string_view(_fields).substr(callerFields));
+				_appendHeader("\r\n");
+				response = cache.insert(*file, statusCode, _header.toString());
+			}
+
+			_buildHead();
+			_appendHeader(std::string_view(_fields).substr(0, callerFields));
+			setBody(std::make_unique<utils::SharedPayload>(_clientSocket, std::move(response)));
+			setStatus(Response::Status::READY);
+			return;
+		}
+
+		setBody(std::make_unique<utils::FilePayload>(_clientSocket, std::move(file)));
 		build();
 	}
+
+	// A file changed within the current second may change again without
+	// its mtime showing it, so it only gets a weak ETag until the next one
+	void Response::setResource(const Request& request, std::shared_ptr<const utils::CachedFile> file, std::string_view cacheControl) {
+		const std::string_view weakTag = file->entityTag;
+		const std::string_view strongTag = weakTag.substr(2);
+		const bool isRecent = file->mtime.tv_sec >= utils::CoarseClock::local().wallTime();
+
+		setHeader(Header::LAST_MODIFIED, file->lastModified);
+		setHeader(Header::ETAG, isRecent ? weakTag : strongTag);
+		setHeader(Header::CACHE_CONTROL, cacheControl);
+
+		if (isNotModified(request, *file, strongTag)) {
+			setStatusCode(StatusCode::NOT_MODIFIED_304);
+			build();
+			return;
+		}
+
+		setFile(StatusCode::OK_200, std::move(file));
+	}
+
+	void Response::setError(StatusCode statusCode, const std::map<int, std::string>& errorPages) {
+		auto it = errorPages.find(static_cast<int>(statusCode));
+
+		if (it != errorPages.end()) {
+			setFile(statusCode, it->second);
+		} else {
+			setText(statusCode, std::string(stringOf(statusCode)) + "\n");
+		}
+	}
+
+	// The status line and the Date field, unless one was set, lead every
+	// response; the date is the one the clock formatted for this second.
+	void Response::_buildHead() {
+		const std::string_view statusLine = statusLineOf(_statusCode);
+
+		if (statusLine.empty()) {
+			char code[8];
+			const auto [end, ec] = std::to_chars(code, code + sizeof(code), static_cast<std::uint16_t>(_statusCode));
+
+			_header.setMessage("HTTP/1.1 ");
+			_appendHeader(std::string_view(code, end - code));
+			_appendHeader(" Unknown\r\n");
+		} else {
+			_header.setMessage(statusLine);
+		}
+
+		if (!_knownFields.test(static_cast<std::size_t>(Header::DATE))) {
+			_appendHeader("Date: ");
+			_appendHeader(utils::CoarseClock::local().httpDate());
+			_appendHeader("\r\n");
+		}
+	}
+
+	void Response::_appendField(std::string_view name, std::string_view value) {
+		_fields.append(name).append(": ").append(value).append("\r\n");
+	}
+
+	// Only ever a few short lines to look through
+	void Response::_eraseField(std::string_view name) {
+		for (std::size_t start = 0; start < _fields.size();) {
+			const std::size_t end = _fields.find("\r\n", start) + 2;
+			const std::string_view line(_fields.data() + start, end - start);
+
+			if (line.size() > name.size() && line[name.size()] == ':' && std::equal(name.begin(), name.end(), line.begin(), [](char a, char b) {
+				return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+			})) {
+				_fields.erase(start, end - start);
+				return;
+			}
+
+			start = end;
+		}
+	}
+
+	void Response::_appendHeader(std::string_view bytes) {
+		_header.append(reinterpret_cast<const std::uint8_t*>(bytes.data()), bytes.size());
+	}
 }
@@ -0,0 +1,121 @@
+#include <functional>
+#include <stdexcept>
+#include <unistd.h>
+#include "http/ResponseCache.hpp"
+
+namespace {
+	bool isSameFile(const utils::CachedFile& file, dev_t device, ino_t inode, timespec mtime, std::size_t size) {
+		return file.device == device
+			&& file.inode == inode
+			&& file.size == size
+			&& file.mtime.tv_sec == mtime.tv_sec
+			&& file.mtime.tv_nsec == mtime.tv_nsec;
+	}
+}
+
+namespace http {
+	std::size_t ResponseCache::KeyHash::operator()(const Key& key) const {
+		return std::hash<std::string_view>()(key.path) ^ static_cast<std::size_t>(key.statusCode);
+	}
+
+	ResponseCache& ResponseCache::local() {
+		thread_local ResponseCache cache;
+		return cache;
+	}
+
+	void ResponseCache::configure(std::size_t capacity, std::size_t maxFileSize) {
+		_capacity = capacity;
+		_maxFileSize = maxFileSize;
+
+		while (_sizeInBytes > _capacity) {
+			_erase(std::prev(_lru.end()));
+		}
+	}
+
+	bool ResponseCache::isCacheable(const utils::CachedFile& file) const {
+		return !file.isDirectory() && file.size <= _maxFileSize && file.size < _capacity;
+	}
+
+	std::shared_ptr<const std::string> ResponseCache::find(const utils::CachedFile& file, StatusCode statusCode) {
+		auto it = _entryByKey.find(Key { file.path.native(), statusCode });
+
+		if (it == _entryByKey.end()) {
+			return nullptr;
+		}
+
+		const Entry& entry = *it->second;
+
+		if (!isSameFile(file, entry.device, entry.inode, entry.mtime, entry.fileSize)) {
+			_erase(it->second);
+			return nullptr;
+		}
+
+		_lru.splice(_lru.begin(), _lru, it->second);
+		return entry.response;
+	}
+
+	std::shared_ptr<const std::string> ResponseCache::insert(
+		const utils::CachedFile& file,
+		StatusCode statusCode,
+		std::string_view header
+	) {
+		auto response = std::make_shared<std::string>(header.size() + file.size, '\0');
+
+		header.copy(response->data(), header.size());
+
+		for (std::size_t offset = 0; offset < file.size;) {
+			const ssize_t bytesRead = ::pread(
+				file.fd,
+				response->data() + header.size() + offset,
+				file.size - offset,
+				static_cast<off_t>(offset)
+			);
+
+			if (bytesRead <= 0) {
+				throw std::ios_base::failure("Failed to read " + file.path.string());
+			}
+
+			offset += static_cast<std::size_t>(bytesRead);
+		}
+
+		auto it = _entryByKey.find(Key { file.path.native(), statusCode });
+
+		if (it != _entryByKey.end()) {
+			_erase(it->second);
+		}
+
+		while (!_lru.empty() && _sizeInBytes + response->size() > _capacity) {
+			_erase(std::prev(_lru.end()));
+		}
+
+		if (response->size() <= _capacity) {
+			_lru.push_front(Entry {
+				file.path.native(), statusCode, file.device, file.inode, file.mtime, file.size, response
+			});
+			_entryByKey.emplace(Key { _lru.front().path, statusCode }, _lru.begin());
+			_sizeInBytes += response->size();
+		}
+
+		return response;
+	}
+
+	void ResponseCache::clear() {
+		_entryByKey.clear();
+		_lru.clear();
+		_sizeInBytes = 0;
+	}
+
+	std::size_t ResponseCache::size() const {
+		return _lru.size();
+	}
+
+	std::size_t ResponseCache::getSizeInBytes() const {
+		return _sizeInBytes;
+	}
+
+	void ResponseCache::_erase(LruList::iterator it) {
+		_entryByKey.erase(Key { it->path, it->statusCode });
+		_sizeInBytes -= it->response->size();
+		_lru.erase(it);
+	}
+}
@@ -1,285 +1,654 @@
-#include <regex>
-#include <ranges>
+#include <algorithm>
+#include <charconv>
 
 #include "http/parser.hpp"
+#include "http/utils.hpp"
 #include "utils/common.hpp"
+#include "utils/scan.hpp"
 
 namespace {
-	void parseRequestLine(const std::string& requestLine, http::Request& request) {
-		std::regex requestLineRegex(R"(^(GET|POST|PUT|DELETE|HEAD|OPTIONS|PATCH|TRACE|CONNECT) (\S+) HTTP\/1\.1$)");
-		std::smatch matches;
+	constexpr std::string_view WHITESPACE(" \t");
 
-		if (!std::regex_match(requestLine, matches, requestLineRegex)) {
-			throw std::invalid_argument("Malformed or invalid request line");
-		}
+	bool isKnownMethod(std::string_view method) {
+		static constexpr std::array<std::string_view, 9> methods {
+			"GET", "POST", "PUT", "DELETE", "HEAD", "OPTIONS", "PATCH", "TRACE", "CONNECT"
+		};
 
-		std::istringstream istream(requestLine);
-		std::string method;
-		std::string uri;
-		std::string version;
+		return std::find(methods.begin(), methods.end(), method) != methods.end();
+	}
 
-		istream >> method >> uri >> version;
+	// A request-target is any non-empty run of visible ASCII characters
+	bool isValidTarget(std::string_view target) {
+		return !target.empty() && std::all_of(target.begin(), target.end(), [](unsigned char c) {
+			return c > 0x20 && c < 0x7f;
+		});
+	}
 
-		request
-			.setMethod(method)
-			.setUri(uri)
-			.setVersion(version);
+	bool isDigits(std::string_view value) {
+		return !value.empty() && std::all_of(value.begin(), value.end(), ::isdigit);
 	}
 
-	void parseRequestHeaderFields(const std::string &headerFields, http::Request& request) {
-		std::istringstream istream(headerFields);
-		std::string line;
+	std::string_view trimWhitespace(std::string_view value) {
+		const std::size_t first = value.find_first_not_of(WHITESPACE);
 
-		while (std::getline(istream, line) && line != "\r") {
-			if (!http::isValidHeaderField(line)) {
-				continue;
-			}
+		if (first == std::string_view::npos) {
+			return {};
+		}
 
-			std::size_t colonPos = line.find(":");
-			std::string name = line.substr(0, colonPos);
-			std::string value = utils::trimSpace(line.substr(colonPos + 1));
+		return value.substr(first, value.find_last_not_of(WHITESPACE) - first + 1);
+	}
 
-			if (name == http::stringOf(http::Header::TRANSFER_ENCODING) && value == "chunked" && request.getMethod() == "GET") {
-				throw std::invalid_argument("Chunked transfer encoding is not allowed in GET requests");
-			}
+	// [user[:password]@]host[:port]
+	void parseAuthority(std::string_view authority, http::Url& url) {
+		const std::size_t atPos = authority.find('@');
 
-			if (name == stringOf(http::Header::CONTENT_LENGTH)) {
-				if (value.empty() || !std::ranges::all_of(value, ::isdigit)) {
-					throw std::invalid_argument("Invalid Content-Length: " + value);
-				}
+		if (atPos != std::string_view::npos) {
+			std::string_view userInfo = authority.substr(0, atPos);
+			const std::size_t colonPos = userInfo.find(':');
 
-				try {
-					request.setContentLength(std::stoull(value));
-				} catch(const std::exception& e) {
-					throw std::invalid_argument("Invalid Content-Length: " + value);
-				}
+			url.user = userInfo.substr(0, colonPos);
+
+			if (colonPos != std::string_view::npos) {
+				url.password = userInfo.substr(colonPos + 1);
+			}
+
+			if (url.user.empty() || url.password.find(':') != std::string::npos) {
+				throw std::invalid_argument("Invalid URL");
 			}
 
-			request.setHeader(name, value);
+			authority.remove_prefix(atPos + 1);
 		}
 
-		if (!request.getHeader(http::Header::HOST).has_value()) {
-			throw std::invalid_argument("No Host found in header request");
+		const std::size_t colonPos = authority.find(':');
+		std::string_view host = authority.substr(0, colonPos);
+
+		if (host.empty() || host.find_first_of("/?#@") != std::string_view::npos) {
+			throw std::invalid_argument("Invalid URL");
+		}
+
+		url.host = host;
+
+		if (colonPos != std::string_view::npos) {
+			std::string_view port = authority.substr(colonPos + 1);
+
+			if (!isDigits(port)) {
+				throw std::invalid_argument("Invalid URL");
+			}
+
+			url.port = port;
 		}
 	}
 
-	std::size_t parseChunkSize(std::string chunkSizeLine) {
-		std::size_t semicolonPos = chunkSizeLine.find(";");
+	// [/path][?query][#fragment]
+	void parsePathAndQuery(std::string_view target, http::Url& url) {
+		const std::size_t fragmentPos = target.find('#');
 
-		if (semicolonPos != std::string::npos) {
-			chunkSizeLine = chunkSizeLine.substr(0, semicolonPos);
+		if (fragmentPos != std::string_view::npos) {
+			url.fragment = target.substr(fragmentPos + 1);
+			target = target.substr(0, fragmentPos);
 		}
 
-		std::size_t chunkSize;
-		std::istringstream stream(chunkSizeLine);
+		const std::size_t queryPos = target.find('?');
 
-		if (!(stream >> std::hex >> chunkSize)) {
-			throw std::invalid_argument("Invalid chunk size");
+		if (queryPos != std::string_view::npos) {
+			url.query = target.substr(queryPos + 1);
+			target = target.substr(0, queryPos);
 		}
 
-		return chunkSize;
+		if (!target.empty() && target.front() != '/') {
+			throw std::invalid_argument("Invalid URL");
+		}
+
+		url.path = target;
 	}
 
-	void dechunk(std::vector<uint8_t>& buffer, http::Request& request, std::size_t clientMaxBodySize) {
-		std::vector<uint8_t> rawData;
-		bool isChunkEnd = false;
-		auto begin = buffer.begin();
-		auto end = buffer.end();
-		auto currentPos = begin;
+	// The value of a hex digit, or -1
+	int hexValue(std::uint8_t byte) {
+		if (byte >= '0' && byte <= '9') {
+			return byte - '0';
+		}
+
+		byte |= 0x20;
+
+		if (byte >= 'a' && byte <= 'f') {
+			return byte - 'a' + 10;
+		}
+
+		return -1;
+	}
 
-		rawData.reserve(buffer.size());
+	// The value of parameter `name` in a Content-Disposition, unquoted
+	std::string parameterOf(std::string_view value, std::string_view name) {
+		std::size_t pos = value.find(';');
 
-		while (true) {
-			auto delimPos = utils::findDelimiter(currentPos, end, {'\r', '\n'});
+		while (pos != std::string_view::npos) {
+			std::size_t start = value.find_first_not_of(" \t", pos + 1);
 
-			if (delimPos == end || std::distance(delimPos, end) < 2) {
+			if (start == std::string_view::npos) {
 				break;
 			}
 
-			std::size_t chunkSize = parseChunkSize(std::string(currentPos, delimPos));
-			std::size_t distance = static_cast<std::size_t>(std::distance(delimPos + 2, end));
+			const std::size_t equalPos = value.find('=', start);
 
-			if (distance < chunkSize + 2) {
+			if (equalPos == std::string_view::npos) {
 				break;
 			}
 
-			currentPos = delimPos + 2;
+			const bool isName = utils::lowerCase(utils::trimSpace(std::string(value.substr(start, equalPos - start)))) == name;
+			std::string parameter;
 
-			if (chunkSize == 0) {
-				if (*currentPos == '\r' && *(currentPos + 1) == '\n') {
-					isChunkEnd = true;
-					currentPos += 2;
-					break;
+			pos = equalPos + 1;
+
+			if (pos < value.size() && value[pos] == '"') {
+				for (pos++; pos < value.size() && value[pos] != '"'; pos++) {
+					if (value[pos] == '\\' && pos + 1 < value.size()) {
+						pos++;
+					}
+
+					parameter += value[pos];
+				}
+
+				pos = value.find(';', pos);
+			} else {
+				const std::size_t end = value.find(';', pos);
+
+				parameter = utils::trimSpace(std::string(value.substr(pos, end - pos)));
+				pos = end;
+			}
+
+			if (isName) {
+				return parameter;
+			}
+		}
+
+		return "";
+	}
+
+	// Only Content-Disposition and Content-Type mean anything for a part
+	void parsePartHeader(std::string_view header, http::MultipartElement& part) {
+		std::size_t start = 0;
+
+		while (start < header.size()) {
+			std::size_t end = header.find("\r\n", start);
+
+			if (end == std::string_view::npos) {
+				end = header.size();
+			}
+
+			const std::string_view line = header.substr(start, end - start);
+			const std::size_t colonPos = line.find(':');
+
+			if (colonPos == std::string_view::npos) {
+				throw std::invalid_argument("Error: Bad multipart header field");
+			}
+
+			const std::string name = utils::lowerCase(std::string(line.substr(0, colonPos)));
+			const std::string value = utils::trimSpace(std::string(line.substr(colonPos + 1)));
+
+			if (name == "content-disposition") {
+				part.name = parameterOf(value, "name");
+				part.fileName = parameterOf(value, "filename");
+			} else if (name == "content-type") {
+				part.contentType = value;
+			}
+
+			start = end + 2;
+		}
+	}
+}
+
+namespace http {
+	void RequestParser::parseHeader(utils::ReceiveBuffer& buffer, Request& request) {
+		const char* data = reinterpret_cast<const char*>(buffer.data());
+
+		while (_scanned < buffer.size()) {
+			const char* lineFeed = utils::findByte(data + _scanned, data + buffer.size(), '\n');
+
+			if (lineFeed == data + buffer.size()) {
+				_scanned = buffer.size();
+				break;
+			}
+
+			const std::size_t lineEnd = lineFeed - data;
+			std::string_view line(data + _lineStart, lineEnd - _lineStart);
+
+			if (!line.empty() && line.back() == '\r') {
+				line.remove_suffix(1);
+			}
+
+			_scanned = lineEnd + 1;
+			_lineStart = _scanned;
+
+			if (_scanned > MAX_REQUEST_HEADER_SIZE) {
+				throw std::invalid_argument("Request header too large");
+			}
+
+			if (_state == State::REQUEST_LINE) {
+				// Empty lines before the request line are ignored (RFC 9112, 2.2)
+				if (!line.empty()) {
+					_parseRequestLine(request.storeHeaderBytes(line), request);
+					_state = State::HEADER_FIELDS;
 				}
+				continue;
+			}
 
-				throw std::invalid_argument(R"(Error: Chunk body did not end with 0\r\n\r\n)");
+			if (line.empty()) {
+				_finish(request);
+				buffer.consume(_scanned);
+				reset();
+				return;
 			}
 
-			rawData.insert(rawData.end(), currentPos, currentPos + chunkSize);
-			currentPos += chunkSize + 2;
+			_parseHeaderField(line, request);
 		}
 
-		if (request.getRawBody().size() + rawData.size() >= clientMaxBodySize) {
-			throw std::invalid_argument("Exceeded request max body size");
+		if (_scanned >= MAX_REQUEST_HEADER_SIZE) {
+			throw std::invalid_argument("Request header too large");
 		}
+	}
+
+	void RequestParser::reset() {
+		_state = State::REQUEST_LINE;
+		_lineStart = 0;
+		_scanned = 0;
+	}
 
-		request.setRawBody(
-			std::make_move_iterator(rawData.begin()),
-			std::make_move_iterator(rawData.end()),
-			true
-		);
+	// method SP request-target SP HTTP/1.1
+	void RequestParser::_parseRequestLine(std::string_view line, Request& request) {
+		const std::size_t methodEnd = line.find(' ');
+		const std::size_t targetEnd = line.find(' ', methodEnd + 1);
 
-		if (isChunkEnd) {
-			request.setStatus(http::Request::Status::COMPLETE);
+		if (methodEnd == std::string_view::npos || targetEnd == std::string_view::npos) {
+			throw std::invalid_argument("Malformed or invalid request line");
 		}
 
-		buffer.erase(begin, currentPos);
+		std::string_view method = line.substr(0, methodEnd);
+		std::string_view target = line.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+		std::string_view version = line.substr(targetEnd + 1);
+
+		if (!isKnownMethod(method) || !isValidTarget(target) || version != "HTTP/1.1") {
+			throw std::invalid_argument("Malformed or invalid request line");
+		}
+
+		request
+			.setMethod(method)
+			.setUri(target)
+			.setVersion(version);
 	}
 
-	void parseMultipartHeader(const std::string& header, http::MultipartElement& element) {
-		std::istringstream istream(header);
-		std::string line;
-		std::size_t startPos;
-		std::size_t endPos;
-
-		std::getline(istream, line);
-		std::getline(istream, line);
-		startPos = line.find("name=");
-		endPos = line.find(";", startPos);
-		element.name = utils::trimSpace(line.substr(startPos + 5, endPos - startPos - 5));
-
-		if (element.name.front() == '"' && element.name.back() == '"') {
-			if (element.name.size() == 2) {
-				element.name = "";
-			} else if (element.name.size() > 2) {
-				element.name = element.name.substr(1, element.name.size() - 2);
-			}
+	// Lines that are not a well-formed field, or name a header we do not
+	// know, are skipped rather than rejected. Only the values of known
+	// headers are copied into the header block of the request.
+	void RequestParser::_parseHeaderField(std::string_view line, Request& request) {
+		const std::size_t colonPos = line.find(':');
+
+		if (colonPos == std::string_view::npos || !isToken(line.substr(0, colonPos))) {
+			return;
+		}
+
+		const std::optional<Header> header = findHeader(line.substr(0, colonPos));
+
+		if (!header.has_value()) {
+			return;
+		}
+
+		std::string_view value = request.storeHeaderBytes(trimWhitespace(line.substr(colonPos + 1)));
+
+		if (*header == Header::TRANSFER_ENCODING && value == "chunked" && request.getMethod() == "GET") {
+			throw std::invalid_argument("Chunked transfer encoding is not allowed in GET requests");
 		}
 
-		startPos = line.find("filename=");
-		element.fileName = utils::trimSpace(line.substr(startPos + 9));
+		if (*header == Header::CONTENT_LENGTH) {
+			std::size_t contentLength = 0;
+			const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), contentLength);
 
-		if (element.fileName.front() == '"' && element.fileName.back() == '"') {
-			if (element.fileName.size() == 2) {
-				element.fileName = "";
-			} else if (element.fileName.size() > 2) {
-				element.fileName = element.fileName.substr(1, element.fileName.size() - 2);
+			if (!isDigits(value) || error != std::errc() || end != value.data() + value.size()) {
+				throw std::invalid_argument("Invalid Content-Length: " + std::string(value));
 			}
+
+			request.setContentLength(contentLength);
 		}
 
-		std::getline(istream, line);
-		startPos = line.find(":");
-		element.contentType = utils::trimSpace(line.substr(startPos + 1));
+		request.setHeader(*header, value);
 	}
-}
 
-namespace http {
-	Url parseUrl(const std::string& fullUrl) {
-		Url result;
+	void RequestParser::_finish(Request& request) {
+		const std::optional<std::string_view> host = request.getHeader(Header::HOST);
+
+		if (!host.has_value()) {
+			throw std::invalid_argument("No Host found in header request");
+		}
 
-		std::regex urlRegex(R"((https?://)?(?:([^:@]+)(?::([^:@]*))?@)?([^:/?#]+)(?::(\d+))?(/[^?#]*)?(?:\?([^#]*))?(?:#(.*))?)");
-		std::smatch matches;
+		const std::string_view target = request.getUri();
+		Url url;
 
-		if (!std::regex_match(fullUrl, matches, urlRegex)) {
+		if (target.starts_with("http://") || target.starts_with("https://")) {
+			url = parseUrl(target);
+		} else if (target.front() == '/') {
+			parseAuthority(*host, url);
+			parsePathAndQuery(target, url);
+		} else {
 			throw std::invalid_argument("Invalid URL");
 		}
 
-		result.scheme = matches[1].str();
-		result.user = matches[2].str();
-		result.password = matches[3].str();
-		result.host = matches[4].str();
-		result.port = matches[5].str();
-		result.path = matches[6].str();
-		result.query = matches[7].str();
-		result.fragment = matches[8].str();
+		request.setUrl(url).setStatus(Request::Status::HEADER_COMPLETE);
+	}
+
+	// [http[s]://][user[:password]@]host[:port][/path][?query][#fragment]
+	Url parseUrl(std::string_view fullUrl) {
+		Url result;
+
+		if (fullUrl.starts_with("https://")) {
+			result.scheme = "https";
+			fullUrl.remove_prefix(8);
+		} else if (fullUrl.starts_with("http://")) {
+			result.scheme = "http";
+			fullUrl.remove_prefix(7);
+		}
+
+		const std::size_t authorityEnd = fullUrl.find_first_of("/?#");
+
+		parseAuthority(fullUrl.substr(0, authorityEnd), result);
+
+		if (authorityEnd != std::string_view::npos) {
+			parsePathAndQuery(fullUrl.substr(authorityEnd), result);
+		}
+
 		return result;
 	}
 
-	void parseRequestHeader(std::vector<uint8_t>& buffer, Request& request) {
-		std::string crlf("\r\n");
-		std::string emptyLine("\r\n\r\n");
+	// Nothing is taken while the consumer is behind: the bytes stay in the
+	// buffer, and the connection stops reading.
+	ChunkDecoder::ChunkDecoder(std::size_t maxBodySize) : _maxBodySize(maxBodySize) {
+	}
+
+	// Only the framing is looked at byte by byte; chunk data goes through
+	// in one append per read, as much of it as there is.
+	std::size_t ChunkDecoder::decode(const std::uint8_t* data, std::size_t size, RequestBody& body) {
+		std::size_t pos = 0;
 
-		auto begin = buffer.begin();
-		auto end = buffer.end();
-		auto delim = std::search(begin, end, emptyLine.begin(), emptyLine.end());
+		while (pos < size && _state != State::DONE) {
+			if (_state != State::DATA) {
+				_parseFraming(data[pos++], body);
+				continue;
+			}
 
-		if (delim == end) {
-			if (buffer.size() >= MAX_REQUEST_HEADER_SIZE) {
-				request.setStatus(Request::Status::BAD);
+			if (body.isFull()) {
+				break;
+			}
+
+			const std::size_t length = std::min(_remaining, size - pos);
+
+			body.append(data + pos, length);
+			pos += length;
+			_remaining -= length;
+
+			if (_remaining == 0) {
+				_state = State::DATA_CR;
 			}
-			return;
 		}
 
-		auto current = std::search(begin, end, crlf.begin(), crlf.end());
+		if (_state == State::DONE) {
+			body.complete();
+		}
 
-		parseRequestLine(std::string(begin, current), request);
-		parseRequestHeaderFields(std::string(current + 2, delim + 4), request);
+		return pos;
+	}
 
-		Url url = parseUrl(request.getHeader(Header::HOST).value_or("") + request.getUri());
+	bool ChunkDecoder::isComplete() const {
+		return _state == State::DONE;
+	}
 
-		request.setUrl(url).setStatus(Request::Status::HEADER_COMPLETE);
-		buffer.erase(begin, delim + 4);
+	// chunk-size [ chunk-ext ] CRLF chunk-data CRLF, ending with a chunk of
+	// size 0 and the trailer section
+	void ChunkDecoder::_parseFraming(std::uint8_t byte, const RequestBody& body) {
+		using enum State;
+
+		if (_state != DATA_CR && _state != DATA_LF && ++_lineSize > MAX_LINE_SIZE) {
+			throw std::invalid_argument("Chunk size line or trailer section too large");
+		}
+
+		switch (_state) {
+			case SIZE: {
+				const int digit = hexValue(byte);
+
+				if (digit >= 0) {
+					if (_remaining > (SIZE_MAX >> 4)) {
+						throw std::invalid_argument("Invalid chunk size");
+					}
+
+					_remaining = (_remaining << 4) | static_cast<std::size_t>(digit);
+					break;
+				}
+
+				if (_lineSize == 1 || (byte != '\r' && byte != ';' && byte != ' ' && byte != '\t')) {
+					throw std::invalid_argument("Invalid chunk size");
+				}
+
+				if (_remaining >= _maxBodySize || body.getReceived() + _remaining >= _maxBodySize) {
+					throw std::invalid_argument("Exceeded request max body size");
+				}
+
+				_state = (byte == '\r') ? SIZE_LF : EXTENSION;
+				break;
+			}
+			case EXTENSION:
+				if (byte == '\r') {
+					_state = SIZE_LF;
+				}
+				break;
+			case SIZE_LF:
+				if (byte != '\n') {
+					throw std::invalid_argument("Chunk size line not ended by CRLF");
+				}
+
+				_lineSize = 0;
+				_state = (_remaining == 0) ? TRAILER : DATA;
+				break;
+			case DATA_CR:
+			case DATA_LF:
+				if (byte != (_state == DATA_CR ? '\r' : '\n')) {
+					throw std::invalid_argument("Chunk data not followed by CRLF");
+				}
+
+				_state = (_state == DATA_CR) ? DATA_LF : SIZE;
+				break;
+			case TRAILER:
+				_state = (byte == '\r') ? TRAILER_LF : TRAILER_FIELD;
+				break;
+			case TRAILER_FIELD:
+				if (byte == '\n') {
+					_state = TRAILER;
+				}
+				break;
+			case TRAILER_LF:
+				if (byte != '\n') {
+					throw std::invalid_argument(R"(Chunked body not ended by \r\n)");
+				}
+
+				_state = DONE;
+				break;
+			default:
+				break;
+		}
 	}
 
-	void parseRequestBody(std::vector<uint8_t>& buffer, Request& request, std::size_t clientMaxBodySize) {
-		// std::cout << "parseRequestBody() called" << std::endl;
-		if (request.isChunkEncoding()) {
-			return dechunk(buffer, request, clientMaxBodySize);
+	std::size_t parseRequestBody(const std::uint8_t* data, std::size_t size, RequestBody& body, ChunkDecoder& decoder) {
+		if (body.getLength() == RequestBody::UNKNOWN_LENGTH) {
+			return decoder.decode(data, size, body);
 		}
 
-		std::size_t contentLength = request.getContentLength();
+		if (body.isFull()) {
+			return 0;
+		}
+
+		const std::size_t length = std::min(body.getLength() - body.getReceived(), size);
+
+		body.append(data, length);
 
-		if (contentLength >= clientMaxBodySize) {
-			std::cout << "Exceeded request max body size" << std::endl;
-			throw std::invalid_argument("Exceeded request max body size");
+		if (body.getReceived() == body.getLength()) {
+			body.complete();
 		}
 
-		if (buffer.size() < contentLength) {
-			return;
+		return length;
+	}
+
+	MultipartParser::MultipartParser(std::string_view boundary, PartHandler onPart, DataHandler onData, EndHandler onPartEnd)
+		: _delimiter("\r\n--" + std::string(boundary))
+		, _onPart(std::move(onPart))
+		, _onData(std::move(onData))
+		, _onPartEnd(std::move(onPartEnd)) {
+	}
+
+	std::size_t MultipartParser::parse(const std::uint8_t* data, std::size_t size) {
+		std::size_t parsed = 0;
+
+		while (parsed < size) {
+			const std::size_t step = _parseStep(data + parsed, size - parsed);
+
+			if (step == 0) {
+				break;
+			}
+
+			parsed += step;
 		}
 
-		request
-			.setRawBody(
-				std::make_move_iterator(buffer.begin()),
-				std::make_move_iterator(buffer.begin() + contentLength),
-				false
-			)
-			.setStatus(Request::Status::COMPLETE);
-
-		if (request.isMultipart()) {
-			std::cout << "request.isMultipart" << std::endl;
-			std::string finalBoundary("--" + request.getBoundary() + "--\r\n");
-			auto begin = request.getRawBody().begin();
-			auto end = request.getRawBody().end();
-
-			if (std::search(begin, end, finalBoundary.begin(), finalBoundary.end()) == end) {
-				std::cout << "Could not find finalBoundary" << finalBoundary << std::endl;
-				request.setStatus(Request::Status::BAD);
+		return parsed;
+	}
+
+	bool MultipartParser::isComplete() const {
+		return _state == State::EPILOGUE;
+	}
+
+	std::size_t MultipartParser::_parseStep(const std::uint8_t* data, std::size_t size) {
+		switch (_state) {
+			case State::PREAMBLE:
+				return _parsePreamble(data, size);
+			case State::BOUNDARY:
+				return _parseBoundary(data, size);
+			case State::PART_HEADER:
+				return _parsePartHeader(data, size);
+			case State::PART_DATA:
+				return _parsePartData(data, size);
+			case State::EPILOGUE:
+			default:
+				return size;
+		}
+	}
+
+	// The first boundary usually opens the body, without the CRLF that
+	// belongs to the ones after it.
+	std::size_t MultipartParser::_parsePreamble(const std::uint8_t* data, std::size_t size) {
+		if (_isAtStart) {
+			const std::string_view dashBoundary = std::string_view(_delimiter).substr(2);
+			const std::size_t length = std::min(size, dashBoundary.size());
+
+			if (std::equal(data, data + length, dashBoundary.begin())) {
+				if (length < dashBoundary.size()) {
+					return 0;
+				}
+
+				_isAtStart = false;
+				_state = State::BOUNDARY;
+				return dashBoundary.size();
+			}
+
+			_isAtStart = false;
+		}
+
+		const std::uint8_t* delimiter = utils::findSequence(data, data + size, _delimiter);
+
+		if (delimiter == data + size) {
+			return (size >= _delimiter.size()) ? size - _delimiter.size() + 1 : 0;
+		}
+
+		_state = State::BOUNDARY;
+		return delimiter - data + _delimiter.size();
+	}
+
+	// "--" ends the body; otherwise the line ends, after optional padding.
+	std::size_t MultipartParser::_parseBoundary(const std::uint8_t* data, std::size_t size) {
+		if (size < 2) {
+			return 0;
+		}
+
+		if (data[0] == '-' && data[1] == '-') {
+			_state = State::EPILOGUE;
+			return 2;
+		}
+
+		std::size_t pos = 0;
+
+		while (pos < size && (data[pos] == ' ' || data[pos] == '\t')) {
+			pos++;
+		}
+
+		if (pos > MAX_HEADER_SIZE) {
+			throw std::invalid_argument("Error: Multipart boundary line too long");
+		}
+
+		if (size - pos < 2) {
+			return 0;
+		}
+
+		if (data[pos] != '\r' || data[pos + 1] != '\n') {
+			throw std::invalid_argument("Error: Bad multipart boundary line");
+		}
+
+		_state = State::PART_HEADER;
+		return pos + 2;
+	}
+
+	std::size_t MultipartParser::_parsePartHeader(const std::uint8_t* data, std::size_t size) {
+		MultipartElement part;
+		std::size_t headerSize = 0;
+
+		if (size < 2) {
+			return 0;
+		}
+
+		// A part without any header field starts with the empty line
+		if (data[0] != '\r' || data[1] != '\n') {
+			const std::uint8_t* end = utils::findSequence(data, data + size, "\r\n\r\n");
+
+			if (end == data + size) {
+				if (size > MAX_HEADER_SIZE) {
+					throw std::invalid_argument("Error: Multipart header too long");
+				}
+
+				return 0;
 			}
+
+			headerSize = end - data + 2;
+			parsePartHeader(std::string_view(reinterpret_cast<const char*>(data), headerSize - 2), part);
 		}
+
+		_state = State::PART_DATA;
+		_onPart(part);
+		return headerSize + 2;
 	}
 
-	std::vector<MultipartElement> parseMultipart(const std::vector<uint8_t>& rawMultipart, const std::string& boundary) {
-		std::vector<MultipartElement> elements;
-		std::string startBoundary("--" + boundary);
-		std::string finalBoundary("--" + boundary + "--\r\n");
-		std::string emptyLine("\r\n\r\n");
+	// What could be the start of a delimiter is held back until the bytes
+	// after it show whether it is one.
+	std::size_t MultipartParser::_parsePartData(const std::uint8_t* data, std::size_t size) {
+		const std::uint8_t* delimiter = utils::findSequence(data, data + size, _delimiter);
+
+		if (delimiter == data + size) {
+			const std::size_t safeSize = (size >= _delimiter.size()) ? size - _delimiter.size() + 1 : 0;
 
-		auto begin = rawMultipart.begin();
-		auto end = std::search(begin, rawMultipart.end(), finalBoundary.begin(), finalBoundary.end());
-		auto current = begin;
+			if (safeSize > 0) {
+				_onData(data, safeSize);
+			}
+
+			return safeSize;
+		}
 
-		while (begin != end) {
-			MultipartElement element;
-			current = std::search(begin, end, emptyLine.begin(), emptyLine.end());
-			parseMultipartHeader(std::string(begin, current + 2), element);
-			begin = current + 4;
-			current = std::search(begin, end, startBoundary.begin(), startBoundary.end());
-			element.rawData.insert(element.rawData.end(), begin, current);
-			elements.push_back(element);
-			begin = current;
+		if (delimiter > data) {
+			_onData(data, delimiter - data);
 		}
 
-		return elements;
+		_state = State::BOUNDARY;
+		_onPartEnd();
+		return delimiter - data + _delimiter.size();
 	}
 }
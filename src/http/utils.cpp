@@ -1,136 +1,14 @@
-#include <sstream>
-#include <regex>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cctype>
 #include "utils/common.hpp"
 #include "http/utils.hpp"
+#include "http/MimeTypes.hpp"
 
-namespace http {
-	std::string getMimeType(const std::string &extension) {
-		if (extension == "aac") return "audio/aac";
-		if (extension == "abw") return "application/x-abiword";
-		if (extension == "apng") return "image/apng";
-		if (extension == "arc") return "application/x-freearc";
-		if (extension == "avif") return "image/avif";
-		if (extension == "avi") return "video/x-msvideo";
-		if (extension == "bin") return "application/octet-stream";
-		if (extension == "bmp") return "image/bmp";
-		if (extension == "bz") return "application/x-bzip";
-		if (extension == "bz2") return "application/x-bzip2";
-		if (extension == "cda") return "application/x-cdf";
-		if (extension == "csh") return "application/x-csh";
-		if (extension == "css") return "text/css; charset=utf-8";
-		if (extension == "csv") return "text/csv; charset=utf-8";
-		if (extension == "doc") return "application/msword";
-		if (extension == "epub") return "application/epub+zip";
-		if (extension == "gz") return "application/gzip";
-		if (extension == "gif") return "image/gif";
-		if (extension == "htm" || extension == "html") return "text/html; charset=utf-8";
-		if (extension == "jar") return "application/java-archive";
-		if (extension == "jpeg" || extension == "jpg") return "image/jpeg";
-		if (extension == "js") return "text/javascript; charset=utf-8";
-		if (extension == "json") return "application/json; charset=utf-8";
-		if (extension == "jsonld") return "application/ld+json; charset=utf-8";
-		if (extension == "mid" || extension == "midi") return "audio/midi";
-		if (extension == "mjs") return "text/javascript; charset=utf-8";
-		if (extension == "mp3") return "audio/mpeg";
-		if (extension == "mp4") return "video/mp4";
-		if (extension == "mpeg") return "video/mpeg";
-		if (extension == "oga") return "audio/ogg";
-		if (extension == "ogv") return "video/ogg";
-		if (extension == "ogx") return "application/ogg";
-		if (extension == "opus") return "audio/ogg";
-		if (extension == "otf") return "font/otf";
-		if (extension == "png") return "image/png";
-		if (extension == "pdf") return "application/pdf";
-		if (extension == "php") return "application/x-httpd-php";
-		if (extension == "rar") return "application/vnd.rar";
-		if (extension == "rtf") return "application/rtf";
-		if (extension == "sh") return "application/x-sh";
-		if (extension == "svg") return "image/svg+xml";
-		if (extension == "tar") return "application/x-tar";
-		if (extension == "tif" || extension == "tiff") return "image/tiff";
-		if (extension == "ts") return "video/mp2t";
-		if (extension == "ttf") return "font/ttf";
-		if (extension == "txt") return "text/plain; charset=utf-8";
-		if (extension == "wav") return "audio/wav";
-		if (extension == "weba") return "audio/webm";
-		if (extension == "webm") return "video/webm";
-		if (extension == "webp") return "image/webp";
-		if (extension == "woff") return "font/woff";
-		if (extension == "woff2") return "font/woff2";
-		if (extension == "xhtml") return "application/xhtml+xml";
-		if (extension == "xml") return "application/xml; charset=utf-8";
-		if (extension == "zip") return "application/zip";
-		if (extension == "7z") return "application/x-7z-compressed";
-		return "text/plain; charset=utf-8";
-	}
-
-	std::string getExtensionFromMimeType(const std::string& mime) {
-		if (mime.starts_with("application/x-abiword")) return ".abw";
-		if (mime.starts_with("application/x-freearc")) return ".arc";
-		if (mime.starts_with("application/octet-stream")) return ".bin";
-		if (mime.starts_with("application/x-bzip")) return ".bz";
-		if (mime.starts_with("application/x-bzip2")) return ".bz2";
-		if (mime.starts_with("application/x-cdf")) return ".cda";
-		if (mime.starts_with("application/x-csh")) return ".csh";
-
-		if (mime.starts_with("text/css")) return ".css";
-		if (mime.starts_with("text/csv")) return ".csv";
-		if (mime.starts_with("text/markdown")) return ".md";
-		if (mime.starts_with("text/html")) return ".html";
-		if (mime.starts_with("text/javascript")) return ".js";
-		if (mime.starts_with("text/plain")) return ".txt";
-
-		if (mime.starts_with("image/apng")) return ".apng";
-		if (mime.starts_with("image/bmp")) return ".bmp";
-		if (mime.starts_with("image/avif")) return ".avif";
-		if (mime.starts_with("image/jpeg") || mime.starts_with("image/jpg")) return ".jpeg";
-		if (mime.starts_with("image/gif")) return ".gif";
-		if (mime.starts_with("image/tiff")) return ".tiff";
-		if (mime.starts_with("image/png")) return ".png";
-		if (mime.starts_with("image/svg+xml")) return ".svg";
-		if (mime.starts_with("image/webp")) return ".webp";
-
-		if (mime.starts_with("application/msword")) return ".doc";
-		if (mime.starts_with("application/epub+zip")) return ".epub";
-		if (mime.starts_with("application/gzip")) return ".gz";
-		if (mime.starts_with("application/java-archive")) return ".jar";
-		if (mime.starts_with("application/json")) return ".json";
-
-		if (mime.starts_with("audio/aac")) return ".aac";
-		if (mime.starts_with("audio/midi")) return ".midi";
-		if (mime.starts_with("audio/mpeg")) return ".mp3";
-		if (mime.starts_with("audio/ogg")) return ".oga";
-		if (mime.starts_with("audio/ogg")) return ".opus";
-		if (mime.starts_with("audio/wav")) return ".wav";
-		if (mime.starts_with("audio/webm")) return ".weba";
-
-		if (mime.starts_with("video/mp4")) return ".mp4";
-		if (mime.starts_with("video/mpeg")) return ".mpeg";
-		if (mime.starts_with("video/ogg")) return ".ogv";
-		if (mime.starts_with("video/webm")) return ".webm";
-		if (mime.starts_with("video/x-msvideo")) return ".avi";
-
-		if (mime.starts_with("application/ogg")) return ".ogx";
-		if (mime.starts_with("font/otf")) return ".otf";
-		if (mime.starts_with("application/pdf")) return ".pdf";
-		if (mime.starts_with("application/x-httpd-php")) return ".php";
-		if (mime.starts_with("application/vnd.rar")) return ".rar";
-		if (mime.starts_with("rtf")) return ".application/rtf";
-		if (mime.starts_with("sh")) return ".application/x-sh";
-		if (mime.starts_with("application/x-tar")) return ".tar";
-		if (mime.starts_with("ts")) return ".video/mp2t";
-		if (mime.starts_with("font/ttf")) return ".ttf";
-		if (mime.starts_with("font/woff")) return ".woff";
-		if (mime.starts_with("font/woff2")) return ".woff2";
-		if (mime.starts_with("application/xhtml+xml")) return ".xhtml";
-		if (mime.starts_with("application/xml")) return ".xml";
-		if (mime.starts_with("application/zip")) return ".zip";
-		if (mime.starts_with("application/x-7z-compressed")) return ".7z";
-		return ".bin";
-	}
-
-	std::string stringOf(Header header) {
-		using enum Header;
+namespace {
+	constexpr std::string_view nameOf(http::Header header) {
+		using enum http::Header;
 
 		switch (header) {
 			case CONTENT_TYPE: return "Content-Type";
@@ -148,7 +26,7 @@ namespace http {
 			case MAX_FORWARDS: return "Max-Forwards";
 			case PRAGMA: return "Pragma";
 			case RANGE: return "Range";
-			case TE: return "Te";
+			case TE: return "TE";
 			case IF_MATCH: return "If-Match";
 			case IF_NONE_MATCH: return "If-None-Match";
 			case IF_MODIFIED_SINCE: return "If-Modified-Since";
@@ -170,19 +48,19 @@ namespace http {
 			case RETRY_AFTER: return "Retry-After";
 			case VARY: return "Vary";
 			case WARNING: return "Warning";
-			case ETAG: return "Etag";
+			case ETAG: return "ETag";
 			case LAST_MODIFIED: return "Last-Modified";
-			case WWW_AUTHENTICATE: return "Www-Authenticate";
+			case WWW_AUTHENTICATE: return "WWW-Authenticate";
 			case PROXY_AUTHENTICATE: return "Proxy-Authenticate";
 			case ACCEPT_RANGES: return "Accept-Ranges";
 			case ALLOW: return "Allow";
 			case SERVER: return "Server";
-			case MIME_VERSION: return "Mime-Version";
+			case MIME_VERSION: return "MIME-Version";
 			default: return "Unknown";
 		}
 	}
 
-	std::string stringOf(StatusCode code) {
+	constexpr std::string_view reasonPhraseOf(http::StatusCode code) {
 		using enum http::StatusCode;
 
 		switch (code) {
@@ -216,7 +94,7 @@ namespace http {
 			case LENGTH_REQUIRED_411: return "Length Required";
 			case PRECONDITION_FAILED_412: return "Precondition Failed";
 			case CONTENT_TOO_LARGE_413: return "Content Too Large";
-			case URI_TOO_LONG_414: return "Uri Too Long";
+			case URI_TOO_LONG_414: return "URI Too Long";
 			case UNSUPPORTED_MEDIA_TYPE_415: return "Unsupported Media Type";
 			case RANGE_NOT_SATISFIABLE_416: return "Range Not Satisfiable";
 			case EXPECTATION_FAILED_417: return "Expectation Failed";
@@ -226,36 +104,142 @@ namespace http {
 			case BAD_GATEWAY_502: return "Bad Gateway";
 			case SERVICE_UNAVAILABLE_503: return "Service Unavailable";
 			case GATEWAY_TIMEOUT_504: return "Gateway Timeout";
-			case HTTP_VERSION_NOT_SUPPORTED_505: return "Http Version Not Supported";
+			case HTTP_VERSION_NOT_SUPPORTED_505: return "HTTP Version Not Supported";
 			default: return "Unknown";
 		}
 	}
 
-	bool hasHeaderName(const std::string &headerName) {
-		for (int i = 0; i < static_cast<int>(Header::LENGTH); i++) {
-			Header header = static_cast<Header>(i);
+	constexpr std::size_t HEADER_COUNT = static_cast<std::size_t>(http::Header::LENGTH);
+
+	constexpr std::array<std::string_view, HEADER_COUNT> HEADER_NAMES = [] {
+		std::array<std::string_view, HEADER_COUNT> names {};
+
+		for (std::size_t i = 0; i < HEADER_COUNT; i++) {
+			names[i] = nameOf(static_cast<http::Header>(i));
+		}
+
+		return names;
+	}();
+
+	// "HTTP/1.1 200 OK\r\n" and the like, for every code with a reason phrase
+	struct StatusLine {
+		std::uint16_t code;
+		std::uint8_t size;
+		std::array<char, 48> text;
+	};
+
+	constexpr std::uint16_t MIN_STATUS_CODE = 100;
+	constexpr std::uint16_t MAX_STATUS_CODE = 599;
+
+	constexpr bool hasReasonPhrase(std::uint16_t code) {
+		return reasonPhraseOf(static_cast<http::StatusCode>(code)) != "Unknown";
+	}
+
+	constexpr std::size_t STATUS_LINE_COUNT = [] {
+		std::size_t count = 0;
+
+		for (std::uint16_t code = MIN_STATUS_CODE; code <= MAX_STATUS_CODE; code++) {
+			count += hasReasonPhrase(code);
+		}
+
+		return count;
+	}();
+
+	constexpr std::array<StatusLine, STATUS_LINE_COUNT> STATUS_LINES = [] {
+		std::array<StatusLine, STATUS_LINE_COUNT> lines {};
+		std::size_t count = 0;
 
-			if (utils::lowerCase(stringOf(header)) == utils::lowerCase(headerName)) {
-				return true;
+		for (std::uint16_t code = MIN_STATUS_CODE; code <= MAX_STATUS_CODE; code++) {
+			if (!hasReasonPhrase(code)) {
+				continue;
 			}
+
+			StatusLine& line = lines[count++];
+			const std::string_view parts[] = { "HTTP/1.1 ", "", " ", reasonPhraseOf(static_cast<http::StatusCode>(code)), "\r\n" };
+			const char digits[] = { static_cast<char>('0' + code / 100), static_cast<char>('0' + code / 10 % 10), static_cast<char>('0' + code % 10) };
+			std::size_t size = 0;
+
+			line.code = code;
+
+			for (std::size_t i = 0; i < std::size(parts); i++) {
+				const std::string_view part = (i == 1) ? std::string_view(digits, 3) : parts[i];
+
+				for (char c : part) {
+					line.text[size++] = c;
+				}
+			}
+
+			line.size = static_cast<std::uint8_t>(size);
 		}
 
-		return false;
+		return lines;
+	}();
+}
+
+namespace http {
+	std::string_view getMimeType(std::string_view extension) {
+		return MimeTypes::global().typeOf(extension);
 	}
 
-	bool isValidHeaderField(const std::string &headerField) {
-		std::regex headerFieldRegex(R"(^([a-zA-Z0-9!#$%&'*+.^_`|~-]+):\s*(.*)\s*$)");
+	std::string_view getExtensionFromMimeType(std::string_view mime) {
+		return MimeTypes::global().extensionOf(mime);
+	}
 
-		if (!std::regex_match(headerField, headerFieldRegex)) {
-			return false;
+	std::string_view stringOf(Header header) {
+		const std::size_t index = static_cast<std::size_t>(header);
+
+		return index < HEADER_COUNT ? HEADER_NAMES[index] : "Unknown";
+	}
+
+	std::string_view stringOf(StatusCode code) {
+		return reasonPhraseOf(code);
+	}
+
+	std::string_view statusLineOf(StatusCode code) {
+		const auto line = std::lower_bound(STATUS_LINES.begin(), STATUS_LINES.end(), static_cast<std::uint16_t>(code), [](const StatusLine& entry, std::uint16_t value) {
+			return entry.code < value;
+		});
+
+		if (line == STATUS_LINES.end() || line->code != static_cast<std::uint16_t>(code)) {
+			return "";
 		}
 
-		std::string headerName = headerField.substr(0, headerField.find(":"));
+		return std::string_view(line->text.data(), line->size);
+	}
+
+	// Header names are case-insensitive (RFC 9110, 5.1)
+	std::optional<Header> findHeader(std::string_view headerName) {
+		for (std::size_t i = 0; i < HEADER_NAMES.size(); i++) {
+			const std::string_view name = HEADER_NAMES[i];
+
+			if (name.size() == headerName.size() && std::equal(name.begin(), name.end(), headerName.begin(), [](char a, char b) {
+				return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+			})) {
+				return static_cast<Header>(i);
+			}
+		}
+
+		return std::nullopt;
+	}
+
+	bool hasHeaderName(std::string_view headerName) {
+		return findHeader(headerName).has_value();
+	}
+
+	// token = 1*tchar (RFC 9110, 5.6.2)
+	bool isToken(std::string_view value) {
+		const char* end = value.data() + value.size();
+		return !value.empty() && utils::findNonToken(value.data(), end) == end;
+	}
+
+	bool isValidHeaderField(std::string_view headerField) {
+		const std::size_t colonPos = headerField.find(':');
 
-		if (!hasHeaderName(headerName)) {
+		if (colonPos == std::string_view::npos) {
 			return false;
 		}
 
-		return true;
+		std::string_view headerName = headerField.substr(0, colonPos);
+		return isToken(headerName) && hasHeaderName(headerName);
 	}
 }
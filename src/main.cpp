@@ -1,3 +1,4 @@
+#include <csignal>
 #include <iostream>
 #include "Config.hpp"
 #include "Error.hpp"
@@ -16,6 +17,11 @@ int main(int argc, char **argv) {
 		return(1);
 	}
 
+	// sendfile() and writes to CGI pipes have no MSG_NOSIGNAL: a peer gone
+	// away must fail them with EPIPE rather than kill the process. Set
+	// before the worker threads start, which inherit it.
+	std::signal(SIGPIPE, SIG_IGN);
+
 	try {
 		//handleSignals();
 		ConfigParser parser(argv[1]);
@@ -1,8 +1,10 @@
 #include "utils/common.hpp"
+#include "http/constants.hpp"
 #include "Config.hpp"
 #include "Error.hpp"
 //#include "Server.hpp"
 #include <sstream> // std::istringstream
+#include <thread> // std::thread::hardware_concurrency
 
 // Define namespaces
 using std::string;
@@ -19,12 +21,103 @@ void ConfigParser::parseHttpBlock(ifstream &file, Config &config) {
 			ServerConfig server;
 			parseServerBlock(file, server);
 			config.servers.push_back(server);
+		} else if (line == "types {") {
+			parseTypesBlock(file, config);
 		} else {
-			THROW_CONFIG_ERROR(EINVAL, "Invalid directive in http block: " + line);
+			parseHttp(line, config);
 		}
 	});
 }
 
+// Function to parse directives that apply to the whole http block
+void ConfigParser::parseHttp(const string &line, Config &config) {
+	const ParserMap httpParsers = {
+		{"event_backend", [&](const string &value) {
+			if (value == "poll") {
+				config.eventBackend = EventBackend::POLL;
+			} else if (value == "epoll") {
+#ifndef __linux__
+				THROW_CONFIG_ERROR(ENOTSUP, "epoll is only available on Linux");
+#endif
+				config.eventBackend = EventBackend::EPOLL;
+			} else {
+				THROW_CONFIG_ERROR(EINVAL, "Invalid event_backend");
+			}
+		}},
+		{"worker_threads", [&](const string &value) {
+			if (value == "auto") {
+				config.workerThreads = std::max(1u, std::thread::hardware_concurrency());
+				return;
+			}
+			if (!std::all_of(value.begin(), value.end(), ::isdigit) || value.size() > 4) {
+				THROW_CONFIG_ERROR(EINVAL, "Invalid worker_threads");
+			}
+			config.workerThreads = std::stoul(value);
+			if (config.workerThreads == 0) {
+				THROW_CONFIG_ERROR(ERANGE, "worker_threads must be at least 1");
+			}
+		}},
+		{"open_file_cache", [&](const string &value) {
+			if (value == "off") {
+				config.openFileCacheSize = 0;
+				return;
+			}
+			if (value.empty() || !std::all_of(value.begin(), value.end(), ::isdigit) || value.size() > 7) {
+				THROW_CONFIG_ERROR(EINVAL, "Invalid open_file_cache");
+			}
+			config.openFileCacheSize = std::stoul(value);
+		}},
+		{"open_file_cache_valid", [&](const string &value) {
+			// Not a timer, so neither bound by the wheel nor above 0: 0 checks every time
+			if (value.empty() || !std::all_of(value.begin(), value.end(), ::isdigit) || value.size() > 9) {
+				THROW_CONFIG_ERROR(EINVAL, "Invalid open_file_cache_valid");
+			}
+			config.openFileCacheValid = std::stoul(value);
+		}},
+		{"response_cache", [&](const string &value) {
+			if (value == "off") {
+				config.responseCacheSize = 0;
+				return;
+			}
+			if (!utils::isValidSize(value)) {
+				THROW_CONFIG_ERROR(EINVAL, "Invalid response_cache");
+			}
+			config.responseCacheSize = utils::convertSizeToBytes(value);
+		}},
+		{"response_cache_max_file", [&](const string &value) {
+			if (!utils::isValidSize(value)) {
+				THROW_CONFIG_ERROR(EINVAL, "Invalid response_cache_max_file");
+			}
+			config.responseCacheMaxFile = utils::convertSizeToBytes(value);
+		}}
+	};
+
+	utils::parseKeyValue(line, httpParsers);
+}
+
+// Each line is a MIME type followed by its extensions, without dots:
+// text/markdown md markdown;
+void ConfigParser::parseTypesBlock(ifstream &file, Config &config) {
+	utils::parseBlock(file, "types", [&](const string &line) {
+		istringstream iss(line);
+		string type;
+		string extension;
+		vector<string> extensions;
+
+		iss >> type;
+		while (iss >> extension) {
+			if (extension.find_first_of("./") != string::npos) {
+				THROW_CONFIG_ERROR(EINVAL, "Invalid extension in types");
+			}
+			extensions.push_back(extension);
+		}
+		if (type.find('/') == string::npos || extensions.empty()) {
+			THROW_CONFIG_ERROR(EINVAL, "Invalid types entry");
+		}
+		config.mimeTypes[type] = extensions;
+	});
+}
+
 void ConfigParser::parseServerBlock(ifstream &file, ServerConfig &server) {
 	utils::parseBlock(file, "server", [&](const string &line) {
 		if (line.find("location ") == 0) {
@@ -76,6 +169,24 @@ void ConfigParser::parseGlobal(const string &line, ServerConfig &server) {
 				THROW_CONFIG_ERROR(EINVAL, "Invalid client_max_body_size");
 			}
 			server.clientMaxBodySize = utils::convertSizeToBytes(value);
+		}},
+		{"client_buffer_size", [&](const string &value) {
+			if (!utils::isValidSize(value) || utils::convertSizeToBytes(value) <= http::MAX_REQUEST_HEADER_SIZE) {
+				THROW_CONFIG_ERROR(EINVAL, "Invalid client_buffer_size");
+			}
+			server.clientBufferSize = utils::convertSizeToBytes(value);
+		}},
+		{"timeout_request", [&](const string &value) {
+			server.timeoutRequest = utils::parseTimeout(value);
+		}},
+		{"timeout_handler", [&](const string &value) {
+			server.timeoutHandler = utils::parseTimeout(value);
+		}},
+		{"timeout_response", [&](const string &value) {
+			server.timeoutResponse = utils::parseTimeout(value);
+		}},
+		{"timeout_idle", [&](const string &value) {
+			server.timeoutIdle = utils::parseTimeout(value);
 		}}
 	};
 
@@ -96,6 +207,12 @@ fs::path ConfigParser::getConfigPath(const string &value) const {
 }
 
 void ConfigParser::parseLocation(const string &line, Location &currentLocation) {
+	const auto parseCount = [](const string &value, const string &directive) {
+		if (value.empty() || !std::all_of(value.begin(), value.end(), ::isdigit) || value.size() > 6) {
+			THROW_CONFIG_ERROR(EINVAL, "Invalid " + directive);
+		}
+		return std::stoul(value);
+	};
 	const ParserMap locationParsers = {
 		{"root", [&](const string &value) {
 			fullPath = getConfigPath(value);
@@ -132,7 +249,72 @@ void ConfigParser::parseLocation(const string &line, Location &currentLocation)
 			currentLocation.methods = methods;
 		}},
 		{"cgi_extension", [&](const string &value) {
-			currentLocation.cgiExtension.push_back(value);
+			istringstream iss(value);
+			string extension;
+			string interpreter;
+			iss >> extension >> interpreter;
+			if (extension.empty() || extension[0] != '.' || (!interpreter.empty() && interpreter[0] != '/')) {
+				THROW_CONFIG_ERROR(EINVAL, "Invalid cgi_extension");
+			}
+			currentLocation.cgiExtension.push_back(extension);
+			if (!interpreter.empty()) {
+				currentLocation.cgiInterpreter[extension] = interpreter;
+			}
+		}},
+		{"fastcgi_pass", [&](const string &value) {
+			const bool isUnix = value.starts_with("unix:/");
+			const size_t colonPos = value.rfind(':');
+			if (!currentLocation.fastcgiPass.empty()
+				|| (!isUnix && (colonPos == string::npos || colonPos == 0))) {
+				THROW_CONFIG_ERROR(EINVAL, "Invalid fastcgi_pass");
+			}
+			if (!isUnix) {
+				utils::parsePort(value.substr(colonPos + 1));
+			}
+			currentLocation.fastcgiPass = value;
+		}},
+		{"fastcgi_connections", [&](const string &value) {
+			currentLocation.fastcgiConnections = parseCount(value, "fastcgi_connections");
+			if (currentLocation.fastcgiConnections == 0) {
+				THROW_CONFIG_ERROR(ERANGE, "fastcgi_connections must be at least 1");
+			}
+		}},
+		{"cgi_worker", [&](const string &value) {
+			istringstream iss(value);
+			string extension;
+			string program;
+			iss >> extension >> program;
+			if (extension.empty() || extension[0] != '.' || program.empty()) {
+				THROW_CONFIG_ERROR(EINVAL, "Invalid cgi_worker");
+			}
+			fullPath = getConfigPath(program);
+			if (!utils::isValidFilePath(fullPath)) {
+				THROW_CONFIG_ERROR(EINVAL, "Invalid cgi_worker");
+			}
+			currentLocation.cgiWorker[extension] = fullPath;
+		}},
+		{"cgi_workers", [&](const string &value) {
+			istringstream iss(value);
+			string min;
+			string max;
+			iss >> min >> max;
+			currentLocation.cgiWorkersMin = parseCount(min, "cgi_workers");
+			currentLocation.cgiWorkersMax = parseCount(max, "cgi_workers");
+			if (currentLocation.cgiWorkersMax == 0 || currentLocation.cgiWorkersMin > currentLocation.cgiWorkersMax) {
+				THROW_CONFIG_ERROR(ERANGE, "cgi_workers needs 1 <= max and min <= max");
+			}
+		}},
+		{"cgi_worker_requests", [&](const string &value) {
+			currentLocation.cgiWorkerRequests = parseCount(value, "cgi_worker_requests");
+		}},
+		{"cgi_queue", [&](const string &value) {
+			currentLocation.cgiQueueSize = parseCount(value, "cgi_queue");
+		}},
+		{"cache_control", [&](const string &value) {
+			if (!std::all_of(value.begin(), value.end(), [](unsigned char c) { return c == ' ' || c == '\t' || (c > 0x20 && c < 0x7f); })) {
+				THROW_CONFIG_ERROR(EINVAL, "Invalid cache_control");
+			}
+			currentLocation.cacheControl = value;
 		}},
 		{"return", [&](const string &value) {
 			if (!currentLocation.returnUrl.empty()) {
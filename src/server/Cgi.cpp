@@ -0,0 +1,363 @@
+#include <cctype>
+#include <charconv>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "Cgi.hpp"
+#include "http/utils.hpp"
+#include "utils/FileCache.hpp"
+#include "utils/common.hpp"
+
+using http::StatusCode;
+namespace fs = std::filesystem;
+
+namespace {
+	std::string trim(std::string_view value) {
+		const std::size_t first = value.find_first_not_of(" \t");
+
+		if (first == std::string_view::npos) {
+			return "";
+		}
+
+		return std::string(value.substr(first, value.find_last_not_of(" \t") - first + 1));
+	}
+
+	// HTTP_* name of a header field (RFC 3875, 4.1.18)
+	std::string metaVariableOf(http::Header header) {
+		std::string name("HTTP_");
+
+		name.append(http::stringOf(header));
+
+		for (char& c : name) {
+			c = (c == '-') ? '_' : static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+		}
+
+		return name;
+	}
+
+	void addSocketAddress(std::vector<std::string>& env, int fd, bool isPeer) {
+		sockaddr_in address {};
+		socklen_t length = sizeof(address);
+		const int ret = isPeer
+			? ::getpeername(fd, reinterpret_cast<sockaddr*>(&address), &length)
+			: ::getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length);
+
+		if (ret < 0 || address.sin_family != AF_INET) {
+			return;
+		}
+
+		char host[INET_ADDRSTRLEN] {};
+
+		::inet_ntop(AF_INET, &address.sin_addr, host, sizeof(host));
+
+		if (isPeer) {
+			env.push_back("REMOTE_ADDR=" + std::string(host));
+			env.push_back("REMOTE_PORT=" + std::to_string(ntohs(address.sin_port)));
+		} else {
+			env.push_back("SERVER_PORT=" + std::to_string(ntohs(address.sin_port)));
+		}
+	}
+}
+
+std::optional<CgiScript> findCgiScript(const Location& loc, std::string_view urlPath) {
+	if (loc.cgiExtension.empty() || urlPath.size() <= loc.path.size()) {
+		return std::nullopt;
+	}
+
+	std::size_t prefixSize = loc.path.size();
+
+	if (urlPath[prefixSize] == '/') {
+		prefixSize++;
+	}
+
+	const std::string_view relativePath = urlPath.substr(prefixSize);
+
+	// The first segment with a CGI extension is the script, the rest PATH_INFO
+	for (std::size_t end = 0; end != std::string_view::npos;) {
+		end = relativePath.find('/', end);
+
+		const std::string_view scriptPath = relativePath.substr(0, end);
+
+		for (const std::string& extension : loc.cgiExtension) {
+			if (!scriptPath.ends_with(extension)) {
+				continue;
+			}
+
+			const fs::path path = fs::absolute(loc.root / scriptPath);
+			auto file = utils::FileCache::local().find(path);
+
+			if (file == nullptr || file->isDirectory()) {
+				return std::nullopt;
+			}
+
+			auto interpreter = loc.cgiInterpreter.find(extension);
+
+			return CgiScript {
+				path,
+				interpreter != loc.cgiInterpreter.end() ? interpreter->second : "",
+				std::string(urlPath.substr(0, prefixSize + scriptPath.size())),
+				end == std::string_view::npos ? "" : std::string(relativePath.substr(end)),
+				extension
+			};
+		}
+
+		if (end != std::string_view::npos) {
+			end++;
+		}
+	}
+
+	return std::nullopt;
+}
+
+// RFC 3875 variables, plus the few that PHP needs
+std::vector<std::string> makeCgiEnv(const CgiScript& script, const ServerConfig& serverConfig, const http::Request& request, int clientFd) {
+	using http::Header;
+
+	const http::Url& url = request.getUrl();
+	std::vector<std::string> env {
+		"GATEWAY_INTERFACE=CGI/1.1",
+		"SERVER_SOFTWARE=webserv",
+		"SERVER_PROTOCOL=HTTP/1.1",
+		"SERVER_NAME=" + (serverConfig.serverName.empty() ? serverConfig.host : serverConfig.serverName),
+		"REQUEST_METHOD=" + std::string(request.getMethod()),
+		"REQUEST_URI=" + std::string(request.getUri()),
+		"QUERY_STRING=" + std::string(url.query),
+		"SCRIPT_NAME=" + script.name,
+		"SCRIPT_FILENAME=" + script.path.string(),
+		"PATH_INFO=" + script.pathInfo,
+		"REDIRECT_STATUS=200",
+		"PATH=/usr/local/bin:/usr/bin:/bin"
+	};
+
+	addSocketAddress(env, clientFd, false);
+	addSocketAddress(env, clientFd, true);
+
+	// A chunked body is only passed on once whole, so its length is known
+	if (const auto& body = request.getBody()) {
+		const std::size_t length = body->getLength();
+
+		env.push_back("CONTENT_LENGTH=" + std::to_string(length == http::RequestBody::UNKNOWN_LENGTH ? body->getReceived() : length));
+	} else if (request.getMethod() == "POST") {
+		env.push_back("CONTENT_LENGTH=0");
+	}
+
+	if (auto contentType = request.getHeader(Header::CONTENT_TYPE)) {
+		env.push_back("CONTENT_TYPE=" + std::string(*contentType));
+	}
+
+	// Credentials are not passed on, as the RFC recommends
+	for (std::size_t i = 0; i < static_cast<std::size_t>(Header::LENGTH); i++) {
+		const Header header = static_cast<Header>(i);
+		auto value = request.getHeader(header);
+
+		if (
+			!value.has_value()
+			|| header == Header::CONTENT_TYPE
+			|| header == Header::CONTENT_LENGTH
+			|| header == Header::AUTHORIZATION
+			|| header == Header::PROXY_AUTHORIZATION
+		) {
+			continue;
+		}
+
+		env.push_back(metaVariableOf(header) + "=" + std::string(*value));
+	}
+
+	return env;
+}
+
+CgiOutput::CgiOutput(http::Response& response, const std::map<int, std::string>& errorPages)
+	: _clientFd(response.getClientSocket())
+	, _errorPages(&errorPages)
+	, _response(&response) {
+}
+
+void CgiOutput::append(const std::uint8_t* data, std::size_t size) {
+	if (_response == nullptr) {
+		return;
+	}
+
+	if (_body == nullptr) {
+		_parseHeader(data, size);
+	} else {
+		_body->append(data, size);
+	}
+}
+
+void CgiOutput::finish() {
+	if (_response == nullptr) {
+		return;
+	}
+
+	if (_body == nullptr) {
+		return fail(StatusCode::BAD_GATEWAY_502);
+	}
+
+	_body->finish();
+	detach();
+}
+
+void CgiOutput::fail(StatusCode statusCode) {
+	if (_response == nullptr) {
+		return;
+	}
+
+	// Past the header, the status is already out
+	if (_body != nullptr) {
+		_body->abort();
+		_response->abort();
+		detach();
+		return;
+	}
+
+	_response->clear();
+	_response->setError(statusCode, *_errorPages);
+	detach();
+}
+
+void CgiOutput::reject(std::size_t retryAfter) {
+	if (_response == nullptr) {
+		return;
+	}
+
+	_response->clear();
+	_response->setHeader(http::Header::RETRY_AFTER, std::to_string(retryAfter));
+	_response->setError(StatusCode::SERVICE_UNAVAILABLE_503, *_errorPages);
+	detach();
+}
+
+void CgiOutput::detach() {
+	_response = nullptr;
+	_body = nullptr;
+}
+
+bool CgiOutput::isAttached() const {
+	return _response != nullptr;
+}
+
+int CgiOutput::getClientFd() const {
+	return _clientFd;
+}
+
+std::size_t CgiOutput::getBufferedBytes() const {
+	return _body != nullptr ? _body->getBufferedBytes() : 0;
+}
+
+// The header ends at the first empty line; scripts may end lines with a
+// bare LF (RFC 3875, 6.3), so both forms are looked for.
+void CgiOutput::_parseHeader(const std::uint8_t* data, std::size_t size) {
+	const std::size_t searchFrom = _header.size() < 3 ? 0 : _header.size() - 3;
+
+	_header.append(reinterpret_cast<const char*>(data), size);
+
+	std::size_t end = std::string::npos;
+	std::size_t bodyStart = 0;
+
+	for (std::size_t i = _header.find('\n', searchFrom); i != std::string::npos; i = _header.find('\n', i + 1)) {
+		if (i + 1 < _header.size() && _header[i + 1] == '\n') {
+			end = i + 1;
+			bodyStart = i + 2;
+			break;
+		}
+
+		if (i + 2 < _header.size() && _header[i + 1] == '\r' && _header[i + 2] == '\n') {
+			end = i + 1;
+			bodyStart = i + 3;
+			break;
+		}
+	}
+
+	if (end == std::string::npos) {
+		if (_header.size() > MAX_HEADER_SIZE) {
+			fail(StatusCode::BAD_GATEWAY_502);
+		}
+		return;
+	}
+
+	if (end > MAX_HEADER_SIZE || !_buildResponse(std::string_view(_header).substr(0, end))) {
+		return fail(StatusCode::BAD_GATEWAY_502);
+	}
+
+	const std::string body = _header.substr(bodyStart);
+
+	_header.clear();
+	_header.shrink_to_fit();
+	_body->append(reinterpret_cast<const std::uint8_t*>(body.data()), body.size());
+}
+
+// Status and Location are CGI fields (RFC 3875, 6.3); the other fields are
+// passed on, minus the hop-by-hop ones this server decides itself.
+bool CgiOutput::_buildResponse(std::string_view header) {
+	using http::Header;
+
+	StatusCode statusCode = StatusCode::OK_200;
+	bool hasStatus = false;
+	bool hasLocation = false;
+	bool hasContentLength = false;
+
+	_response->clear();
+
+	while (!header.empty()) {
+		const std::size_t lineEnd = header.find('\n');
+		std::string_view line = header.substr(0, lineEnd);
+
+		header.remove_prefix(lineEnd == std::string_view::npos ? header.size() : lineEnd + 1);
+
+		if (line.ends_with('\r')) {
+			line.remove_suffix(1);
+		}
+
+		const std::size_t colonPos = line.find(':');
+
+		if (colonPos == 0 || colonPos == std::string_view::npos || !http::isToken(line.substr(0, colonPos))) {
+			return false;
+		}
+
+		const std::string name = utils::lowerCase(std::string(line.substr(0, colonPos)));
+		const std::string value = trim(line.substr(colonPos + 1));
+
+		if (name == "status") {
+			unsigned code = 0;
+			auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), code);
+
+			if (ec != std::errc() || code < 100 || code > 599 || (ptr != value.data() + value.size() && *ptr != ' ')) {
+				return false;
+			}
+
+			statusCode = static_cast<StatusCode>(code);
+			hasStatus = true;
+			continue;
+		}
+
+		auto known = http::findHeader(name);
+
+		if (known == Header::CONNECTION || known == Header::TRANSFER_ENCODING) {
+			continue;
+		}
+
+		hasLocation = hasLocation || known == Header::LOCATION;
+		hasContentLength = hasContentLength || known == Header::CONTENT_LENGTH;
+
+		if (known.has_value()) {
+			_response->setHeader(*known, value);
+		} else {
+			_response->setHeader(line.substr(0, colonPos), value);
+		}
+	}
+
+	if (hasLocation && !hasStatus) {
+		statusCode = StatusCode::FOUND_302;
+	}
+
+	if (!hasContentLength) {
+		_response->setHeader(Header::TRANSFER_ENCODING, "chunked");
+	}
+
+	auto body = std::make_unique<utils::StreamPayload>(_clientFd, !hasContentLength);
+
+	_body = body.get();
+	_response->setStatusCode(statusCode);
+	_response->setBody(std::move(body));
+	_response->build();
+	return true;
+}
@@ -0,0 +1,199 @@
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include "CgiProcess.hpp"
+#include "utils/socket.hpp"
+
+namespace {
+	void closePipes(int (&inputPipe)[2], int (&outputPipe)[2]) {
+		for (int fd : { inputPipe[0], inputPipe[1], outputPipe[0], outputPipe[1] }) {
+			if (fd >= 0) {
+				::close(fd);
+			}
+		}
+	}
+}
+
+CgiProcess::CgiProcess(const CgiScript& script, const ServerConfig& serverConfig, const http::Request& request, http::Response& response)
+	: _input(request.getBody())
+	, _output(response, serverConfig.errorPages) {
+	std::vector<std::string> args;
+	std::vector<std::string> env = makeCgiEnv(script, serverConfig, request, response.getClientSocket());
+	const std::string directory = script.path.parent_path().string();
+
+	if (!script.interpreter.empty()) {
+		args.push_back(script.interpreter);
+	}
+
+	args.push_back(script.path.string());
+
+	int inputPipe[2] { -1, -1 };
+	int outputPipe[2] { -1, -1 };
+
+	if (::pipe2(inputPipe, O_CLOEXEC) < 0 || ::pipe2(outputPipe, O_CLOEXEC) < 0) {
+		closePipes(inputPipe, outputPipe);
+		throw std::runtime_error("Failed to create CGI pipes: " + std::string(strerror(errno)));
+	}
+
+	try {
+		_spawn(std::move(args), std::move(env), directory, inputPipe[0], outputPipe[1]);
+	} catch (const std::runtime_error&) {
+		closePipes(inputPipe, outputPipe);
+		throw;
+	}
+
+	::close(inputPipe[0]);
+	::close(outputPipe[1]);
+	_inputFd = inputPipe[1];
+	_outputFd = outputPipe[0];
+	_isInputOpen = (_input != nullptr && !_input->isDrained());
+	_isOutputOpen = true;
+
+	if (!utils::setNonBlocking(_inputFd) || !utils::setNonBlocking(_outputFd)) {
+		kill();
+		reap();
+		closePipe(_inputFd);
+		closePipe(_outputFd);
+		throw std::runtime_error("Failed to set CGI pipes non-blocking");
+	}
+}
+
+CgiProcess::~CgiProcess() {
+	closePipe(_inputFd);
+	closePipe(_outputFd);
+}
+
+void CgiProcess::writeInput() {
+	if (!_isInputOpen || _input->size() == 0) {
+		_isInputOpen = _isInputOpen && !_input->isDrained();
+		return;
+	}
+
+	const ssize_t bytesWritten = ::write(_inputFd, _input->data(), _input->size());
+
+	// A script may exit or close its stdin without reading the body, which
+	// is its right. SIGPIPE is ignored process-wide (see main()), so that
+	// fails the write with EPIPE, and the rest of the body is dropped.
+	if (bytesWritten < 0) {
+		_isInputOpen = (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+		return;
+	}
+
+	_input->consume(static_cast<std::size_t>(bytesWritten));
+	_isInputOpen = !_input->isDrained();
+}
+
+void CgiProcess::readOutput() {
+	if (!_isOutputOpen) {
+		return;
+	}
+
+	thread_local std::array<std::uint8_t, READ_BUFFER_SIZE> buffer;
+	const ssize_t bytesRead = ::read(_outputFd, buffer.data(), buffer.size());
+
+	if (bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+		return;
+	}
+
+	if (bytesRead <= 0) {
+		return _finishOutput();
+	}
+
+	_output.append(buffer.data(), static_cast<std::size_t>(bytesRead));
+}
+
+void CgiProcess::closePipe(int fd) {
+	if (fd < 0) {
+		return;
+	}
+
+	::close(fd);
+
+	if (fd == _inputFd) {
+		_inputFd = -1;
+		_isInputOpen = false;
+		_input.reset();
+	} else if (fd == _outputFd) {
+		_outputFd = -1;
+		_isOutputOpen = false;
+	}
+}
+
+bool CgiProcess::isPipeOpen(int fd) const {
+	return (fd == _inputFd && _isInputOpen) || (fd == _outputFd && _isOutputOpen);
+}
+
+bool CgiProcess::isDone() const {
+	return _inputFd < 0 && _outputFd < 0;
+}
+
+int CgiProcess::getClientFd() const {
+	return _output.getClientFd();
+}
+
+int CgiProcess::getInputFd() const {
+	return _inputFd;
+}
+
+int CgiProcess::getOutputFd() const {
+	return _outputFd;
+}
+
+// Stdin is only written to once there is some of the body to write, or
+// its end to pass on.
+short CgiProcess::getEvents(int fd) const {
+	if (fd == _inputFd) {
+		return (_isInputOpen && (_input->size() > 0 || _input->isComplete())) ? POLLOUT : 0;
+	}
+
+	return (_output.getBufferedBytes() > MAX_BUFFERED_OUTPUT) ? 0 : POLLIN;
+}
+
+// The client is told about output, and about its body being taken in, as
+// the connection may have stopped reading it.
+void CgiProcess::process(int fd, short revents, std::vector<int>& clientFds) {
+	if (!isPipeOpen(fd)) {
+		return;
+	}
+
+	if (fd == _inputFd) {
+		// The script is gone or closed its stdin, which is its right
+		if (revents & POLLERR) {
+			_isInputOpen = false;
+			return;
+		}
+
+		writeInput();
+		clientFds.push_back(getClientFd());
+		return;
+	}
+
+	readOutput();
+	clientFds.push_back(getClientFd());
+}
+
+void CgiProcess::abort(int clientFd) {
+	if (clientFd != getClientFd()) {
+		return;
+	}
+
+	kill();
+	_isInputOpen = false;
+	_isOutputOpen = false;
+	_output.detach();
+}
+
+// End of output is the end of the response, and nothing the script did
+// not read yet matters anymore.
+void CgiProcess::_finishOutput() {
+	_isOutputOpen = false;
+	_isInputOpen = false;
+
+	if (_output.isAttached()) {
+		_output.finish();
+	}
+}
@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "CgiWorkerPool.hpp"
+#include "utils/socket.hpp"
+
+using http::StatusCode;
+
+CgiWorker::CgiWorker(std::vector<std::string> args, const std::string& directory) {
+	int fds[2] { -1, -1 };
+
+	// Close-on-exec on both ends, so no other child keeps a worker's socket
+	// open past its retirement
+	if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0) {
+		throw std::runtime_error("Failed to create CGI worker socket: " + std::string(strerror(errno)));
+	}
+
+	try {
+		_spawn(std::move(args), { "PATH=/usr/local/bin:/usr/bin:/bin" }, directory, fds[1], -1);
+	} catch (const std::runtime_error&) {
+		::close(fds[0]);
+		::close(fds[1]);
+		throw;
+	}
+
+	::close(fds[1]);
+
+	if (!utils::setNonBlocking(fds[0])) {
+		::close(fds[0]);
+		throw std::runtime_error("Failed to set CGI worker socket non-blocking");
+	}
+
+	_connection = std::make_shared<FastCgiConnection>(fds[0]);
+}
+
+bool CgiWorker::isDone() const {
+	return _connection->getFd() < 0;
+}
+
+short CgiWorker::getEvents(int fd) const {
+	return _connection->getEvents(fd);
+}
+
+bool CgiWorker::isPipeOpen(int fd) const {
+	return _connection->isPipeOpen(fd);
+}
+
+void CgiWorker::closePipe(int fd) {
+	_connection->closePipe(fd);
+}
+
+void CgiWorker::process(int fd, short revents, std::vector<int>& clientFds) {
+	_connection->process(fd, revents, clientFds);
+}
+
+void CgiWorker::abort(int clientFd) {
+	if (_connection->isServing(clientFd)) {
+		kill();
+		_isAborted = true;
+		_connection->abort(clientFd);
+	}
+}
+
+void CgiWorker::begin(const fastcgi::NameValues& params, std::shared_ptr<http::RequestBody> input, CgiOutput output) {
+	_servedRequests++;
+	_connection->begin(params, std::move(input), std::move(output));
+}
+
+std::size_t CgiWorker::getServedRequests() const {
+	return _servedRequests;
+}
+
+bool CgiWorker::isAborted() const {
+	return _isAborted;
+}
+
+const std::shared_ptr<FastCgiConnection>& CgiWorker::getConnection() const {
+	return _connection;
+}
+
+CgiWorkerPool::CgiWorkerPool(
+	const Location& loc,
+	const std::string& extension,
+	std::unordered_map<int, std::shared_ptr<Upstream>>& upstreamByFd,
+	std::vector<std::shared_ptr<Process>>& processes
+)
+	: _minWorkers(loc.cgiWorkersMin)
+	, _maxWorkers(loc.cgiWorkersMax)
+	, _maxRequests(loc.cgiWorkerRequests)
+	, _maxQueued(loc.cgiQueueSize)
+	, _upstreamByFd(upstreamByFd)
+	, _processes(processes) {
+	const std::filesystem::path& program = loc.cgiWorker.at(extension);
+	auto interpreter = loc.cgiInterpreter.find(extension);
+
+	if (interpreter != loc.cgiInterpreter.end()) {
+		_args.push_back(interpreter->second);
+	}
+
+	_args.push_back(program.string());
+	_directory = program.parent_path().string();
+
+	std::vector<int> clientFds;
+
+	dispatch(clientFds);
+}
+
+void CgiWorkerPool::submit(fastcgi::NameValues params, std::shared_ptr<http::RequestBody> input, CgiOutput output) {
+	if (_queue.empty()) {
+		try {
+			if (CgiWorker* worker = _findWorker()) {
+				return worker->begin(params, std::move(input), std::move(output));
+			}
+		} catch (const std::runtime_error& e) {
+			std::cerr << e.what() << std::endl;
+
+			if (_workers.empty()) {
+				return output.fail(StatusCode::BAD_GATEWAY_502);
+			}
+		}
+	}
+
+	if (_queue.size() >= _maxQueued) {
+		return output.reject(RETRY_AFTER);
+	}
+
+	_queue.push_back(Request { std::move(params), std::move(input), std::move(output) });
+}
+
+void CgiWorkerPool::dispatch(std::vector<int>& clientFds) {
+	std::erase_if(_workers, [this](const std::shared_ptr<CgiWorker>& worker) {
+		const FastCgiConnection& connection = *worker->getConnection();
+
+		if (connection.isOpen() && connection.getRequestCount() == 0 && _isWorn(*worker)) {
+			worker->getConnection()->shutdown();
+		}
+
+		// A killed worker may still have its last answer to read, which
+		// frees it up, but its socket is about to fail
+		return !connection.isOpen() || worker->isAborted();
+	});
+
+	try {
+		while (_workers.size() < _minWorkers) {
+			_startWorker();
+		}
+
+		while (!_queue.empty()) {
+			CgiWorker* worker = _findWorker();
+
+			if (worker == nullptr) {
+				return;
+			}
+
+			Request& request = _queue.front();
+
+			worker->begin(request.params, std::move(request.input), std::move(request.output));
+			_queue.pop_front();
+		}
+	} catch (const std::runtime_error& e) {
+		std::cerr << e.what() << std::endl;
+
+		if (!_workers.empty()) {
+			return;
+		}
+
+		// Nothing could serve the waiting requests
+		for (Request& request : _queue) {
+			clientFds.push_back(request.output.getClientFd());
+			request.output.fail(StatusCode::BAD_GATEWAY_502);
+		}
+
+		_queue.clear();
+	}
+}
+
+void CgiWorkerPool::abort(int clientFd) {
+	std::erase_if(_queue, [clientFd](const Request& request) {
+		return request.output.getClientFd() == clientFd;
+	});
+}
+
+CgiWorker* CgiWorkerPool::_findWorker() {
+	for (auto& worker : _workers) {
+		if (worker->getConnection()->getCapacity() > 0 && !_isWorn(*worker) && !worker->isAborted()) {
+			return worker.get();
+		}
+	}
+
+	if (_workers.size() >= _maxWorkers) {
+		return nullptr;
+	}
+
+	return &_startWorker();
+}
+
+CgiWorker& CgiWorkerPool::_startWorker() {
+	auto worker = std::make_shared<CgiWorker>(_args, _directory);
+
+	_upstreamByFd[worker->getConnection()->getFd()] = worker;
+	_processes.push_back(worker);
+	_workers.push_back(std::move(worker));
+	return *_workers.back();
+}
+
+bool CgiWorkerPool::_isWorn(const CgiWorker& worker) const {
+	return _maxRequests > 0 && worker.getServedRequests() >= _maxRequests;
+}
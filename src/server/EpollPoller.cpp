@@ -0,0 +1,90 @@
+#ifdef __linux__
+
+#include <unistd.h>
+#include <stdexcept>
+#include "Poller.hpp"
+
+namespace {
+	constexpr std::size_t INITIAL_EVENT_CAPACITY = 64;
+
+	std::uint32_t toEpollEvents(short events) {
+		std::uint32_t epollEvents = 0;
+
+		if (events & POLLIN) epollEvents |= EPOLLIN;
+		if (events & POLLOUT) epollEvents |= EPOLLOUT;
+		return epollEvents;
+	}
+
+	short toPollEvents(std::uint32_t epollEvents) {
+		short events = 0;
+
+		if (epollEvents & EPOLLIN) events |= POLLIN;
+		if (epollEvents & EPOLLOUT) events |= POLLOUT;
+		if (epollEvents & EPOLLHUP) events |= POLLHUP;
+		if (epollEvents & EPOLLERR) events |= POLLERR;
+		return events;
+	}
+}
+
+EpollPoller::EpollPoller()
+	: _epollFd(::epoll_create1(EPOLL_CLOEXEC))
+	, _epollEvents(INITIAL_EVENT_CAPACITY) {
+	if (_epollFd == -1) {
+		throw std::runtime_error("Failed to create epoll instance");
+	}
+}
+
+EpollPoller::~EpollPoller() {
+	::close(_epollFd);
+}
+
+void EpollPoller::add(int fd, short events, void* data) {
+	struct ::epoll_event event {};
+
+	event.events = toEpollEvents(events);
+	event.data.ptr = data;
+
+	if (::epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &event) == -1) {
+		throw std::runtime_error("Failed to add fd " + std::to_string(fd) + " to epoll");
+	}
+}
+
+void EpollPoller::modify(int fd, short events, void* data) {
+	struct ::epoll_event event {};
+
+	event.events = toEpollEvents(events);
+	event.data.ptr = data;
+
+	if (::epoll_ctl(_epollFd, EPOLL_CTL_MOD, fd, &event) == -1) {
+		throw std::runtime_error("Failed to modify fd " + std::to_string(fd) + " in epoll");
+	}
+}
+
+void EpollPoller::remove(int fd) {
+	// The fd may already be closed, in which case the kernel dropped it from
+	// the interest list on its own and EBADF/ENOENT is expected.
+	::epoll_ctl(_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+int EpollPoller::wait(std::vector<Event>& events, int timeoutMs) {
+	events.clear();
+
+	const int ret = ::epoll_wait(_epollFd, _epollEvents.data(), _epollEvents.size(), timeoutMs);
+
+	if (ret <= 0) {
+		return ret;
+	}
+
+	for (int i = 0; i < ret; i++) {
+		events.push_back({ _epollEvents[i].data.ptr, toPollEvents(_epollEvents[i].events) });
+	}
+
+	// A full batch suggests more fds are ready than we can collect at once
+	if (static_cast<std::size_t>(ret) == _epollEvents.size()) {
+		_epollEvents.resize(_epollEvents.size() * 2);
+	}
+
+	return ret;
+}
+
+#endif
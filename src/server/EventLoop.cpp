@@ -0,0 +1,317 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <sys/resource.h>
+#include "EventLoop.hpp"
+#include "http/ResponseCache.hpp"
+#include "utils/CoarseClock.hpp"
+#include "utils/FileCache.hpp"
+
+namespace {
+	std::size_t timeoutOf(http::Connection::Phase phase, const ServerConfig& serverConfig) {
+		using enum http::Connection::Phase;
+
+		switch (phase) {
+			case READING_HEADER:
+			case READING_BODY:
+				return serverConfig.timeoutRequest;
+			case HANDLING:
+				return serverConfig.timeoutHandler;
+			case SENDING:
+				return serverConfig.timeoutResponse;
+			case IDLE:
+			default:
+				return serverConfig.timeoutIdle;
+		}
+	}
+
+	// Cached files hold their fds, which clients and CGI pipes of every
+	// worker need too, so one worker's cache is held to a quarter of its
+	// share of the limit.
+	std::size_t fileCacheCapacityOf(const Config& config) {
+		struct rlimit limit;
+
+		if (::getrlimit(RLIMIT_NOFILE, &limit) < 0 || limit.rlim_cur == RLIM_INFINITY) {
+			return config.openFileCacheSize;
+		}
+
+		return std::min<std::size_t>(config.openFileCacheSize, limit.rlim_cur / 4 / config.workerThreads);
+	}
+}
+
+EventLoop::EventLoop(const Config& config, bool isReusePort)
+	: _now(utils::CoarseClock::local().nowMs())
+	, _openFileCacheSize(fileCacheCapacityOf(config))
+	, _openFileCacheValid(config.openFileCacheValid)
+	, _responseCacheSize(config.responseCacheSize)
+	, _responseCacheMaxFile(config.responseCacheMaxFile)
+	, _timers(_now)
+	, _poller(Poller::create(config.eventBackend)) {
+	_servers.reserve(config.servers.size());
+
+	for (const auto& serverConfig : config.servers) {
+		_servers.push_back(std::make_unique<Server>(serverConfig, isReusePort));
+	}
+
+	for (auto& server : _servers) {
+		for (const int serverFd : server->getServerFds()) {
+			_addHandle(serverFd, EventHandle::Type::LISTENER, *server, nullptr);
+		}
+	}
+}
+
+// Runs on the worker thread, which is what the thread-local caches need.
+void EventLoop::run() {
+	utils::CoarseClock& clock = utils::CoarseClock::local();
+
+	utils::FileCache::local().configure(_openFileCacheSize, _openFileCacheValid);
+	http::ResponseCache::local().configure(_responseCacheSize, _responseCacheMaxFile);
+
+	while (_handleByFd.size()) {
+		int timeout = _timers.getTimeout(_now);
+
+		// Killed scripts exit without a pipe event to wake us up
+		if (_hasExitingProcesses && (timeout < 0 || timeout > REAP_INTERVAL_MS)) {
+			timeout = REAP_INTERVAL_MS;
+		}
+
+		int ret = _poller->wait(_readyEvents, timeout);
+
+		if (ret == -1 && errno != EINTR) {
+			perror("Poll failed");
+		}
+
+		// The one clock reading of the round, which everything handled in it shares
+		clock.update();
+		_now = clock.nowMs();
+
+		for (const auto& event : _readyEvents) {
+			_dispatch(*static_cast<EventHandle*>(event.data), event.revents);
+		}
+
+		_timers.advance(_now, [this](TimerWheel::Timer& timer) {
+			_onTimeout(*static_cast<EventHandle*>(timer.data));
+		});
+
+		_hasExitingProcesses = false;
+
+		for (auto& server : _servers) {
+			_updatePipeConnections(*server);
+		}
+	}
+}
+
+void EventLoop::_addHandle(int fd, EventHandle::Type type, Server& server, http::Connection* connection) {
+	auto [it, isInserted] = _handleByFd.try_emplace(fd, fd, type, POLLIN, &server, connection);
+
+	if (isInserted) {
+		it->second.timer.data = &it->second;
+		_poller->add(fd, POLLIN, &it->second);
+	}
+}
+
+void EventLoop::_removeHandle(int fd) {
+	auto it = _handleByFd.find(fd);
+
+	if (it == _handleByFd.end()) {
+		return;
+	}
+
+	_timers.cancel(it->second.timer);
+	_poller->remove(fd);
+	_handleByFd.erase(it);
+}
+
+void EventLoop::_dispatch(EventHandle& handle, short revents) {
+	using enum EventHandle::Type;
+
+	switch (handle.type) {
+		case LISTENER:
+			if (revents & POLLIN) {
+				_accept(handle);
+			}
+			break;
+		case CLIENT:
+			_processClient(handle, revents);
+			break;
+		case PIPE:
+			_processPipe(handle, revents);
+			break;
+	}
+}
+
+void EventLoop::_accept(EventHandle& handle) {
+	Server& server = *handle.server;
+	http::Connection* connection = server.addClientTo(handle.fd);
+
+	// The pending connection would wake every round until an fd is free,
+	// so the listener rests for a while instead
+	if (connection == nullptr && (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM)) {
+		handle.events = 0;
+		_poller->modify(handle.fd, handle.events, &handle);
+		_timers.schedule(handle.timer, _now + ACCEPT_BACKOFF_MS);
+	} else if (connection != nullptr) {
+		const int fd = connection->getClientSocket();
+
+		_addHandle(fd, EventHandle::Type::CLIENT, server, connection);
+		_armTimer(_handleByFd.at(fd), false);
+	}
+}
+
+void EventLoop::_processClient(EventHandle& handle, short revents) {
+	const int fd = handle.fd;
+	Server& server = *handle.server;
+	http::Connection& connection = *handle.connection;
+	const short events = handle.events;
+
+	if (revents & (POLLHUP | POLLERR)) {
+		server.close(fd);
+	} else {
+		if (revents & POLLIN) {
+			server.process(connection, handle.events);
+		}
+
+		if ((revents & POLLOUT) && !connection.isClosed()) {
+			server.sendResponse(connection, handle.events);
+		}
+	}
+
+	_updateClient(handle, events, true);
+}
+
+void EventLoop::_updateClient(EventHandle& handle, short previousEvents, bool isActive) {
+	const int fd = handle.fd;
+
+	if (handle.connection->isClosed()) {
+		Server& server = *handle.server;
+
+		_removeHandle(fd);
+		server.removeClient(fd);
+		return;
+	}
+
+	if (handle.events != previousEvents) {
+		_poller->modify(fd, handle.events, &handle);
+	}
+
+	_armTimer(handle, isActive);
+}
+
+// Header, handler and idle deadlines are fixed when their phase starts, so
+// a client trickling bytes cannot hold a connection forever. Body and send
+// deadlines are pushed back on every bit of progress instead, as they only
+// guard against a stalled peer on a transfer that may legitimately be long.
+void EventLoop::_armTimer(EventHandle& handle, bool isActive) {
+	using enum http::Connection::Phase;
+
+	const http::Connection::Phase phase = handle.connection->getPhase();
+	const bool isProgress = isActive && (phase == READING_BODY || phase == SENDING);
+
+	if (phase == handle.phase && handle.timer.isArmed() && !isProgress) {
+		return;
+	}
+
+	handle.phase = phase;
+	_timers.schedule(handle.timer, _now + timeoutOf(phase, handle.server->getConfig()));
+}
+
+void EventLoop::_onTimeout(EventHandle& handle) {
+	if (handle.type == EventHandle::Type::LISTENER) {
+		handle.events = POLLIN;
+		_poller->modify(handle.fd, handle.events, &handle);
+		return;
+	}
+
+	if (handle.type != EventHandle::Type::CLIENT) {
+		return;
+	}
+
+	const short events = handle.events;
+
+	handle.server->timeOut(*handle.connection);
+
+	if (handle.connection->getPhase() == http::Connection::Phase::SENDING) {
+		handle.events |= POLLOUT;
+	}
+
+	_updateClient(handle, events, false);
+}
+
+void EventLoop::_processPipe(EventHandle& handle, short revents) {
+	handle.server->processPipe(handle.fd, revents, _changedClientFds);
+	_wakeClients();
+}
+
+// Script output that makes the head response sendable turns POLLOUT on
+// for its client, and a script taking in the request body lets it be read
+// from again; both count as progress for the client's deadline. Clients
+// are never dropped here, as their own event may still be due in this
+// round: one closed meanwhile is left to the POLLOUT it gets.
+void EventLoop::_wakeClients() {
+	for (const int fd : _changedClientFds) {
+		auto it = _handleByFd.find(fd);
+
+		if (it == _handleByFd.end() || it->second.type != EventHandle::Type::CLIENT) {
+			continue;
+		}
+
+		EventHandle& client = it->second;
+		http::Connection& connection = *client.connection;
+
+		if (connection.isClosed()) {
+			continue;
+		}
+
+		const short events = client.events;
+
+		if (!(client.events & POLLIN) && connection.canRead()) {
+			client.server->resume(connection, client.events);
+		}
+
+		if (connection.hasReadyResponse() || connection.isClosed()) {
+			client.events |= POLLOUT;
+		}
+
+		if (client.events != events) {
+			_poller->modify(client.fd, client.events, &client);
+		}
+
+		_armTimer(client, true);
+	}
+
+	_changedClientFds.clear();
+}
+
+// Runs after each round of events, so pipe handles are only dropped, and
+// their fds closed, once no ready event can still refer to them.
+void EventLoop::_updatePipeConnections(Server& server) {
+	server.dispatchUpstreams(_changedClientFds);
+	_wakeClients();
+
+	auto& upstreams = server.getUpstreams();
+
+	for (auto it = upstreams.begin(); it != upstreams.end();) {
+		auto& [pipeFd, upstream] = *it;
+
+		if (!upstream->isPipeOpen(pipeFd)) {
+			_removeHandle(pipeFd);
+			upstream->closePipe(pipeFd);
+			it = upstreams.erase(it);
+			continue;
+		}
+
+		const short events = upstream->getEvents(pipeFd);
+		auto [handle, isInserted] = _handleByFd.try_emplace(pipeFd, pipeFd, EventHandle::Type::PIPE, events, &server, nullptr);
+
+		if (isInserted) {
+			_poller->add(pipeFd, events, &handle->second);
+		} else if (handle->second.events != events) {
+			handle->second.events = events;
+			_poller->modify(pipeFd, events, &handle->second);
+		}
+
+		it++;
+	}
+
+	_hasExitingProcesses = server.reapProcesses() || _hasExitingProcesses;
+}
@@ -0,0 +1,656 @@
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "FastCgi.hpp"
+
+using http::StatusCode;
+
+namespace fastcgi {
+	namespace {
+		constexpr std::uint16_t ROLE_RESPONDER = 1;
+		constexpr std::uint8_t FLAG_KEEP_CONN = 1;
+
+		void appendLength(std::string& out, std::size_t length) {
+			if (length < 0x80) {
+				out.push_back(static_cast<char>(length));
+				return;
+			}
+
+			out.push_back(static_cast<char>(((length >> 24) & 0x7f) | 0x80));
+			out.push_back(static_cast<char>((length >> 16) & 0xff));
+			out.push_back(static_cast<char>((length >> 8) & 0xff));
+			out.push_back(static_cast<char>(length & 0xff));
+		}
+
+		std::size_t readLength(std::string_view& content) {
+			if (content.empty()) {
+				throw std::invalid_argument("Truncated FastCGI name-value pair");
+			}
+
+			const auto* bytes = reinterpret_cast<const std::uint8_t*>(content.data());
+
+			if (bytes[0] < 0x80) {
+				content.remove_prefix(1);
+				return bytes[0];
+			}
+
+			if (content.size() < 4) {
+				throw std::invalid_argument("Truncated FastCGI name-value pair");
+			}
+
+			const std::size_t length = (static_cast<std::size_t>(bytes[0] & 0x7f) << 24)
+				| (static_cast<std::size_t>(bytes[1]) << 16)
+				| (static_cast<std::size_t>(bytes[2]) << 8)
+				| bytes[3];
+
+			content.remove_prefix(4);
+			return length;
+		}
+	}
+
+	// Content is padded to a multiple of 8 bytes, as the specification advises
+	void appendRecord(std::string& out, RecordType type, std::uint16_t requestId, std::string_view content) {
+		const std::size_t paddingLength = (8 - content.size() % 8) % 8;
+		const char header[HEADER_SIZE] {
+			static_cast<char>(VERSION),
+			static_cast<char>(type),
+			static_cast<char>(requestId >> 8),
+			static_cast<char>(requestId & 0xff),
+			static_cast<char>(content.size() >> 8),
+			static_cast<char>(content.size() & 0xff),
+			static_cast<char>(paddingLength),
+			0
+		};
+
+		out.append(header, HEADER_SIZE);
+		out.append(content);
+		out.append(paddingLength, '\0');
+	}
+
+	void appendBeginRequest(std::string& out, std::uint16_t requestId) {
+		const char body[8] { 0, ROLE_RESPONDER, FLAG_KEEP_CONN, 0, 0, 0, 0, 0 };
+
+		appendRecord(out, RecordType::BEGIN_REQUEST, requestId, std::string_view(body, sizeof(body)));
+	}
+
+	// The pairs form one stream, so a pair may span two records
+	void appendParams(std::string& out, std::uint16_t requestId, const NameValues& nameValues) {
+		std::string stream;
+
+		for (const auto& [name, value] : nameValues) {
+			appendNameValue(stream, name, value);
+		}
+
+		for (std::size_t offset = 0; offset < stream.size(); offset += MAX_CONTENT_SIZE) {
+			appendRecord(out, RecordType::PARAMS, requestId, std::string_view(stream).substr(offset, MAX_CONTENT_SIZE));
+		}
+
+		appendRecord(out, RecordType::PARAMS, requestId, "");
+	}
+
+	void appendNameValue(std::string& out, std::string_view name, std::string_view value) {
+		appendLength(out, name.size());
+		appendLength(out, value.size());
+		out.append(name);
+		out.append(value);
+	}
+
+	Header parseHeader(const std::uint8_t* data) {
+		if (data[0] != VERSION) {
+			throw std::invalid_argument("Unsupported FastCGI version");
+		}
+
+		return Header {
+			static_cast<RecordType>(data[1]),
+			static_cast<std::uint16_t>((data[2] << 8) | data[3]),
+			static_cast<std::uint16_t>((data[4] << 8) | data[5]),
+			data[6]
+		};
+	}
+
+	NameValues parseNameValues(std::string_view content) {
+		NameValues nameValues;
+
+		while (!content.empty()) {
+			const std::size_t nameLength = readLength(content);
+			const std::size_t valueLength = readLength(content);
+
+			if (content.size() < nameLength + valueLength) {
+				throw std::invalid_argument("Truncated FastCGI name-value pair");
+			}
+
+			nameValues.emplace_back(content.substr(0, nameLength), content.substr(nameLength, valueLength));
+			content.remove_prefix(nameLength + valueLength);
+		}
+
+		return nameValues;
+	}
+}
+
+FastCgiConnection::FastCgiConnection(const std::string& address) {
+	_connect(address);
+	_askValues();
+}
+
+FastCgiConnection::FastCgiConnection(int fd) : _fd(fd), _isOpen(true) {
+	_askValues();
+}
+
+FastCgiConnection::~FastCgiConnection() {
+	closePipe(_fd);
+}
+
+// unix:/path, or host:port with a numeric IPv4 host or localhost, so that
+// nothing here blocks on a name lookup
+void FastCgiConnection::_connect(const std::string& address) {
+	sockaddr_storage storage {};
+	socklen_t length = 0;
+
+	if (address.starts_with("unix:")) {
+		auto& unixAddress = reinterpret_cast<sockaddr_un&>(storage);
+		const std::string path = address.substr(5);
+
+		if (path.empty() || path.size() >= sizeof(unixAddress.sun_path)) {
+			throw std::runtime_error("Invalid FastCGI address: " + address);
+		}
+
+		unixAddress.sun_family = AF_UNIX;
+		std::memcpy(unixAddress.sun_path, path.c_str(), path.size() + 1);
+		length = sizeof(unixAddress);
+	} else {
+		auto& inetAddress = reinterpret_cast<sockaddr_in&>(storage);
+		const std::size_t colonPos = address.rfind(':');
+		std::string host = address.substr(0, colonPos);
+		unsigned port = 0;
+
+		if (host == "localhost") {
+			host = "127.0.0.1";
+		}
+
+		if (
+			colonPos == std::string::npos
+			|| std::from_chars(address.data() + colonPos + 1, address.data() + address.size(), port).ec != std::errc()
+			|| port == 0 || port > 0xffff
+			|| ::inet_pton(AF_INET, host.c_str(), &inetAddress.sin_addr) != 1
+		) {
+			throw std::runtime_error("Invalid FastCGI address: " + address);
+		}
+
+		inetAddress.sin_family = AF_INET;
+		inetAddress.sin_port = htons(static_cast<std::uint16_t>(port));
+		length = sizeof(inetAddress);
+	}
+
+	_fd = ::socket(storage.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+	if (_fd < 0) {
+		throw std::runtime_error("Failed to create FastCGI socket: " + std::string(strerror(errno)));
+	}
+
+	if (::connect(_fd, reinterpret_cast<sockaddr*>(&storage), length) < 0) {
+		if (errno != EINPROGRESS && errno != EAGAIN) {
+			const std::string error = strerror(errno);
+
+			::close(_fd);
+			_fd = -1;
+			throw std::runtime_error("Failed to connect to " + address + ": " + error);
+		}
+
+		_isConnecting = true;
+	}
+
+	_isOpen = true;
+}
+
+void FastCgiConnection::_askValues() {
+	std::string values;
+
+	fastcgi::appendNameValue(values, "FCGI_MAX_REQS", "");
+	fastcgi::appendNameValue(values, "FCGI_MPXS_CONNS", "");
+	fastcgi::appendRecord(_out, fastcgi::RecordType::GET_VALUES, 0, values);
+}
+
+void FastCgiConnection::begin(const fastcgi::NameValues& params, std::shared_ptr<http::RequestBody> input, CgiOutput output) {
+	const std::uint16_t requestId = _nextRequestId();
+
+	fastcgi::appendBeginRequest(_out, requestId);
+	fastcgi::appendParams(_out, requestId, params);
+	_exchanges.emplace(requestId, Exchange { std::move(output), std::move(input), false });
+}
+
+std::size_t FastCgiConnection::getCapacity() const {
+	if (!_isOpen || _exchanges.size() >= _maxRequests) {
+		return 0;
+	}
+
+	return _maxRequests - _exchanges.size();
+}
+
+void FastCgiConnection::shutdown() {
+	if (_exchanges.empty()) {
+		_isOpen = false;
+	}
+}
+
+std::size_t FastCgiConnection::getRequestCount() const {
+	return _exchanges.size();
+}
+
+bool FastCgiConnection::isServing(int clientFd) const {
+	return std::any_of(_exchanges.begin(), _exchanges.end(), [clientFd](const auto& entry) {
+		return entry.second.output.isAttached() && entry.second.output.getClientFd() == clientFd;
+	});
+}
+
+bool FastCgiConnection::isOpen() const {
+	return _isOpen;
+}
+
+int FastCgiConnection::getFd() const {
+	return _fd;
+}
+
+short FastCgiConnection::getEvents(int fd) const {
+	(void)fd;
+
+	if (_isConnecting) {
+		return POLLOUT;
+	}
+
+	short events = POLLIN;
+
+	for (const auto& [requestId, exchange] : _exchanges) {
+		if (exchange.output.getBufferedBytes() > MAX_BUFFERED_OUTPUT) {
+			events = 0;
+		}
+
+		if (!exchange.isInputSent && (exchange.input == nullptr || exchange.input->size() > 0 || exchange.input->isComplete())) {
+			events |= POLLOUT;
+		}
+	}
+
+	if (_outOffset < _out.size()) {
+		events |= POLLOUT;
+	}
+
+	return events;
+}
+
+bool FastCgiConnection::isPipeOpen(int fd) const {
+	return fd == _fd && _isOpen;
+}
+
+void FastCgiConnection::closePipe(int fd) {
+	if (fd < 0 || fd != _fd) {
+		return;
+	}
+
+	::close(_fd);
+	_fd = -1;
+	_isOpen = false;
+}
+
+void FastCgiConnection::process(int fd, short revents, std::vector<int>& clientFds) {
+	if (!isPipeOpen(fd)) {
+		return;
+	}
+
+	if (_isConnecting) {
+		int error = 0;
+		socklen_t length = sizeof(error);
+
+		if (::getsockopt(_fd, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error != 0) {
+			std::cerr << "Failed to connect to FastCGI server: " << strerror(error != 0 ? error : errno) << std::endl;
+			return _fail(clientFds);
+		}
+
+		_isConnecting = false;
+	}
+
+	if (revents & (POLLIN | POLLHUP | POLLERR)) {
+		_receive(clientFds);
+	}
+
+	if (_isOpen && (revents & POLLOUT)) {
+		_addInput(clientFds);
+		_send();
+
+		if (!_isOpen) {
+			_fail(clientFds);
+		}
+	}
+}
+
+// The request id stays taken until the server ends the request, which it
+// does for an aborted one as well.
+void FastCgiConnection::abort(int clientFd) {
+	for (auto& [requestId, exchange] : _exchanges) {
+		if (!exchange.output.isAttached() || exchange.output.getClientFd() != clientFd) {
+			continue;
+		}
+
+		exchange.output.detach();
+		exchange.input.reset();
+		exchange.isInputSent = true;
+		fastcgi::appendRecord(_out, fastcgi::RecordType::ABORT_REQUEST, requestId, "");
+	}
+}
+
+void FastCgiConnection::_send() {
+	while (_outOffset < _out.size()) {
+		const ssize_t bytesSent = ::send(_fd, _out.data() + _outOffset, _out.size() - _outOffset, MSG_NOSIGNAL);
+
+		if (bytesSent < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			_isOpen = (errno == EAGAIN || errno == EWOULDBLOCK);
+			break;
+		}
+
+		_outOffset += static_cast<std::size_t>(bytesSent);
+	}
+
+	if (_outOffset == _out.size()) {
+		_out.clear();
+		_outOffset = 0;
+	} else if (_outOffset >= _out.size() / 2) {
+		_out.erase(0, _outOffset);
+		_outOffset = 0;
+	}
+}
+
+// Records are read out of the buffer in place, and the bytes of a record
+// still incomplete are kept for the next read.
+void FastCgiConnection::_receive(std::vector<int>& clientFds) {
+	thread_local std::array<std::uint8_t, READ_BUFFER_SIZE> buffer;
+	const ssize_t bytesRead = ::recv(_fd, buffer.data(), buffer.size(), 0);
+
+	if (bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+		return;
+	}
+
+	if (bytesRead <= 0) {
+		return _fail(clientFds);
+	}
+
+	_in.append(reinterpret_cast<const char*>(buffer.data()), static_cast<std::size_t>(bytesRead));
+
+	std::size_t offset = 0;
+
+	while (_in.size() - offset >= fastcgi::HEADER_SIZE) {
+		fastcgi::Header header;
+
+		try {
+			header = fastcgi::parseHeader(reinterpret_cast<const std::uint8_t*>(_in.data() + offset));
+		} catch (const std::invalid_argument& e) {
+			std::cerr << e.what() << std::endl;
+			return _fail(clientFds);
+		}
+
+		const std::size_t recordSize = fastcgi::HEADER_SIZE + header.contentLength + header.paddingLength;
+
+		if (_in.size() - offset < recordSize) {
+			break;
+		}
+
+		_handleRecord(header, std::string_view(_in).substr(offset + fastcgi::HEADER_SIZE, header.contentLength), clientFds);
+
+		if (!_isOpen) {
+			return;
+		}
+
+		offset += recordSize;
+	}
+
+	_in.erase(0, offset);
+}
+
+void FastCgiConnection::_handleRecord(const fastcgi::Header& header, std::string_view content, std::vector<int>& clientFds) {
+	using fastcgi::RecordType;
+
+	if (header.type == RecordType::GET_VALUES_RESULT) {
+		return _handleValues(content);
+	}
+
+	auto it = _exchanges.find(header.requestId);
+
+	if (it == _exchanges.end()) {
+		return;
+	}
+
+	CgiOutput& output = it->second.output;
+
+	switch (header.type) {
+		case RecordType::STDOUT:
+			if (output.isAttached() && !content.empty()) {
+				output.append(reinterpret_cast<const std::uint8_t*>(content.data()), content.size());
+				clientFds.push_back(output.getClientFd());
+			}
+			break;
+		case RecordType::STDERR:
+			std::cerr << content;
+			break;
+		case RecordType::END_REQUEST:
+			_endRequest(header.requestId, content, clientFds);
+			break;
+		default:
+			break;
+	}
+}
+
+// A server that does not multiplex, or does not answer, gets one request
+// at a time.
+void FastCgiConnection::_handleValues(std::string_view content) {
+	fastcgi::NameValues values;
+	std::size_t maxRequests = 0;
+	bool isMultiplexing = false;
+
+	try {
+		values = fastcgi::parseNameValues(content);
+	} catch (const std::invalid_argument& e) {
+		std::cerr << e.what() << std::endl;
+		return;
+	}
+
+	for (const auto& [name, value] : values) {
+		if (name == "FCGI_MPXS_CONNS") {
+			isMultiplexing = (value == "1");
+		} else if (name == "FCGI_MAX_REQS") {
+			std::from_chars(value.data(), value.data() + value.size(), maxRequests);
+		}
+	}
+
+	if (isMultiplexing && maxRequests > 1) {
+		_maxRequests = std::min<std::size_t>(maxRequests, 0xffff);
+	}
+}
+
+void FastCgiConnection::_endRequest(std::uint16_t requestId, std::string_view content, std::vector<int>& clientFds) {
+	using fastcgi::ProtocolStatus;
+
+	CgiOutput& output = _exchanges.at(requestId).output;
+	const auto status = content.size() > 4 ? static_cast<ProtocolStatus>(content[4]) : ProtocolStatus::REQUEST_COMPLETE;
+
+	if (output.isAttached()) {
+		clientFds.push_back(output.getClientFd());
+	}
+
+	switch (status) {
+		case ProtocolStatus::REQUEST_COMPLETE:
+			output.finish();
+			break;
+		case ProtocolStatus::CANT_MPX_CONN:
+			_maxRequests = 1;
+			output.fail(StatusCode::SERVICE_UNAVAILABLE_503);
+			break;
+		case ProtocolStatus::OVERLOADED:
+			output.fail(StatusCode::SERVICE_UNAVAILABLE_503);
+			break;
+		default:
+			output.fail(StatusCode::BAD_GATEWAY_502);
+			break;
+	}
+
+	_exchanges.erase(requestId);
+}
+
+// Requests whose header already went out are cut short, closing their
+// connections, as the rest of their output is lost
+void FastCgiConnection::_fail(std::vector<int>& clientFds) {
+	for (auto& [requestId, exchange] : _exchanges) {
+		if (exchange.output.isAttached()) {
+			clientFds.push_back(exchange.output.getClientFd());
+			exchange.output.fail(StatusCode::BAD_GATEWAY_502);
+		}
+	}
+
+	_exchanges.clear();
+	_out.clear();
+	_outOffset = 0;
+	_in.clear();
+	_isOpen = false;
+}
+
+// STDIN records are only added while little is waiting to be sent, so a
+// large body is not copied in one go, and from what was received of it so
+// far. The clients whose body was taken in may be read from again.
+void FastCgiConnection::_addInput(std::vector<int>& clientFds) {
+	for (auto& [requestId, exchange] : _exchanges) {
+		http::RequestBody* input = exchange.input.get();
+		bool isTaken = false;
+
+		while (!exchange.isInputSent && _out.size() - _outOffset < MAX_BUFFERED_INPUT) {
+			if (input != nullptr && input->size() == 0 && !input->isComplete()) {
+				break;
+			}
+
+			const std::size_t size = (input != nullptr) ? std::min(input->size(), fastcgi::MAX_CONTENT_SIZE) : 0;
+			const auto* data = (input != nullptr) ? reinterpret_cast<const char*>(input->data()) : "";
+
+			fastcgi::appendRecord(_out, fastcgi::RecordType::STDIN, requestId, std::string_view(data, size));
+			exchange.isInputSent = (size == 0);
+			isTaken = isTaken || size > 0;
+
+			if (input != nullptr) {
+				input->consume(size);
+			}
+		}
+
+		if (isTaken && exchange.output.isAttached()) {
+			clientFds.push_back(exchange.output.getClientFd());
+		}
+
+		if (exchange.isInputSent) {
+			exchange.input.reset();
+		}
+	}
+}
+
+std::uint16_t FastCgiConnection::_nextRequestId() {
+	do {
+		_lastRequestId++;
+	} while (_lastRequestId == 0 || _exchanges.contains(_lastRequestId));
+
+	return _lastRequestId;
+}
+
+FastCgiPool::FastCgiPool(const std::string& address, std::size_t maxConnections, std::unordered_map<int, std::shared_ptr<Upstream>>& upstreamByFd)
+	: _address(address)
+	, _maxConnections(maxConnections)
+	, _upstreamByFd(upstreamByFd) {
+}
+
+void FastCgiPool::submit(fastcgi::NameValues params, std::shared_ptr<http::RequestBody> input, CgiOutput output) {
+	if (!_queue.empty()) {
+		if (_queue.size() >= MAX_QUEUED_REQUESTS) {
+			return output.fail(StatusCode::SERVICE_UNAVAILABLE_503);
+		}
+
+		_queue.push_back(Request { std::move(params), std::move(input), std::move(output) });
+		return;
+	}
+
+	try {
+		if (FastCgiConnection* connection = _findConnection()) {
+			return connection->begin(params, std::move(input), std::move(output));
+		}
+	} catch (const std::runtime_error& e) {
+		std::cerr << e.what() << std::endl;
+		return output.fail(StatusCode::BAD_GATEWAY_502);
+	}
+
+	_queue.push_back(Request { std::move(params), std::move(input), std::move(output) });
+}
+
+void FastCgiPool::dispatch(std::vector<int>& clientFds) {
+	while (!_queue.empty()) {
+		FastCgiConnection* connection = nullptr;
+
+		try {
+			connection = _findConnection();
+		} catch (const std::runtime_error& e) {
+			std::cerr << e.what() << std::endl;
+
+			for (Request& request : _queue) {
+				clientFds.push_back(request.output.getClientFd());
+				request.output.fail(StatusCode::BAD_GATEWAY_502);
+			}
+
+			_queue.clear();
+			return;
+		}
+
+		if (connection == nullptr) {
+			return;
+		}
+
+		Request& request = _queue.front();
+
+		connection->begin(request.params, std::move(request.input), std::move(request.output));
+		_queue.pop_front();
+	}
+}
+
+void FastCgiPool::abort(int clientFd) {
+	std::erase_if(_queue, [clientFd](const Request& request) {
+		return request.output.getClientFd() == clientFd;
+	});
+}
+
+// The least busy connection with room is used, so that requests spread over
+// the connections the server has workers for.
+FastCgiConnection* FastCgiPool::_findConnection() {
+	std::erase_if(_connections, [](const std::shared_ptr<FastCgiConnection>& connection) {
+		return !connection->isOpen();
+	});
+
+	FastCgiConnection* found = nullptr;
+
+	for (auto& connection : _connections) {
+		if (connection->getCapacity() > 0 && (found == nullptr || connection->getRequestCount() < found->getRequestCount())) {
+			found = connection.get();
+		}
+	}
+
+	if (found != nullptr || _connections.size() >= _maxConnections) {
+		return found;
+	}
+
+	auto connection = std::make_shared<FastCgiConnection>(_address);
+
+	_upstreamByFd[connection->getFd()] = connection;
+	_connections.push_back(connection);
+	return connection.get();
+}
@@ -0,0 +1,61 @@
+#include "Poller.hpp"
+
+void PollPoller::add(int fd, short events, void* data) {
+	if (_indexByFd.find(fd) != _indexByFd.end()) {
+		return;
+	}
+
+	_pollFds.push_back({ fd, events, 0 });
+	_dataByIndex.push_back(data);
+	_indexByFd[fd] = _pollFds.size() - 1;
+}
+
+void PollPoller::modify(int fd, short events, void* data) {
+	auto it = _indexByFd.find(fd);
+
+	if (it == _indexByFd.end()) {
+		return;
+	}
+
+	_pollFds[it->second].events = events;
+	_dataByIndex[it->second] = data;
+}
+
+void PollPoller::remove(int fd) {
+	auto it = _indexByFd.find(fd);
+
+	if (it == _indexByFd.end()) {
+		return;
+	}
+
+	const std::size_t index = it->second;
+
+	_indexByFd.erase(it);
+
+	if (index != _pollFds.size() - 1) {
+		std::swap(_pollFds[index], _pollFds.back());
+		std::swap(_dataByIndex[index], _dataByIndex.back());
+		_indexByFd[_pollFds[index].fd] = index;
+	}
+
+	_pollFds.pop_back();
+	_dataByIndex.pop_back();
+}
+
+int PollPoller::wait(std::vector<Event>& events, int timeoutMs) {
+	events.clear();
+
+	const int ret = ::poll(_pollFds.data(), _pollFds.size(), timeoutMs);
+
+	if (ret <= 0) {
+		return ret;
+	}
+
+	for (std::size_t i = 0; i < _pollFds.size() && events.size() < static_cast<std::size_t>(ret); i++) {
+		if (_pollFds[i].revents != 0) {
+			events.push_back({ _dataByIndex[i], _pollFds[i].revents });
+		}
+	}
+
+	return ret;
+}
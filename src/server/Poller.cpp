@@ -0,0 +1,16 @@
+#include <stdexcept>
+#include "Poller.hpp"
+
+std::unique_ptr<Poller> Poller::create(EventBackend backend) {
+	switch (backend) {
+		case EventBackend::EPOLL:
+#ifdef __linux__
+			return std::make_unique<EpollPoller>();
+#else
+			throw std::runtime_error("epoll is not supported on this platform");
+#endif
+		case EventBackend::POLL:
+		default:
+			return std::make_unique<PollPoller>();
+	}
+}
@@ -0,0 +1,78 @@
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "Process.hpp"
+
+namespace {
+	std::vector<char*> toArgv(std::vector<std::string>& strings) {
+		std::vector<char*> argv;
+
+		argv.reserve(strings.size() + 1);
+
+		for (auto& string : strings) {
+			argv.push_back(string.data());
+		}
+
+		argv.push_back(nullptr);
+		return argv;
+	}
+}
+
+Process::~Process() {
+	if (!_isReaped) {
+		kill();
+		reap();
+	}
+}
+
+void Process::kill() {
+	if (!_isReaped && _pid > 0) {
+		::kill(_pid, SIGKILL);
+	}
+}
+
+bool Process::reap() {
+	if (_isReaped || _pid <= 0) {
+		return true;
+	}
+
+	const pid_t pid = ::waitpid(_pid, nullptr, WNOHANG);
+
+	_isReaped = (pid == _pid || (pid < 0 && errno == ECHILD));
+	return _isReaped;
+}
+
+pid_t Process::getPid() const {
+	return _pid;
+}
+
+// Everything the child needs is allocated before fork(): the server may
+// be multithreaded, so the child sticks to async-signal-safe calls.
+void Process::_spawn(std::vector<std::string> args, std::vector<std::string> env, const std::string& directory, int inputFd, int outputFd) {
+	std::vector<char*> argv = toArgv(args);
+	std::vector<char*> envp = toArgv(env);
+
+	_pid = ::fork();
+
+	if (_pid < 0) {
+		throw std::runtime_error("Failed to fork " + args[0] + ": " + std::string(strerror(errno)));
+	}
+
+	if (_pid == 0) {
+		::signal(SIGPIPE, SIG_DFL);
+
+		if (
+			(inputFd >= 0 && ::dup2(inputFd, STDIN_FILENO) < 0)
+			|| (outputFd >= 0 && ::dup2(outputFd, STDOUT_FILENO) < 0)
+			|| ::chdir(directory.c_str()) < 0
+		) {
+			::_exit(127);
+		}
+
+		::execve(argv[0], argv.data(), envp.data());
+		::_exit(127);
+	}
+}
@@ -1,3 +1,5 @@
+#include <cerrno>
+#include <cstring>
 #include <iostream>
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -6,84 +8,171 @@
 #include "utils/index.hpp"
 #include "SignalHandle.hpp"
 
-Server::Server(const ServerConfig& serverConfig) : _serverConfig(serverConfig), _router(serverConfig) {
+namespace {
+	fastcgi::NameValues toNameValues(const std::vector<std::string>& env) {
+		fastcgi::NameValues nameValues;
+
+		nameValues.reserve(env.size());
+
+		for (const std::string& variable : env) {
+			const std::size_t equalPos = variable.find('=');
+
+			nameValues.emplace_back(variable.substr(0, equalPos), variable.substr(equalPos + 1));
+		}
+
+		return nameValues;
+	}
+
+	std::string workerPoolName(const Location& loc, const std::string& extension) {
+		return loc.path + " " + extension;
+	}
+}
+
+Server::Server(const ServerConfig& serverConfig, bool isReusePort) : _serverConfig(serverConfig), _router(serverConfig) {
 	_router.get(handleGetRequest);
 	_router.post(handlePostRequest);
 	_router.del(handleDeleteRequest);
+	_router.cgi([this](const Location& loc, const CgiScript& script, http::Request& req, http::Response& res) {
+		_startCgi(loc, script, req, res);
+	});
+
+	// Workers are started ahead of the first request, as that is their point
+	for (const Location& loc : serverConfig.locations) {
+		for (const auto& [extension, program] : loc.cgiWorker) {
+			_workerPoolByName[workerPoolName(loc, extension)] = std::make_unique<CgiWorkerPool>(loc, extension, _upstreamByFd, _processes);
+		}
+	}
 
 	_serverFds.reserve(serverConfig.ports.size());
 
 	for (const int port : serverConfig.ports) {
-		int serverFd = utils::createPassiveSocket(serverConfig.host.data(), port, 128, true);
+		int serverFd = utils::createPassiveSocket(serverConfig.host.data(), port, BACKLOG, true, isReusePort);
 		std::cout << "listening on " << serverConfig.host << ":" << port << std::endl;
 		_serverFds.emplace(serverFd);
 	}
 }
 
-void Server::addClientTo(int serverFd) {
+http::Connection* Server::addClientTo(int serverFd) {
 	sockaddr_in clientAddr {};
 	socklen_t addrLen = sizeof(clientAddr);
 
-	int clientFd = ::accept(serverFd, (struct sockaddr*)&clientAddr, &addrLen);
+	// Close-on-exec, so a CGI script does not keep other clients open
+	int clientFd = ::accept4(serverFd, (struct sockaddr*)&clientAddr, &addrLen, SOCK_NONBLOCK | SOCK_CLOEXEC);
 
-	if (clientFd >= 0) {
-		_connectionByClientFd.emplace(clientFd, http::Connection(clientFd, _serverConfig));
+	if (clientFd < 0) {
+		return nullptr;
 	}
+
+	auto [it, isInserted] = _connectionByClientFd.try_emplace(clientFd, clientFd, _serverConfig);
+	return &it->second;
 }
 
 void Server::close(int fd) {
-	if (_processByPipeFd.find(fd) != _processByPipeFd.end()) {
-		return _closePipeFd(fd);
+	auto it = _connectionByClientFd.find(fd);
+
+	if (it != _connectionByClientFd.end()) {
+		it->second.close();
 	}
+}
 
-	auto it = _connectionByClientFd.find(fd);
+void Server::process(http::Connection& con, short& events) {
+	con.read();
+	_handleRequests(con, events);
+}
 
-	if (it == _connectionByClientFd.end() || it->second.isClosed()) {
-		return;
+// Pipelined requests parsed once earlier responses went out are handled
+// right away; POLLOUT stays on while a ready response is waiting.
+void Server::sendResponse(http::Connection& con, short& events) {
+	con.sendResponse();
+	_handleRequests(con, events);
+
+	if (!con.hasReadyResponse()) {
+		events &= ~POLLOUT;
 	}
+}
 
-	for (auto& [pipeFd, process] : _processByPipeFd) {
-		if (process.clientFd == fd) {
-			_closePipeFd(pipeFd);
-			if (process.isPipeClosed) {
-				it->second.close();
-			}
-		}
+// Scripts still running for the client are aborted before it answers 504
+// or 408, as their exchanges are being replaced.
+void Server::timeOut(http::Connection& con) {
+	_abortUpstreams(con.getClientSocket());
+	con.timeOut();
+}
+
+void Server::resume(http::Connection& con, short& events) {
+	con.resume();
+	_handleRequests(con, events);
+}
+
+void Server::removeClient(int fd) {
+	_abortUpstreams(fd);
+
+	if (_connectionByClientFd.erase(fd) > 0 && ::close(fd) < 0) {
+		std::cerr << "Failed to close socket " << fd << ": " << strerror(errno) << std::endl;
 	}
 }
 
-void Server::process(int fd, short& events) {
-	auto& con = _connectionByClientFd.at(fd);
+void Server::processPipe(int fd, short revents, std::vector<int>& clientFds) {
+	auto it = _upstreamByFd.find(fd);
 
-	con.read();
+	if (it != _upstreamByFd.end()) {
+		it->second->process(fd, revents, clientFds);
+	}
+}
 
-	auto* req = con.getRequest();
-	auto* res = con.getResponse();
+void Server::dispatchUpstreams(std::vector<int>& clientFds) {
+	for (auto& [address, pool] : _fastCgiPoolByAddress) {
+		pool->dispatch(clientFds);
+	}
 
-	if (req == nullptr || res == nullptr) {
-		return;
+	for (auto& [name, pool] : _workerPoolByName) {
+		pool->dispatch(clientFds);
 	}
+}
+
+bool Server::reapProcesses() {
+	std::erase_if(_processes, [](const std::shared_ptr<Process>& process) {
+		return process->isDone() && process->reap();
+	});
 
+	return std::any_of(_processes.begin(), _processes.end(), [](const std::shared_ptr<Process>& process) {
+		return process->isDone();
+	});
+}
+
+// The client is read from only while the body it sends can be taken in,
+// which leaves the rest of it to TCP flow control.
+void Server::_handleRequests(http::Connection& con, short& events) {
 	using enum http::Response::Status;
 
-	if (res->getStatus() == PENDING) {
-		res->setStatus(IN_PROGRESS);
-		_router.handle(*req, *res);
+	// A bad chunk fails the body, and whatever was reading it is aborted
+	// before its exchange is answered
+	if (con.hasBadBody()) {
+		_abortUpstreams(con.getClientSocket());
+		con.rejectBody(http::StatusCode::BAD_REQUEST_400);
+	}
 
-		if (res->getStatus() == READY) {
-			events |= POLLOUT;
-		}
+	while (auto* exchange = con.getPendingExchange()) {
+		auto& [req, res] = *exchange;
+
+		res.setStatus(IN_PROGRESS);
+		_router.handle(req, res);
 	}
-}
 
-void Server::sendResponse(int fd, short& events) {
-	auto& con = _connectionByClientFd.at(fd);
+	if (con.hasReadyResponse()) {
+		events |= POLLOUT;
+	}
 
-	if (con.sendResponse()) {
-		events &= ~POLLOUT;
+	if (con.canRead()) {
+		events |= POLLIN;
+	} else {
+		events &= ~POLLIN;
 	}
 }
 
+const ServerConfig& Server::getConfig() const {
+	return _serverConfig;
+}
+
 const std::unordered_set<int>& Server::getServerFds() const {
 	return _serverFds;
 }
@@ -92,116 +181,88 @@ std::unordered_map<int, http::Connection>& Server::getClients() {
 	return _connectionByClientFd;
 }
 
-std::unordered_map<int, Process>& Server::getPipeProcess() {
-	return _processByPipeFd;
+std::unordered_map<int, std::shared_ptr<Upstream>>& Server::getUpstreams() {
+	return _upstreamByFd;
 }
 
-void Server::_closePipeFd(int fd) {
-	auto it = _processByPipeFd.find(fd);
+// Both pipes, or the FastCGI connection, are polled by the event loop,
+// which closes them once they are done with. Scripts with a cgi_worker
+// go to the workers already running for them.
+//
+// A body of known length is streamed to the script as it arrives, but a
+// chunked one is received whole first, as CONTENT_LENGTH has to be set
+// up front.
+void Server::_startCgi(const Location& loc, const CgiScript& script, http::Request& req, http::Response& res) {
+	const std::shared_ptr<http::RequestBody>& body = req.getBody();
+
+	if (body != nullptr && body->getLength() == http::RequestBody::UNKNOWN_LENGTH && !body->isComplete()) {
+		body->gather();
+		body->setConsumer([this, &loc, script, &req, &res](http::RequestBody& received) {
+			if (!received.isComplete()) {
+				return;
+			}
 
-	if (it != _processByPipeFd.end()) {
-		auto& process = it->second;
+			try {
+				_startCgi(loc, script, req, res);
+			} catch (const std::exception& e) {
+				std::cerr << "Failed to run " << script.path << ": " << e.what() << std::endl;
+				res.clear();
+				res.setError(http::StatusCode::INTERNAL_SERVER_ERROR_500, _serverConfig.errorPages);
+			}
+		});
+		return;
+	}
 
-		if (!process.isPipeClosed) {
-			pid_t pid;
+	auto workerPool = _workerPoolByName.find(workerPoolName(loc, script.extension));
 
-			pid = ::waitpid(process.pid, NULL, WNOHANG);
+	if (workerPool != _workerPoolByName.end()) {
+		std::vector<std::string> env = makeCgiEnv(script, _serverConfig, req, res.getClientSocket());
 
-			if (pid > 0) {
-				::close(fd);
-				process.pipeFd = -1;
-				process.isPipeClosed = true;
-				return;
-			}
+		workerPool->second->submit(toNameValues(env), body, CgiOutput(res, _serverConfig.errorPages));
+		return;
+	}
 
-			::kill(process.pid, SIGTERM);
+	if (!loc.fastcgiPass.empty()) {
+		auto& pool = _fastCgiPoolByAddress[loc.fastcgiPass];
+
+		if (pool == nullptr) {
+			pool = std::make_unique<FastCgiPool>(loc.fastcgiPass, loc.fastcgiConnections, _upstreamByFd);
 		}
+
+		std::vector<std::string> env = makeCgiEnv(script, _serverConfig, req, res.getClientSocket());
+
+		pool->submit(toNameValues(env), body, CgiOutput(res, _serverConfig.errorPages));
+		return;
 	}
+
+	auto process = std::make_shared<CgiProcess>(script, _serverConfig, req, res);
+
+	_upstreamByFd[process->getInputFd()] = process;
+	_upstreamByFd[process->getOutputFd()] = process;
+	_processes.push_back(std::move(process));
 }
 
-// char **makeEnv(char** &env, http::Request& req){
-
-// 	http::Url url = req.getUrl();
-// 	char **res = new char*[9];
-
-// 	res[0] = new char[url.scheme.size() + 1];
-// 	res[1] = new char[url.user.size() + 1];
-// 	res[2] = new char[url.password.size() + 1];
-// 	res[3] = new char[url.host.size() + 1];
-// 	res[4] = new char[url.port.size() + 1];
-// 	res[5] = new char[url.path.size() + 1];
-// 	res[6] = new char[url.query.size() + 1];
-// 	res[7] = new char[url.fragment.size() + 1];
-// 	res[8] = nullptr;
-
-// 	return res;
-// }
-
-// void deleteEnv(char **env){
-// 	for (int i = 0; env[i]; i++){
-// 		delete[] env[i];
-// 	}
-// 	delete[] env;
-// }
-
-// void Server::_cgiHandler(http::Request &req, http::Response &res) {
-
-// 	char* interpreter = "/usr/bin/python3";
-// 	// if (access(interpreter, X_OK) == -1 || access(script, X_OK) == -1){}
-// 		//return 403 forbidding
-// 	const char* script = req.getUrl().path.c_str();
-// 	char* scriptArray[2] = {const_cast<char*>(script), nullptr};
-// 	int pipefd[2];
-// 	if(pipe(pipefd) == -1)
-// 		perror("Pipe failed");
-// 	if (utils::setNonBlocking(pipefd[0]) == false)
-// 		perror("Pipe nonblocking failed");
-// 	pollfd cgiData { pipefd[0], POLLIN, 0 };
-// 	_pollfds.push_back(cgiData);
-// 	pid_t pid = fork();
-// 	if (pid == 0){
-// 		close(pipefd[0]);
-// 		if (dup2(pipefd[1], STDOUT_FILENO) == -1)
-// 			perror("Dup2 failed");
-// 		char **env = makeEnv(env, req);
-// 		execve(interpreter, scriptArray, env);
-// 		deleteEnv(env);
-// 	}
-// 	pid_t result = waitpid(pid, NULL, WNOHANG);
-// 	if (result = pid)
-// 		close(pipefd[0]);
-// }
-
-// void Server::_read(struct ::pollfd& pollFd, http::Connection& con) {
-// 	if (pollFd.revents & POLLIN == 0) {
-// 		return;
-// 	}
-
-// 	if (pollFd.fd) {
-// 		_readFromPipe(pollFd, con);
-// 	} else {
-// 		_readFromSocket(pollFd, con);
-// 	}
-// }
-
-// void Server::_readFromPipe(struct ::pollfd& pollFd, http::Connection& con) {
-// 	unsigned char buffer[4096];
-// 	ssize_t bytesRead = ::read(pollFd.fd, buffer, sizeof(buffer));
-
-// 	if (bytesRead < 0) {
-// 		con.close();
-// 		return;
-// 	}
-
-// 	http::Response* res = con.getResponse();
-// 	if (res != nullptr) {
-// 		res->getBody()->append(buffer, bytesRead);
-// 	}
-// }
+void Server::_abortUpstreams(int clientFd) {
+	for (auto& [fd, upstream] : _upstreamByFd) {
+		upstream->abort(clientFd);
+	}
+
+	for (auto& [address, pool] : _fastCgiPoolByAddress) {
+		pool->abort(clientFd);
+	}
+
+	for (auto& [name, pool] : _workerPoolByName) {
+		pool->abort(clientFd);
+	}
+}
 
 void Server::_cleanup() {
 	for (auto& [fd, con] : _connectionByClientFd) {
-		con.close();
+		::close(fd);
+	}
+
+	for (const int serverFd : _serverFds) {
+		::close(serverFd);
 	}
 }
 
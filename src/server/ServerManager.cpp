@@ -1,136 +1,62 @@
-#include <sys/socket.h>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
 #include "ServerManager.hpp"
-#include "utils/index.hpp"
+#include "Error.hpp"
+#include "http/MimeTypes.hpp"
 
-ServerManager::ServerManager(const Config& config) : _config(config) {
-	_servers.reserve(config.servers.size());
-
-	for (std::size_t i = 0; i < config.servers.size(); i++) {
-		const ServerConfig serverConfig = config.servers[i];
-		_servers.push_back(Server(serverConfig));
-    }
-
-	for (auto& server : _servers) {
-		for (const int serverFd : server.getServerFds()) {
-			_addPollFd(serverFd, server);
-		}
+namespace {
+	[[noreturn]] void failServer(std::size_t workerId, const std::string& reason) {
+		std::cerr << "Worker " << workerId << " failed, stopping the server: " << reason << std::endl;
+		std::_Exit(EXIT_FAILURE);
 	}
-}
 
-void ServerManager::listen() {
-	while (_pollFds.size()) {
-        int ret = ::poll(_pollFds.data(), _pollFds.size(), 100);
-
-		if (ret == -1) {
-			perror("Poll failed");
+	// A worker that fails takes the whole server down, whichever thread
+	// runs it: its SO_REUSEPORT listeners would go on being handed
+	// connections nobody accepts. The other loops cannot be stopped from
+	// here, so the process ends at once instead of unwinding past their
+	// threads.
+	void runWorker(EventLoop& eventLoop, std::size_t workerId) {
+		try {
+			eventLoop.run();
+		} catch (const WSException& e) {
+			failServer(workerId, e.code().message());
+		} catch (const std::exception& e) {
+			failServer(workerId, e.what());
 		}
-
-		if (ret > 0) {
-			_processPollFds();
-		}
-
-		_updatePollFds();
-    }
-}
-
-void ServerManager::_addPollFd(int fd, Server& server) {
-	auto it = _pollFdIndexByFd.find(fd);
-
-	if (it != _pollFdIndexByFd.end()) {
-		return;
 	}
-
-	_pollFds.push_back({ fd, POLLIN, 0 });
-	_pollFdIndexByFd[fd] = _pollFds.size() - 1;
-	_serverByFd.emplace(fd, std::ref(server));
 }
 
-void ServerManager::_removePollFd(int fd) {
-	auto it = _pollFdIndexByFd.find(fd);
+// The MIME types are shared by every worker, read-only once they start
+ServerManager::ServerManager(const Config& config) : _config(config) {
+	const bool isReusePort = config.workerThreads > 1;
 
-	if (it == _pollFdIndexByFd.end()) {
-		return;
+	for (const auto& [type, extensions] : config.mimeTypes) {
+		http::MimeTypes::global().add(type, extensions);
 	}
 
-	const std::size_t index = it->second;
+	_eventLoops.reserve(config.workerThreads);
 
-	_pollFdIndexByFd.erase(it);
-	_serverByFd.erase(fd);
-
-	if (index != _pollFds.size() - 1) {
-		std::swap(_pollFds[index], _pollFds.back());
-		_pollFdIndexByFd[_pollFds[index].fd] = index;
+	for (std::size_t i = 0; i < config.workerThreads; i++) {
+		_eventLoops.push_back(std::make_unique<EventLoop>(config, isReusePort));
 	}
-
-	_pollFds.pop_back();
 }
 
-void ServerManager::_processPollFds() {
-	for (auto& pollFd : _pollFds) {
-		auto& server = _serverByFd.at(pollFd.fd).get();
-		const bool isServerFd = server.getServerFds().contains(pollFd.fd);
-
-		if ((pollFd.revents & POLLHUP) && !isServerFd) {
-			server.close(pollFd.fd);
-			continue;
-		}
-
-		if (pollFd.revents & POLLIN) {
-			if (isServerFd) {
-				server.addClientTo(pollFd.fd);
-				continue;
-			}
-
-			server.process(pollFd.fd, pollFd.events);
-		}
-
-		if (pollFd.revents & POLLOUT) {
-			server.sendResponse(pollFd.fd, pollFd.events);
-		}
-	}
-}
-
-void ServerManager::_updatePollFds() {
-	for (auto& server: _servers) {
-		_updateClientConnections(server);
-		_updatePipeConnections(server);
-	}
-}
-
-void ServerManager::_updateClientConnections(Server& server) {
-	auto& clients = server.getClients();
-
-	for (auto it = clients.begin(); it != clients.end();) {
-		auto& [fd, connection] = *it;
-
-		if (connection.isTimedOut()) {
-			connection.close();
-		}
+// Every worker owns its event loop, its Servers and their SO_REUSEPORT
+// listeners, so the kernel spreads accepts across workers and nothing
+// is shared between threads. The calling thread runs the first worker.
+void ServerManager::listen() {
+	std::vector<std::thread> threads;
 
-		if (connection.isClosed()) {
-			_removePollFd(fd);
-			it = clients.erase(it);
-			continue;
-		}
+	threads.reserve(_eventLoops.size() - 1);
 
-		_addPollFd(fd, server);
-		it++;
+	for (std::size_t i = 1; i < _eventLoops.size(); i++) {
+		threads.emplace_back(runWorker, std::ref(*_eventLoops[i]), i);
 	}
-}
-
-void ServerManager::_updatePipeConnections(Server& server) {
-	auto& pipeConnections = server.getPipeProcess();
 
-	for (auto it = pipeConnections.begin(); it != pipeConnections.end();) {
-		auto& [pipeFd, process] = *it;
-
-		if (process.isPipeClosed) {
-			_removePollFd(pipeFd);
-			it = pipeConnections.erase(it);
-			continue;
-		}
+	runWorker(*_eventLoops.front(), 0);
 
-		_addPollFd(pipeFd, server);
-		it++;
+	for (auto& thread : threads) {
+		thread.join();
 	}
 }
@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <bit>
+#include "TimerWheel.hpp"
+
+namespace {
+	void initList(TimerWheel::Timer& head) {
+		head.prev = &head;
+		head.next = &head;
+	}
+
+	bool isListEmpty(const TimerWheel::Timer& head) {
+		return head.next == &head;
+	}
+
+	void linkBefore(TimerWheel::Timer& head, TimerWheel::Timer& timer) {
+		timer.prev = head.prev;
+		timer.next = &head;
+		head.prev->next = &timer;
+		head.prev = &timer;
+	}
+}
+
+TimerWheel::TimerWheel(std::uint64_t nowMs) : _currentTick(nowMs) {
+	for (auto& level : _slots) {
+		for (auto& head : level) {
+			initList(head);
+		}
+	}
+
+	initList(_expired);
+}
+
+void TimerWheel::schedule(Timer& timer, std::uint64_t expiryMs) {
+	cancel(timer);
+
+	timer.expiry = std::clamp(expiryMs, _currentTick + 1, _currentTick + MAX_TIMEOUT_MS);
+	_place(timer);
+	_size++;
+}
+
+void TimerWheel::cancel(Timer& timer) {
+	if (!timer.isArmed()) {
+		return;
+	}
+
+	timer.prev->next = timer.next;
+	timer.next->prev = timer.prev;
+	timer.prev = nullptr;
+	timer.next = nullptr;
+	_size--;
+
+	if (timer.slot != EXPIRED_SLOT && isListEmpty(_listOf(timer.slot))) {
+		_occupied[timer.slot / SLOTS] &= ~(std::uint64_t { 1 } << (timer.slot % SLOTS));
+	}
+}
+
+int TimerWheel::getTimeout(std::uint64_t nowMs) const {
+	const std::uint64_t nextTick = _nextEventTick();
+
+	if (nextTick == NEVER) {
+		return -1;
+	}
+
+	if (nextTick <= nowMs) {
+		return 0;
+	}
+
+	return static_cast<int>(std::min<std::uint64_t>(nextTick - nowMs, std::numeric_limits<int>::max()));
+}
+
+std::size_t TimerWheel::size() const {
+	return _size;
+}
+
+TimerWheel::Timer& TimerWheel::_listOf(std::uint16_t slot) {
+	return _slots[slot / SLOTS][slot % SLOTS];
+}
+
+// The level is the smallest one whose span still reaches the expiry; a
+// delta of 0 is only seen while cascading and lands in the slot about to
+// be expired.
+void TimerWheel::_place(Timer& timer) {
+	const std::uint64_t delta = timer.expiry - _currentTick;
+	std::size_t level = 0;
+
+	while (level < LEVELS - 1 && (delta >> ((level + 1) * SLOT_BITS)) != 0) {
+		level++;
+	}
+
+	const std::size_t index = (timer.expiry >> (level * SLOT_BITS)) & SLOT_MASK;
+
+	timer.slot = static_cast<std::uint16_t>(level * SLOTS + index);
+	linkBefore(_slots[level][index], timer);
+	_occupied[level] |= std::uint64_t { 1 } << index;
+}
+
+void TimerWheel::_cascade(std::size_t level, std::size_t index) {
+	Timer& head = _slots[level][index];
+
+	while (!isListEmpty(head)) {
+		Timer& timer = *head.next;
+
+		timer.prev->next = timer.next;
+		timer.next->prev = timer.prev;
+		_place(timer);
+	}
+
+	_occupied[level] &= ~(std::uint64_t { 1 } << index);
+}
+
+void TimerWheel::_step() {
+	_currentTick++;
+
+	for (std::size_t level = 1; level < LEVELS; level++) {
+		const std::size_t shift = level * SLOT_BITS;
+
+		if ((_currentTick & ((std::uint64_t { 1 } << shift) - 1)) != 0) {
+			break;
+		}
+
+		_cascade(level, (_currentTick >> shift) & SLOT_MASK);
+	}
+
+	const std::size_t index = _currentTick & SLOT_MASK;
+	Timer& head = _slots[0][index];
+
+	while (!isListEmpty(head)) {
+		Timer& timer = *head.next;
+
+		timer.prev->next = timer.next;
+		timer.next->prev = timer.prev;
+		timer.slot = EXPIRED_SLOT;
+		linkBefore(_expired, timer);
+	}
+
+	_occupied[0] &= ~(std::uint64_t { 1 } << index);
+}
+
+// Earliest tick at which a non-empty slot is either expired (level 0) or
+// cascaded (upper levels). Slot `i` of a level is processed at the next tick
+// whose bits for that level equal `i` and whose lower bits are all zero.
+std::uint64_t TimerWheel::_nextEventTick() const {
+	std::uint64_t nextTick = NEVER;
+
+	for (std::size_t level = 0; level < LEVELS; level++) {
+		if (_occupied[level] == 0) {
+			continue;
+		}
+
+		const std::size_t shift = level * SLOT_BITS;
+		const std::uint64_t position = _currentTick >> shift;
+		const int rotation = static_cast<int>((position + 1) & SLOT_MASK);
+		const std::uint64_t distance = std::countr_zero(std::rotr(_occupied[level], rotation)) + 1;
+
+		nextTick = std::min(nextTick, (position + distance) << shift);
+	}
+
+	return nextTick;
+}
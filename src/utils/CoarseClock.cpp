@@ -0,0 +1,137 @@
+#include <string_view>
+#include "utils/CoarseClock.hpp"
+
+namespace {
+	constexpr std::string_view DAY_NAMES = "SunMonTueWedThuFriSat";
+	constexpr std::string_view MONTH_NAMES = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+	char* put(char* out, std::string_view text) {
+		for (char c : text) {
+			*out++ = c;
+		}
+
+		return out;
+	}
+
+	// The index of the three letters of `name` in `names`, or -1
+	int indexOf(std::string_view names, std::string_view name) {
+		for (std::size_t i = 0; i + 3 <= names.size(); i += 3) {
+			if (names.substr(i, 3) == name) {
+				return static_cast<int>(i / 3);
+			}
+		}
+
+		return -1;
+	}
+
+	bool readDigits(std::string_view text, int& value) {
+		value = 0;
+
+		for (char c : text) {
+			if (c < '0' || c > '9') {
+				return false;
+			}
+
+			value = value * 10 + (c - '0');
+		}
+
+		return true;
+	}
+
+	char* putDigits(char* out, int value, int width) {
+		for (int i = width - 1; i >= 0; i--) {
+			out[i] = static_cast<char>('0' + value % 10);
+			value /= 10;
+		}
+
+		return out + width;
+	}
+}
+
+namespace utils {
+	CoarseClock::CoarseClock() {
+		update();
+	}
+
+	CoarseClock& CoarseClock::local() {
+		thread_local CoarseClock clock;
+		return clock;
+	}
+
+	// Spelled out rather than by strftime(), whose names follow the locale
+	CoarseClock::HttpDate CoarseClock::formatHttpDate(std::time_t time) {
+		HttpDate date;
+		std::tm tm {};
+		char* out = date.data();
+
+		gmtime_r(&time, &tm);
+		out = put(out, DAY_NAMES.substr(tm.tm_wday * 3, 3));
+		out = put(out, ", ");
+		out = putDigits(out, tm.tm_mday, 2);
+		out = put(out, " ");
+		out = put(out, MONTH_NAMES.substr(tm.tm_mon * 3, 3));
+		out = put(out, " ");
+		out = putDigits(out, tm.tm_year + 1900, 4);
+		out = put(out, " ");
+		out = putDigits(out, tm.tm_hour, 2);
+		out = put(out, ":");
+		out = putDigits(out, tm.tm_min, 2);
+		out = put(out, ":");
+		out = putDigits(out, tm.tm_sec, 2);
+		put(out, " GMT");
+		return date;
+	}
+
+	// Only the IMF-fixdate senders must use; a date in one of the obsolete
+	// formats is taken as no date, which costs a full response at worst.
+	std::optional<std::time_t> CoarseClock::parseHttpDate(std::string_view date) {
+		std::tm tm {};
+
+		if (date.size() != HttpDate().size()
+			|| date.substr(3, 2) != ", " || date[7] != ' ' || date[11] != ' ' || date[16] != ' '
+			|| date[19] != ':' || date[22] != ':' || date.substr(25) != " GMT"
+			|| indexOf(DAY_NAMES, date.substr(0, 3)) < 0
+			|| (tm.tm_mon = indexOf(MONTH_NAMES, date.substr(8, 3))) < 0
+			|| !readDigits(date.substr(5, 2), tm.tm_mday)
+			|| !readDigits(date.substr(12, 4), tm.tm_year)
+			|| !readDigits(date.substr(17, 2), tm.tm_hour)
+			|| !readDigits(date.substr(20, 2), tm.tm_min)
+			|| !readDigits(date.substr(23, 2), tm.tm_sec)) {
+			return std::nullopt;
+		}
+
+		if (tm.tm_mday < 1 || tm.tm_mday > 31 || tm.tm_hour > 23 || tm.tm_min > 59 || tm.tm_sec > 60) {
+			return std::nullopt;
+		}
+
+		tm.tm_year -= 1900;
+		return timegm(&tm);
+	}
+
+	void CoarseClock::update() {
+		const std::time_t dateTime = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+
+		_now = Clock::now();
+
+		if (dateTime != _dateTime) {
+			_dateTime = dateTime;
+			_date = formatHttpDate(dateTime);
+		}
+	}
+
+	CoarseClock::Clock::time_point CoarseClock::now() const {
+		return _now;
+	}
+
+	std::uint64_t CoarseClock::nowMs() const {
+		return std::chrono::duration_cast<std::chrono::milliseconds>(_now.time_since_epoch()).count();
+	}
+
+	std::time_t CoarseClock::wallTime() const {
+		return _dateTime;
+	}
+
+	std::string_view CoarseClock::httpDate() const {
+		return std::string_view(_date.data(), _date.size());
+	}
+}
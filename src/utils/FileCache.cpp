@@ -0,0 +1,196 @@
+#include <cerrno>
+#include <charconv>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "utils/CoarseClock.hpp"
+#include "utils/FileCache.hpp"
+#include "http/utils.hpp"
+#include "Error.hpp"
+
+namespace {
+	bool isSameFile(const utils::CachedFile& file, const struct stat& fileStat) {
+		return file.device == fileStat.st_dev
+			&& file.inode == fileStat.st_ino
+			&& file.size == static_cast<std::size_t>(fileStat.st_size)
+			&& file.mtime.tv_sec == fileStat.st_mtim.tv_sec
+			&& file.mtime.tv_nsec == fileStat.st_mtim.tv_nsec;
+	}
+
+	void appendHex(std::string& out, std::uint64_t value) {
+		char digits[16];
+		const auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), value, 16);
+
+		out.append(digits, end - digits);
+	}
+
+	// From what FileCache compares to tell a changed file (RFC 9110, 8.8.3)
+	std::string entityTagOf(const utils::CachedFile& file) {
+		std::string tag("W/\"");
+
+		appendHex(tag, file.inode);
+		tag += '-';
+		appendHex(tag, file.size);
+		tag += '-';
+		appendHex(tag, static_cast<std::uint64_t>(file.mtime.tv_sec) * 1000000000 + file.mtime.tv_nsec);
+		tag += '"';
+		return tag;
+	}
+
+	int openFile(const std::filesystem::path& path) {
+		return ::open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+	}
+
+	// Opened first and described from the fd, so the metadata is that of
+	// the file actually being sent even if the path is replaced in between.
+	std::shared_ptr<const utils::CachedFile> load(const std::filesystem::path& path, int fd) {
+		auto file = std::make_shared<utils::CachedFile>();
+		struct stat fileStat;
+
+		file->path = path;
+		file->fd = fd;
+
+		if (file->fd < 0) {
+			if (errno == ENOENT || errno == ENOTDIR) {
+				return nullptr;
+			}
+
+			throw std::ios_base::failure("Failed to open " + path.string());
+		}
+
+		if (::fstat(file->fd, &fileStat) < 0) {
+			throw std::ios_base::failure("Failed to stat " + path.string());
+		}
+
+		if (S_ISDIR(fileStat.st_mode)) {
+			::close(file->fd);
+			file->fd = -1;
+			file->type = utils::CachedFile::Type::DIRECTORY;
+		} else if (!S_ISREG(fileStat.st_mode)) {
+			throw std::ios_base::failure("Not a regular file: " + path.string());
+		}
+
+		file->size = static_cast<std::size_t>(fileStat.st_size);
+		file->mtime = fileStat.st_mtim;
+		file->device = fileStat.st_dev;
+		file->inode = fileStat.st_ino;
+		file->mimeType = http::getMimeType(path.extension().string().erase(0, 1));
+		file->contentLength = std::to_string(file->size);
+		file->entityTag = entityTagOf(*file);
+
+		const utils::CoarseClock::HttpDate lastModified = utils::CoarseClock::formatHttpDate(file->mtime.tv_sec);
+
+		file->lastModified.assign(lastModified.data(), lastModified.size());
+		return file;
+	}
+}
+
+namespace utils {
+	CachedFile::~CachedFile() {
+		if (fd != -1) {
+			::close(fd);
+		}
+	}
+
+	bool CachedFile::isDirectory() const {
+		return type == Type::DIRECTORY;
+	}
+
+	FileCache& FileCache::local() {
+		thread_local FileCache cache;
+		return cache;
+	}
+
+	void FileCache::configure(std::size_t capacity, std::size_t validityMs) {
+		_capacity = capacity;
+		_validity = std::chrono::milliseconds(validityMs);
+
+		while (_lru.size() > _capacity) {
+			_erase(std::prev(_lru.end()));
+		}
+	}
+
+	std::shared_ptr<const CachedFile> FileCache::find(const std::filesystem::path& path) {
+		const std::string& key = path.native();
+		const Clock::time_point now = CoarseClock::local().now();
+		auto it = _entryByPath.find(key);
+
+		if (it != _entryByPath.end()) {
+			Entry& entry = it->second->second;
+
+			_lru.splice(_lru.begin(), _lru, it->second);
+
+			if (now - entry.validatedAt < _validity) {
+				return entry.file;
+			}
+
+			struct stat fileStat;
+
+			if (::stat(key.c_str(), &fileStat) == 0 && isSameFile(*entry.file, fileStat)) {
+				entry.validatedAt = now;
+				return entry.file;
+			}
+
+			_erase(it->second);
+		}
+
+		std::shared_ptr<const CachedFile> file = load(path, _open(path));
+
+		if (file != nullptr) {
+			_insert(key, file, now);
+		}
+
+		return file;
+	}
+
+	std::shared_ptr<const CachedFile> FileCache::open(const std::filesystem::path& path) {
+		std::shared_ptr<const CachedFile> file = find(path);
+
+		if (file == nullptr) {
+			throw FileNotFoundException(path.filename());
+		}
+
+		return file;
+	}
+
+	void FileCache::clear() {
+		_entryByPath.clear();
+		_lru.clear();
+	}
+
+	std::size_t FileCache::size() const {
+		return _lru.size();
+	}
+
+	// Out of fds, of which the cache likely holds the most: it gives back
+	// the least recently used files until the open gets one. Those still
+	// being sent keep theirs, so it may run empty without success.
+	int FileCache::_open(const std::filesystem::path& path) {
+		int fd = openFile(path);
+
+		while (fd < 0 && (errno == EMFILE || errno == ENFILE) && !_lru.empty()) {
+			_erase(std::prev(_lru.end()));
+			fd = openFile(path);
+		}
+
+		return fd;
+	}
+
+	void FileCache::_insert(const std::string& key, std::shared_ptr<const CachedFile> file, Clock::time_point now) {
+		if (_capacity == 0) {
+			return;
+		}
+
+		if (_lru.size() >= _capacity) {
+			_erase(std::prev(_lru.end()));
+		}
+
+		_lru.emplace_front(key, Entry { std::move(file), now });
+		_entryByPath[key] = _lru.begin();
+	}
+
+	void FileCache::_erase(LruList::iterator it) {
+		_entryByPath.erase(it->first);
+		_lru.erase(it);
+	}
+}
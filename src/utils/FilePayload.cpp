@@ -1,91 +1,100 @@
-#include <array>
-#include <iterator>
+#include <cerrno>
+#include <vector>
+#include <unistd.h>
 #include <sys/socket.h>
+#ifdef __linux__
+# include <sys/sendfile.h>
+#endif
 #include "utils/Payload.hpp"
 #include "Error.hpp"
 
 namespace utils {
 	FilePayload::FilePayload(int socket, const std::filesystem::path &filePath)
+		: FilePayload(socket, FileCache::local().open(filePath)) {
+	}
+
+	FilePayload::FilePayload(int socket, std::shared_ptr<const CachedFile> file)
 		: Payload(socket),
-		_filePath(filePath)
+		_file(std::move(file))
 	{
-		if (!std::filesystem::exists(filePath)) {
-			throw FileNotFoundException(_filePath.filename());
+		if (_file->isDirectory()) {
+			throw std::ios_base::failure("Not a regular file: " + _file->path.string());
 		}
 
-		_totalBytes = std::filesystem::file_size(filePath);
-		_ifstream.open(filePath, std::ios::binary);
-
-		if (!_ifstream.is_open()) {
-			throw std::ios_base::failure("Failed to open " + filePath.string());
-		}
+		_totalBytes = _file->size;
 	}
 
-	FilePayload::FilePayload(const FilePayload& other) : Payload(other), _filePath(other._filePath) {
-		_ifstream.open(_filePath, std::ios::binary);
+	// Keeps sending until the file is done or the socket would block, so a
+	// single POLLOUT moves as much as the socket buffer can take.
+	void FilePayload::send() {
+		while (Payload::_bytesSent < _totalBytes) {
+			const bool hasProgress = _isSendfileEnabled ? _sendWithSendfile() : _sendWithBuffer();
 
-		if (!_ifstream.is_open()) {
-			throw std::ios_base::failure("Failed to open " + _filePath.string());
+			if (!hasProgress) {
+				break;
+			}
 		}
 	}
 
-	FilePayload& FilePayload::operator=(const FilePayload& other) {
-		if (this != &other) {
-			Payload::operator=(other);
-			_filePath = other._filePath;
+	void FilePayload::append(const std::uint8_t* data, size_t size) {
+		(void)data;
+		(void)size;
+		throw std::runtime_error("The append() method is not supported in FilePayload");
+	}
 
-			_ifstream.open(_filePath, std::ios::binary);
+	std::string FilePayload::toString() const {
+		std::string content(_totalBytes, '\0');
+		const ssize_t bytesRead = ::pread(_file->fd, content.data(), content.size(), 0);
 
-			if (!_ifstream.is_open()) {
-				throw std::ios_base::failure("Failed to open " + _filePath.string());
-			}
-		}
+		content.resize(bytesRead > 0 ? static_cast<std::size_t>(bytesRead) : 0);
+		return content;
+	}
 
-		return *this;
+	const CachedFile& FilePayload::getFile() const {
+		return *_file;
 	}
 
-	void FilePayload::send() {
-		if (Payload::_bytesSent >= _totalBytes) {
-			return;
-		}
+	// Returns false once the socket would block or fails. A client gone
+	// away fails it with EPIPE, as main() ignores SIGPIPE, and the socket
+	// then reports POLLHUP/POLLERR on the next poll.
+	bool FilePayload::_sendWithSendfile() {
+#ifdef __linux__
+		off_t offset = static_cast<off_t>(Payload::_bytesSent);
+		const ssize_t bytesSent = ::sendfile(_socket, _file->fd, &offset, _totalBytes - Payload::_bytesSent);
 
-		std::array<char, 1024> buffer;
-		_ifstream.seekg(Payload::_bytesSent, std::ios::beg);
-		const auto bytesRead = _ifstream
-								.read(buffer.data(), buffer.size())
-								.gcount();
+		if (bytesSent > 0) {
+			Payload::_bytesSent += static_cast<std::size_t>(bytesSent);
+			return true;
+		}
 
-		if (_ifstream.bad() || (_ifstream.fail() && !_ifstream.eof())) {
-			_ifstream.close();
-			throw std::ios_base::failure("Failed to read " + _filePath.string());
+		if (bytesSent == 0) {
+			throw std::ios_base::failure("File truncated while sending " + _file->path.string());
 		}
 
-		const ssize_t bytesSent = ::send(_socket, buffer.data(), bytesRead, MSG_NOSIGNAL);
+		if (errno != EINVAL && errno != ENOSYS) {
+			return false;
+		}
+#endif
+		_isSendfileEnabled = false;
+		return _sendWithBuffer();
+	}
 
-		if (bytesSent >= 0) {
-			Payload::_bytesSent += static_cast<std::size_t>(bytesSent);
+	bool FilePayload::_sendWithBuffer() {
+		thread_local std::vector<char> buffer(FALLBACK_BUFFER_SIZE);
+		const std::size_t length = std::min(buffer.size(), _totalBytes - Payload::_bytesSent);
+		const ssize_t bytesRead = ::pread(_file->fd, buffer.data(), length, static_cast<off_t>(Payload::_bytesSent));
 
-			if (Payload::_bytesSent >= _totalBytes) {
-				_ifstream.close();
-			}
+		if (bytesRead <= 0) {
+			throw std::ios_base::failure("Failed to read " + _file->path.string());
 		}
-	}
 
-	void FilePayload::append(const std::uint8_t* data, size_t size) {
-		(void)data;
-		(void)size;
-		throw std::runtime_error("The append() method is not supported in FilePayload");
-	}
+		const ssize_t bytesSent = ::send(_socket, buffer.data(), bytesRead, MSG_NOSIGNAL);
 
-	std::string FilePayload::toString() const {
-		_ifstream.seekg(0, std::ios::beg);
-		return std::string(
-			std::istreambuf_iterator<char>(_ifstream),
-			std::istreambuf_iterator<char>()
-		);
-	}
+		if (bytesSent <= 0) {
+			return false;
+		}
 
-	std::unique_ptr<Payload> FilePayload::clone() const {
-		return std::make_unique<FilePayload>(*this);
+		Payload::_bytesSent += static_cast<std::size_t>(bytesSent);
+		return bytesSent == bytesRead;
 	}
 }
@@ -1,13 +1,38 @@
+#include <algorithm>
 #include "utils/Payload.hpp"
 
 namespace utils {
 	Payload::Payload(int socket) : _socket(socket) {}
 
+	bool Payload::gather(std::vector<iovec>& iovecs) const {
+		(void)iovecs;
+		return false;
+	}
+
+	std::size_t Payload::consume(std::size_t bytes) {
+		const std::size_t used = std::min(bytes, _totalBytes - _bytesSent);
+
+		_bytesSent += used;
+		return used;
+	}
+
 	bool Payload::isSent() const {
 		return (_bytesSent >= _totalBytes);
 	}
 
+	bool Payload::isComplete() const {
+		return true;
+	}
+
+	bool Payload::hasPendingBytes() const {
+		return (_bytesSent < _totalBytes);
+	}
+
 	std::size_t Payload::getSizeInBytes() const {
 		return _totalBytes;
 	}
+
+	void Payload::setSocket(int socket) {
+		_socket = socket;
+	}
 }
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <string.h>
+#include "utils/ReceiveBuffer.hpp"
+
+namespace utils {
+	ReceiveBuffer::ReceiveBuffer(std::size_t capacity)
+		: _pool(&SlabPool::of(capacity))
+		, _capacity(capacity) {
+	}
+
+	ReceiveBuffer::ReceiveBuffer(ReceiveBuffer&& other) noexcept
+		: _pool(other._pool)
+		, _slab(std::move(other._slab))
+		, _capacity(other._capacity)
+		, _begin(other._begin)
+		, _end(other._end) {
+		other.clear();
+	}
+
+	ReceiveBuffer::~ReceiveBuffer() {
+		_pool->release(std::move(_slab));
+	}
+
+	ReceiveBuffer& ReceiveBuffer::operator=(ReceiveBuffer&& other) noexcept {
+		if (this != &other) {
+			_pool->release(std::move(_slab));
+			_pool = other._pool;
+			_slab = std::move(other._slab);
+			_capacity = other._capacity;
+			_begin = other._begin;
+			_end = other._end;
+			other.clear();
+		}
+
+		return *this;
+	}
+
+	const std::uint8_t* ReceiveBuffer::data() const {
+		return _slab.get() + _begin;
+	}
+
+	std::size_t ReceiveBuffer::size() const {
+		return _end - _begin;
+	}
+
+	bool ReceiveBuffer::empty() const {
+		return _begin == _end;
+	}
+
+	bool ReceiveBuffer::isFull() const {
+		return size() == _capacity;
+	}
+
+	// The bytes left are moved to the front once less than a quarter of the
+	// buffer is free at its end, which keeps each read reasonably large.
+	std::uint8_t* ReceiveBuffer::prepare() {
+		if (!_slab) {
+			_slab = _pool->acquire();
+		}
+
+		if (_begin > 0 && _capacity - _end < _capacity / 4) {
+			memmove(_slab.get(), _slab.get() + _begin, size());
+			_end -= _begin;
+			_begin = 0;
+		}
+
+		return _slab.get() + _end;
+	}
+
+	std::size_t ReceiveBuffer::available() const {
+		return _slab ? _capacity - _end : 0;
+	}
+
+	void ReceiveBuffer::commit(std::size_t size) {
+		_end += std::min(size, available());
+	}
+
+	std::size_t ReceiveBuffer::append(const std::uint8_t* data, std::size_t size) {
+		std::uint8_t* space = prepare();
+
+		size = std::min(size, available());
+		std::copy(data, data + size, space);
+		commit(size);
+
+		return size;
+	}
+
+	void ReceiveBuffer::consume(std::size_t size) {
+		_begin += std::min(size, this->size());
+
+		if (_begin == _end) {
+			clear();
+		}
+	}
+
+	void ReceiveBuffer::clear() {
+		_begin = 0;
+		_end = 0;
+	}
+
+	void ReceiveBuffer::release() {
+		if (empty()) {
+			_pool->release(std::move(_slab));
+		}
+	}
+
+	bool ReceiveBuffer::hasStorage() const {
+		return _slab != nullptr;
+	}
+}
@@ -0,0 +1,49 @@
+#include <sys/socket.h>
+#include "utils/Payload.hpp"
+
+namespace utils {
+	SharedPayload::SharedPayload(int socket, std::shared_ptr<const std::string> data)
+		: Payload(socket),
+		_data(std::move(data))
+	{
+		_totalBytes = _data->size();
+	}
+
+	void SharedPayload::send() {
+		if (Payload::_bytesSent >= _totalBytes) {
+			return;
+		}
+
+		const ssize_t bytesSent = ::send(
+			_socket,
+			_data->data() + Payload::_bytesSent,
+			_totalBytes - Payload::_bytesSent,
+			MSG_NOSIGNAL
+		);
+
+		if (bytesSent >= 0) {
+			Payload::_bytesSent += static_cast<std::size_t>(bytesSent);
+		}
+	}
+
+	void SharedPayload::append(const std::uint8_t* data, size_t size) {
+		(void)data;
+		(void)size;
+		throw std::runtime_error("The append() method is not supported in SharedPayload");
+	}
+
+	std::string SharedPayload::toString() const {
+		return *_data;
+	}
+
+	bool SharedPayload::gather(std::vector<iovec>& iovecs) const {
+		if (Payload::_bytesSent < _totalBytes) {
+			iovecs.push_back({
+				const_cast<char*>(_data->data()) + Payload::_bytesSent,
+				_totalBytes - Payload::_bytesSent
+			});
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,66 @@
+#include <map>
+#include "utils/SlabPool.hpp"
+
+namespace utils {
+	SlabPool& SlabPool::of(std::size_t slabSize) {
+		static std::mutex mutex;
+		static std::map<std::size_t, std::unique_ptr<SlabPool>> pools;
+		std::lock_guard<std::mutex> lock(mutex);
+		std::unique_ptr<SlabPool>& pool = pools[slabSize];
+
+		if (!pool) {
+			pool = std::make_unique<SlabPool>(slabSize);
+		}
+
+		return *pool;
+	}
+
+	SlabPool::SlabPool(std::size_t slabSize) : _slabSize(slabSize) {
+	}
+
+	// A new slab is left uninitialized, as only received bytes are read
+	SlabPool::Slab SlabPool::acquire() {
+		std::unique_lock<std::mutex> lock(_mutex);
+
+		_borrowed++;
+
+		if (_idle.empty()) {
+			lock.unlock();
+			return Slab(new std::uint8_t[_slabSize]);
+		}
+
+		Slab slab = std::move(_idle.back());
+
+		_idle.pop_back();
+		return slab;
+	}
+
+	// A slab past MAX_IDLE_SLABS is freed once the lock is released
+	void SlabPool::release(Slab slab) {
+		if (!slab) {
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		_borrowed--;
+
+		if (_idle.size() < MAX_IDLE_SLABS) {
+			_idle.push_back(std::move(slab));
+		}
+	}
+
+	std::size_t SlabPool::getSlabSize() const {
+		return _slabSize;
+	}
+
+	std::size_t SlabPool::getBorrowed() const {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _borrowed;
+	}
+
+	std::size_t SlabPool::getIdle() const {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _idle.size();
+	}
+}
@@ -0,0 +1,105 @@
+#include <cstdio>
+#include <sys/socket.h>
+#include "utils/Payload.hpp"
+
+namespace utils {
+	StreamPayload::StreamPayload(int socket, bool isChunked) : Payload(socket), _isChunked(isChunked) {}
+
+	void StreamPayload::send() {
+		if (!hasPendingBytes()) {
+			return;
+		}
+
+		const ssize_t bytesSent = ::send(
+			_socket,
+			_buffer.data() + (_bytesSent - _bufferOffset),
+			_totalBytes - _bytesSent,
+			MSG_NOSIGNAL
+		);
+
+		if (bytesSent > 0) {
+			consume(static_cast<std::size_t>(bytesSent));
+		}
+	}
+
+	void StreamPayload::append(const std::uint8_t* data, size_t size) {
+		if (size == 0 || _isFinished) {
+			return;
+		}
+
+		_compact();
+
+		if (_isChunked) {
+			char chunkSize[20];
+			const int length = std::snprintf(chunkSize, sizeof(chunkSize), "%zx\r\n", size);
+
+			_buffer.append(chunkSize, length);
+		}
+
+		_buffer.append(reinterpret_cast<const char*>(data), size);
+
+		if (_isChunked) {
+			_buffer.append("\r\n");
+		}
+
+		_totalBytes = _bufferOffset + _buffer.size();
+	}
+
+	std::string StreamPayload::toString() const {
+		return _buffer.substr(_bytesSent - _bufferOffset);
+	}
+
+	bool StreamPayload::gather(std::vector<iovec>& iovecs) const {
+		if (hasPendingBytes()) {
+			iovecs.push_back({
+				const_cast<char*>(_buffer.data()) + (_bytesSent - _bufferOffset),
+				_totalBytes - _bytesSent
+			});
+		}
+
+		return true;
+	}
+
+	bool StreamPayload::isSent() const {
+		return _isFinished && !hasPendingBytes();
+	}
+
+	bool StreamPayload::isComplete() const {
+		return _isFinished;
+	}
+
+	void StreamPayload::finish() {
+		if (_isFinished) {
+			return;
+		}
+
+		if (_isChunked) {
+			_compact();
+			_buffer.append("0\r\n\r\n");
+			_totalBytes = _bufferOffset + _buffer.size();
+		}
+
+		_isFinished = true;
+	}
+
+	void StreamPayload::abort() {
+		_isFinished = true;
+	}
+
+	std::size_t StreamPayload::getBufferedBytes() const {
+		return _totalBytes - _bytesSent;
+	}
+
+	// Drops what was sent once it is at least half the buffer, so appending
+	// stays amortized O(1) and a long stream does not keep its whole past.
+	void StreamPayload::_compact() {
+		const std::size_t sent = _bytesSent - _bufferOffset;
+
+		if (sent == 0 || sent * 2 < _buffer.size()) {
+			return;
+		}
+
+		_buffer.erase(0, sent);
+		_bufferOffset = _bytesSent;
+	}
+}
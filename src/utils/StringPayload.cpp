@@ -34,12 +34,20 @@ namespace utils {
 		return _message;
 	}
 
-	void StringPayload::setMessage(const std::string& message) {
-		_message = message;
+	void StringPayload::setMessage(std::string_view message) {
+		_message.assign(message);
 		_totalBytes = _message.size();
+		_bytesSent = 0;
 	}
 
-	std::unique_ptr<Payload> StringPayload::clone() const {
-		return std::make_unique<StringPayload>(*this);
+	bool StringPayload::gather(std::vector<iovec>& iovecs) const {
+		if (Payload::_bytesSent < _totalBytes) {
+			iovecs.push_back({
+				const_cast<char*>(_message.data()) + Payload::_bytesSent,
+				_totalBytes - Payload::_bytesSent
+			});
+		}
+
+		return true;
 	}
 }
@@ -12,6 +12,7 @@
 
 #include "Config.hpp"
 #include "Error.hpp"
+#include "TimerWheel.hpp"
 #include "http/Request.hpp"
 #include "http/Response.hpp"
 #include "utils/common.hpp"
@@ -58,6 +59,22 @@ namespace utils {
 		return port;
 	}
 
+	// Timeouts are given in milliseconds, e.g. `timeout_idle 30000;`
+	std::size_t parseTimeout(const string &value) {
+		if (value.empty() || value.size() > 9 || !std::all_of(value.begin(), value.end(), ::isdigit)) {
+			THROW_CONFIG_ERROR(EINVAL, "Invalid timeout");
+		}
+		std::size_t timeout = std::stoul(value);
+		if (timeout == 0) {
+			THROW_CONFIG_ERROR(ERANGE, "Timeout must be greater than 0");
+		}
+		// Deadlines further ahead would be quietly shortened by the timer wheel
+		if (timeout > TimerWheel::MAX_TIMEOUT_MS) {
+			THROW_CONFIG_ERROR(ERANGE, "Timeout must be at most " + std::to_string(TimerWheel::MAX_TIMEOUT_MS) + " ms");
+		}
+		return timeout;
+	}
+
 	void validateMethods(const vector<string> &methods) {
 		vector<string> validMethods = {"GET", "POST", "DELETE"};
 		for (const auto &method : methods) {
@@ -271,7 +288,7 @@ namespace utils {
 			<< "Request URL_query: " << request.getUrl().query << endl
 			<< "Request URL_fragment: " << request.getUrl().fragment << endl
 			<< "Request version: " << request.getVersion() << endl
-			<< "Request body size: " << request.getRawBody().size() << endl;
+			<< "Request body size: " << (request.getBody() ? request.getBody()->getReceived() : 0) << endl;
 	}
 
 	void printServerConfig(const ServerConfig& server) {
@@ -288,6 +305,7 @@ namespace utils {
 		}
 		cout << endl;
 		cout << "Client Max Body Size: " << server.clientMaxBodySize << endl;
+		cout << "Client Buffer Size: " << server.clientBufferSize << endl;
 
 		for (const auto& location : server.locations) {
 			cout
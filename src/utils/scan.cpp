@@ -0,0 +1,317 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include "utils/scan.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+# define WEBSERV_X86_SIMD
+# include <immintrin.h>
+#endif
+
+namespace {
+	using FindByte = const std::uint8_t* (*)(const std::uint8_t*, const std::uint8_t*, std::uint8_t);
+	using FindSequence = const std::uint8_t* (*)(const std::uint8_t*, const std::uint8_t*, std::string_view);
+	using FindNonToken = const std::uint8_t* (*)(const std::uint8_t*, const std::uint8_t*);
+
+	struct Kernels {
+		utils::SimdLevel level;
+		FindByte findByte;
+		FindSequence findSequence;
+		FindNonToken findNonToken;
+	};
+
+	constexpr bool isTokenChar(unsigned char c) {
+		return (c >= '0' && c <= '9')
+			|| (c >= 'a' && c <= 'z')
+			|| (c >= 'A' && c <= 'Z')
+			|| std::string_view("!#$%&'*+-.^_`|~").find(static_cast<char>(c)) != std::string_view::npos;
+	}
+
+	constexpr std::array<bool, 256> TOKEN_CHARS = [] {
+		std::array<bool, 256> table {};
+
+		for (int c = 0; c < 256; c++) {
+			table[c] = isTokenChar(static_cast<unsigned char>(c));
+		}
+
+		return table;
+	}();
+
+	// Nibble lookup tables for classifying 16/32 bytes at once with a byte
+	// shuffle: a byte is a token character when
+	// TOKEN_LOW_NIBBLE[c & 0xF] & TOKEN_HIGH_NIBBLE[c >> 4] is non-zero.
+	// Each bit of the low-nibble entry stands for one high nibble (0-7);
+	// bytes of 0x80 and above map to 0 and are never tokens.
+	constexpr std::array<std::uint8_t, 16> TOKEN_LOW_NIBBLE = [] {
+		std::array<std::uint8_t, 16> table {};
+
+		for (int low = 0; low < 16; low++) {
+			for (int high = 0; high < 8; high++) {
+				if (isTokenChar(static_cast<unsigned char>(high << 4 | low))) {
+					table[low] |= static_cast<std::uint8_t>(1 << high);
+				}
+			}
+		}
+
+		return table;
+	}();
+
+	constexpr std::array<std::uint8_t, 16> TOKEN_HIGH_NIBBLE = [] {
+		std::array<std::uint8_t, 16> table {};
+
+		for (int high = 0; high < 8; high++) {
+			table[high] = static_cast<std::uint8_t>(1 << high);
+		}
+
+		return table;
+	}();
+
+	// Scalar
+
+	const std::uint8_t* findByteScalar(const std::uint8_t* begin, const std::uint8_t* end, std::uint8_t byte) {
+		return std::find(begin, end, byte);
+	}
+
+	const std::uint8_t* findSequenceScalar(const std::uint8_t* begin, const std::uint8_t* end, std::string_view needle) {
+		if (needle.empty()) {
+			return begin;
+		}
+
+		const std::uint8_t first = static_cast<std::uint8_t>(needle.front());
+
+		for (auto* current = begin; end - current >= static_cast<std::ptrdiff_t>(needle.size()); current++) {
+			if (*current == first && std::memcmp(current, needle.data(), needle.size()) == 0) {
+				return current;
+			}
+		}
+
+		return end;
+	}
+
+	const std::uint8_t* findNonTokenScalar(const std::uint8_t* begin, const std::uint8_t* end) {
+		return std::find_if(begin, end, [](std::uint8_t c) { return !TOKEN_CHARS[c]; });
+	}
+
+	constexpr Kernels SCALAR_KERNELS {
+		utils::SimdLevel::SCALAR, findByteScalar, findSequenceScalar, findNonTokenScalar
+	};
+
+#ifdef WEBSERV_X86_SIMD
+	// SSE4.2
+
+	__attribute__((target("sse4.2")))
+	const std::uint8_t* findByteSse42(const std::uint8_t* begin, const std::uint8_t* end, std::uint8_t byte) {
+		const __m128i needle = _mm_set1_epi8(static_cast<char>(byte));
+
+		for (; end - begin >= 16; begin += 16) {
+			const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+			const unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+
+			if (mask != 0) {
+				return begin + std::countr_zero(mask);
+			}
+		}
+
+		return findByteScalar(begin, end, byte);
+	}
+
+	// Compares the first and last byte of the needle at 16 positions at once
+	// and only runs memcmp on the positions where both match.
+	__attribute__((target("sse4.2")))
+	const std::uint8_t* findSequenceSse42(const std::uint8_t* begin, const std::uint8_t* end, std::string_view needle) {
+		const std::size_t size = needle.size();
+
+		if (size < 2) {
+			return size == 0 ? begin : findByteSse42(begin, end, static_cast<std::uint8_t>(needle.front()));
+		}
+
+		const __m128i first = _mm_set1_epi8(needle.front());
+		const __m128i last = _mm_set1_epi8(needle.back());
+
+		for (; end - begin >= static_cast<std::ptrdiff_t>(size + 15); begin += 16) {
+			const __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+			const __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin + size - 1));
+			unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, last)));
+
+			while (mask != 0) {
+				const int offset = std::countr_zero(mask);
+
+				if (std::memcmp(begin + offset + 1, needle.data() + 1, size - 2) == 0) {
+					return begin + offset;
+				}
+
+				mask &= mask - 1;
+			}
+		}
+
+		return findSequenceScalar(begin, end, needle);
+	}
+
+	__attribute__((target("sse4.2")))
+	const std::uint8_t* findNonTokenSse42(const std::uint8_t* begin, const std::uint8_t* end) {
+		const __m128i lowTable = _mm_loadu_si128(reinterpret_cast<const __m128i*>(TOKEN_LOW_NIBBLE.data()));
+		const __m128i highTable = _mm_loadu_si128(reinterpret_cast<const __m128i*>(TOKEN_HIGH_NIBBLE.data()));
+		const __m128i nibbleMask = _mm_set1_epi8(0x0f);
+
+		for (; end - begin >= 16; begin += 16) {
+			const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+			const __m128i low = _mm_shuffle_epi8(lowTable, _mm_and_si128(chunk, nibbleMask));
+			const __m128i high = _mm_shuffle_epi8(highTable, _mm_and_si128(_mm_srli_epi16(chunk, 4), nibbleMask));
+			const __m128i isNonToken = _mm_cmpeq_epi8(_mm_and_si128(low, high), _mm_setzero_si128());
+			const unsigned mask = _mm_movemask_epi8(isNonToken);
+
+			if (mask != 0) {
+				return begin + std::countr_zero(mask);
+			}
+		}
+
+		return findNonTokenScalar(begin, end);
+	}
+
+	constexpr Kernels SSE42_KERNELS {
+		utils::SimdLevel::SSE42, findByteSse42, findSequenceSse42, findNonTokenSse42
+	};
+
+	// AVX2
+	//
+	// The tail shorter than a vector is left to the SSE4.2 kernel. The upper
+	// halves of the ymm registers are cleared first: GCC does not emit
+	// vzeroupper before a tail call, and legacy SSE code running with dirty
+	// upper state is several times slower.
+
+	__attribute__((target("avx2")))
+	const std::uint8_t* findByteAvx2(const std::uint8_t* begin, const std::uint8_t* end, std::uint8_t byte) {
+		const __m256i needle = _mm256_set1_epi8(static_cast<char>(byte));
+
+		for (; end - begin >= 32; begin += 32) {
+			const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+			const unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle));
+
+			if (mask != 0) {
+				return begin + std::countr_zero(mask);
+			}
+		}
+
+		_mm256_zeroupper();
+		return findByteSse42(begin, end, byte);
+	}
+
+	__attribute__((target("avx2")))
+	const std::uint8_t* findSequenceAvx2(const std::uint8_t* begin, const std::uint8_t* end, std::string_view needle) {
+		const std::size_t size = needle.size();
+
+		if (size < 2) {
+			return size == 0 ? begin : findByteAvx2(begin, end, static_cast<std::uint8_t>(needle.front()));
+		}
+
+		const __m256i first = _mm256_set1_epi8(needle.front());
+		const __m256i last = _mm256_set1_epi8(needle.back());
+
+		for (; end - begin >= static_cast<std::ptrdiff_t>(size + 31); begin += 32) {
+			const __m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+			const __m256i tail = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin + size - 1));
+			unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(head, first), _mm256_cmpeq_epi8(tail, last)));
+
+			while (mask != 0) {
+				const int offset = std::countr_zero(mask);
+
+				if (std::memcmp(begin + offset + 1, needle.data() + 1, size - 2) == 0) {
+					return begin + offset;
+				}
+
+				mask &= mask - 1;
+			}
+		}
+
+		_mm256_zeroupper();
+		return findSequenceSse42(begin, end, needle);
+	}
+
+	__attribute__((target("avx2")))
+	const std::uint8_t* findNonTokenAvx2(const std::uint8_t* begin, const std::uint8_t* end) {
+		const __m256i lowTable = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(TOKEN_LOW_NIBBLE.data())));
+		const __m256i highTable = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(TOKEN_HIGH_NIBBLE.data())));
+		const __m256i nibbleMask = _mm256_set1_epi8(0x0f);
+
+		for (; end - begin >= 32; begin += 32) {
+			const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+			const __m256i low = _mm256_shuffle_epi8(lowTable, _mm256_and_si256(chunk, nibbleMask));
+			const __m256i high = _mm256_shuffle_epi8(highTable, _mm256_and_si256(_mm256_srli_epi16(chunk, 4), nibbleMask));
+			const __m256i isNonToken = _mm256_cmpeq_epi8(_mm256_and_si256(low, high), _mm256_setzero_si256());
+			const unsigned mask = _mm256_movemask_epi8(isNonToken);
+
+			if (mask != 0) {
+				return begin + std::countr_zero(mask);
+			}
+		}
+
+		_mm256_zeroupper();
+		return findNonTokenSse42(begin, end);
+	}
+
+	constexpr Kernels AVX2_KERNELS {
+		utils::SimdLevel::AVX2, findByteAvx2, findSequenceAvx2, findNonTokenAvx2
+	};
+#endif
+
+	utils::SimdLevel detectSimdLevel() {
+#ifdef WEBSERV_X86_SIMD
+		__builtin_cpu_init();
+
+		if (__builtin_cpu_supports("avx2")) {
+			return utils::SimdLevel::AVX2;
+		}
+
+		if (__builtin_cpu_supports("sse4.2")) {
+			return utils::SimdLevel::SSE42;
+		}
+#endif
+		return utils::SimdLevel::SCALAR;
+	}
+
+	const Kernels& kernelsFor(utils::SimdLevel level) {
+		switch (level) {
+#ifdef WEBSERV_X86_SIMD
+			case utils::SimdLevel::AVX2:
+				return AVX2_KERNELS;
+			case utils::SimdLevel::SSE42:
+				return SSE42_KERNELS;
+#endif
+			default:
+				return SCALAR_KERNELS;
+		}
+	}
+
+	const Kernels*& activeKernels() {
+		static const Kernels* kernels = &kernelsFor(utils::getMaxSimdLevel());
+		return kernels;
+	}
+}
+
+namespace utils {
+	SimdLevel getSimdLevel() {
+		return activeKernels()->level;
+	}
+
+	SimdLevel getMaxSimdLevel() {
+		static const SimdLevel level = detectSimdLevel();
+		return level;
+	}
+
+	void setSimdLevel(SimdLevel level) {
+		activeKernels() = &kernelsFor(std::min(level, getMaxSimdLevel()));
+	}
+
+	const std::uint8_t* findByte(const std::uint8_t* begin, const std::uint8_t* end, std::uint8_t byte) {
+		return activeKernels()->findByte(begin, end, byte);
+	}
+
+	const std::uint8_t* findSequence(const std::uint8_t* begin, const std::uint8_t* end, std::string_view needle) {
+		return activeKernels()->findSequence(begin, end, needle);
+	}
+
+	const std::uint8_t* findNonToken(const std::uint8_t* begin, const std::uint8_t* end) {
+		return activeKernels()->findNonToken(begin, end);
+	}
+}
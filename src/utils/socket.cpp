@@ -20,13 +20,42 @@ namespace utils {
 		return true;
 	}
 
-	int createPassiveSocket(const char* host, int port, int backlog, bool isNonBlocking) {
-		int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+	ssize_t sendVector(int socket, const std::vector<iovec>& iovecs, bool isMore) {
+		msghdr message {};
+		int flags = MSG_NOSIGNAL;
+
+		message.msg_iov = const_cast<iovec*>(iovecs.data());
+		message.msg_iovlen = iovecs.size();
+#ifdef MSG_MORE
+		if (isMore) {
+			flags |= MSG_MORE;
+		}
+#else
+		(void)isMore;
+#endif
+		return ::sendmsg(socket, &message, flags);
+	}
+
+	int createPassiveSocket(const char* host, int port, int backlog, bool isNonBlocking, bool isReusePort) {
+		// Close-on-exec keeps server sockets out of CGI processes
+		int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
 
         if (fd == -1) {
 			throw std::runtime_error("Failed to create socket");
 		}
 
+		const int enable = 1;
+
+		if (::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable)) == -1) {
+			throw std::runtime_error("Failed to set SO_REUSEADDR");
+		}
+
+		// Lets several sockets bind the same address so the kernel can
+		// balance incoming connections between them
+		if (isReusePort && ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) == -1) {
+			throw std::runtime_error("Failed to set SO_REUSEPORT");
+		}
+
 		if (isNonBlocking && setNonBlocking(fd) == false) {
 			throw std::runtime_error("Failed to set non-blocking");
 		}
@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include <csignal>
+#include <fstream>
+#include <string>
+#include <poll.h>
+#include <sys/stat.h>
+#include "CgiProcess.hpp"
+#include "utils/FileCache.hpp"
+
+namespace {
+	class CgiProcessTest : public ::testing::Test {
+		protected:
+			std::filesystem::path _dir { std::filesystem::temp_directory_path() / "webserv_cgi" };
+			Location _location;
+			ServerConfig _serverConfig;
+
+			void SetUp() override {
+				std::filesystem::create_directories(_dir / "sub");
+				_location.path = "/cgi-bin/";
+				_location.root = _dir;
+				_location.cgiExtension = { ".sh", ".py" };
+				_location.cgiInterpreter[".sh"] = "/bin/sh";
+				utils::FileCache::local().clear();
+			}
+
+			void TearDown() override {
+				std::filesystem::remove_all(_dir);
+			}
+
+			void write(const std::string& name, const std::string& content) {
+				std::ofstream(_dir / name, std::ios::binary | std::ios::trunc) << content;
+			}
+
+			// Drives both pipes the way the event loop does, closing each one
+			// as soon as the process is done with it
+			void run(CgiProcess& process) {
+				while (!process.isDone()) {
+					pollfd fds[2] {
+						{ process.getInputFd(), process.getEvents(process.getInputFd()), 0 },
+						{ process.getOutputFd(), POLLIN, 0 }
+					};
+
+					ASSERT_GT(::poll(fds, 2, 5000), 0);
+
+					if (fds[0].revents) {
+						process.writeInput();
+					}
+
+					if (fds[1].revents) {
+						process.readOutput();
+					}
+
+					for (const pollfd& pollFd : fds) {
+						if (pollFd.fd >= 0 && !process.isPipeOpen(pollFd.fd)) {
+							process.closePipe(pollFd.fd);
+						}
+					}
+				}
+			}
+	};
+}
+
+TEST_F(CgiProcessTest, FindsScriptAndPathInfo) {
+	write("sub/run.sh", "");
+
+	auto script = findCgiScript(_location, "/cgi-bin/sub/run.sh/a/b");
+
+	ASSERT_TRUE(script.has_value());
+	EXPECT_EQ(script->path, _dir / "sub/run.sh");
+	EXPECT_EQ(script->interpreter, "/bin/sh");
+	EXPECT_EQ(script->name, "/cgi-bin/sub/run.sh");
+	EXPECT_EQ(script->pathInfo, "/a/b");
+
+	EXPECT_FALSE(findCgiScript(_location, "/cgi-bin/sub/missing.sh").has_value());
+	EXPECT_FALSE(findCgiScript(_location, "/cgi-bin/sub/").has_value());
+	EXPECT_FALSE(findCgiScript(_location, "/cgi-bin/").has_value());
+}
+
+TEST_F(CgiProcessTest, StreamsOutputOfScript) {
+	write("echo.sh",
+		"printf 'Status: 201 Created\\r\\nX-Method: %s\\r\\n\\r\\n' \"$REQUEST_METHOD\"\n"
+		"cat\n"
+	);
+
+	auto script = findCgiScript(_location, "/cgi-bin/echo.sh");
+	const std::vector<std::uint8_t> body(200000, 'b');
+	http::Request request;
+	http::Response response(-1);
+
+	request.setMethod("POST");
+	request.setBody(std::make_shared<http::RequestBody>(body.size()));
+	request.getBody()->append(body.data(), body.size() / 2);
+
+	// The rest of the body arrives once the script runs
+	ASSERT_TRUE(script.has_value());
+	CgiProcess process(*script, _serverConfig, request, response);
+	request.getBody()->append(body.data() + body.size() / 2, body.size() - body.size() / 2);
+	request.getBody()->complete();
+	run(process);
+
+	EXPECT_EQ(response.getStatus(), http::Response::Status::READY);
+	EXPECT_EQ(response.getStatusCode(), http::StatusCode::CREATED_201);
+	EXPECT_NE(response.getHeader().toString().find("X-Method: POST\r\n"), std::string::npos);
+	EXPECT_NE(response.getHeader().toString().find("Transfer-Encoding: chunked\r\n"), std::string::npos);
+	ASSERT_NE(response.getBody(), nullptr);
+	EXPECT_TRUE(response.getBody()->isComplete());
+
+	// De-chunk what the client would receive
+	std::string content;
+	std::string chunked = response.getBody()->toString();
+
+	for (std::size_t pos = 0; pos < chunked.size();) {
+		const std::size_t size = std::stoul(chunked.substr(pos), nullptr, 16);
+
+		pos = chunked.find("\r\n", pos) + 2;
+		content += chunked.substr(pos, size);
+		pos += size + 2;
+	}
+
+	EXPECT_EQ(content, std::string(body.begin(), body.end()));
+
+	while (!process.reap()) {}
+}
+
+// More body than a pipe holds, to a script that closes its stdin unread
+TEST_F(CgiProcessTest, DropsBodyScriptDoesNotRead) {
+	write("ignore.sh", "exec 0<&-\nsleep 0.2\nprintf 'Status: 200 OK\\r\\n\\r\\n'\n");
+
+	auto script = findCgiScript(_location, "/cgi-bin/ignore.sh");
+	const std::vector<std::uint8_t> body(1024 * 1024, 'b');
+	http::Request request;
+	http::Response response(-1);
+
+	// As main() does, so the write fails with EPIPE instead
+	std::signal(SIGPIPE, SIG_IGN);
+	request.setMethod("POST");
+	request.setBody(std::make_shared<http::RequestBody>(body.size()));
+	request.getBody()->append(body.data(), body.size());
+	request.getBody()->complete();
+
+	ASSERT_TRUE(script.has_value());
+	CgiProcess process(*script, _serverConfig, request, response);
+	run(process);
+
+	EXPECT_EQ(response.getStatusCode(), http::StatusCode::OK_200);
+	EXPECT_FALSE(process.isPipeOpen(process.getInputFd()));
+
+	while (!process.reap()) {}
+}
+
+TEST_F(CgiProcessTest, FailsWithoutHeader) {
+	write("broken.sh", "exit 1\n");
+
+	auto script = findCgiScript(_location, "/cgi-bin/broken.sh");
+	http::Request request;
+	http::Response response(-1);
+
+	request.setMethod("GET");
+
+	ASSERT_TRUE(script.has_value());
+	CgiProcess process(*script, _serverConfig, request, response);
+	run(process);
+
+	EXPECT_EQ(response.getStatus(), http::Response::Status::READY);
+	EXPECT_EQ(response.getStatusCode(), http::StatusCode::BAD_GATEWAY_502);
+}
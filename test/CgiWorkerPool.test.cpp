@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include <fstream>
+#include <string>
+#include <poll.h>
+#include <unistd.h>
+#include "CgiWorkerPool.hpp"
+
+namespace {
+	class CgiWorkerPoolTest : public ::testing::Test {
+		protected:
+			std::filesystem::path _dir { std::filesystem::temp_directory_path() / "webserv_cgi_worker" };
+			Location _location;
+			std::map<int, std::string> _errorPages;
+			std::unordered_map<int, std::shared_ptr<Upstream>> _upstreamByFd;
+			std::vector<std::shared_ptr<Process>> _processes;
+			std::vector<int> _clientFds;
+
+			void SetUp() override {
+				std::filesystem::create_directories(_dir);
+				std::ofstream(_dir / "echo.py") << "import os, sys\nprint('Content-Type: text/plain\\n')\nprint(os.getpid(), sys.stdin.read())\n";
+				_location.cgiWorker[".py"] = std::filesystem::absolute("config/cgi_worker.py");
+				_location.cgiInterpreter[".py"] = "/usr/bin/python3";
+				_location.cgiWorkersMin = 1;
+				_location.cgiWorkersMax = 1;
+				_location.cgiWorkerRequests = 2;
+				_location.cgiQueueSize = 1;
+			}
+
+			void TearDown() override {
+				std::filesystem::remove_all(_dir);
+			}
+
+			fastcgi::NameValues params() {
+				return { { "REQUEST_METHOD", "POST" }, { "SCRIPT_FILENAME", (_dir / "echo.py").string() } };
+			}
+
+			// One round of the event loop for the workers
+			void poll(CgiWorkerPool& pool) {
+				std::vector<pollfd> pollFds;
+
+				for (auto& [fd, upstream] : _upstreamByFd) {
+					pollFds.push_back({ fd, upstream->getEvents(fd), 0 });
+				}
+
+				ASSERT_GT(::poll(pollFds.data(), pollFds.size(), 5000), 0);
+
+				for (const pollfd& pollFd : pollFds) {
+					if (pollFd.revents) {
+						_upstreamByFd.at(pollFd.fd)->process(pollFd.fd, pollFd.revents, _clientFds);
+					}
+				}
+
+				std::erase_if(_upstreamByFd, [](auto& entry) {
+					if (!entry.second->isPipeOpen(entry.first)) {
+						entry.second->closePipe(entry.first);
+						return true;
+					}
+					return false;
+				});
+
+				pool.dispatch(_clientFds);
+			}
+	};
+}
+
+TEST_F(CgiWorkerPoolTest, QueuesRejectsAndRecycles) {
+	CgiWorkerPool pool(_location, ".py", _upstreamByFd, _processes);
+
+	ASSERT_EQ(_processes.size(), 1u);
+
+	const pid_t firstPid = _processes[0]->getPid();
+	http::Response responses[4] { http::Response(100), http::Response(101), http::Response(102), http::Response(103) };
+
+	for (auto& response : responses) {
+		auto input = std::make_shared<http::RequestBody>(2);
+
+		input->append(reinterpret_cast<const std::uint8_t*>("hi"), 2);
+		input->complete();
+		pool.submit(params(), input, CgiOutput(response, _errorPages));
+	}
+
+	// One running, one waiting, the others turned away
+	EXPECT_EQ(responses[2].getStatusCode(), http::StatusCode::SERVICE_UNAVAILABLE_503);
+	EXPECT_NE(responses[3].getHeader().toString().find("Retry-After: 1\r\n"), std::string::npos);
+
+	const auto isAnswered = [](const http::Response& response) {
+		return response.getStatus() == http::Response::Status::READY && response.isComplete();
+	};
+
+	while (!isAnswered(responses[0]) || !isAnswered(responses[1])) {
+		poll(pool);
+	}
+
+	const std::string first = responses[0].getBody()->toString();
+	const std::string second = responses[1].getBody()->toString();
+
+	EXPECT_NE(first.find(std::to_string(firstPid) + " hi"), std::string::npos);
+	EXPECT_NE(second.find(std::to_string(firstPid) + " hi"), std::string::npos);
+
+	// Worn out after two requests, the worker is replaced
+	while (_processes.size() < 2) {
+		poll(pool);
+	}
+
+	EXPECT_NE(_processes.back()->getPid(), firstPid);
+
+	while (!_processes.front()->isDone()) {
+		poll(pool);
+	}
+
+	// It exits once its socket is closed
+	while (!_processes.front()->reap()) {
+		::usleep(1000);
+	}
+}
@@ -0,0 +1,40 @@
+#include <gtest/gtest.h>
+#include <string_view>
+#include "utils/CoarseClock.hpp"
+
+namespace {
+	std::string_view viewOf(const utils::CoarseClock::HttpDate& date) {
+		return std::string_view(date.data(), date.size());
+	}
+}
+
+TEST(CoarseClockTest, FormatsHttpDates) {
+	EXPECT_EQ(viewOf(utils::CoarseClock::formatHttpDate(0)), "Thu, 01 Jan 1970 00:00:00 GMT");
+	EXPECT_EQ(viewOf(utils::CoarseClock::formatHttpDate(784111777)), "Sun, 06 Nov 1994 08:49:37 GMT");
+	EXPECT_EQ(viewOf(utils::CoarseClock::formatHttpDate(1709251199)), "Thu, 29 Feb 2024 23:59:59 GMT");
+}
+
+// The time only moves when the clock is updated
+TEST(CoarseClockTest, KeepsTimeUntilUpdated) {
+	utils::CoarseClock clock;
+	const auto before = clock.now();
+
+	while (std::chrono::steady_clock::now() == before) {
+	}
+
+	EXPECT_EQ(clock.now(), before);
+	clock.update();
+	EXPECT_GT(clock.now(), before);
+	EXPECT_EQ(clock.httpDate().size(), 29u);
+	EXPECT_TRUE(clock.httpDate().ends_with(" GMT"));
+}
+
+TEST(CoarseClockTest, ParsesHttpDates) {
+	EXPECT_EQ(utils::CoarseClock::parseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT"), 784111777);
+	EXPECT_EQ(utils::CoarseClock::parseHttpDate("Thu, 01 Jan 1970 00:00:00 GMT"), 0);
+	EXPECT_EQ(utils::CoarseClock::parseHttpDate("Sunday, 06-Nov-94 08:49:37 GMT"), std::nullopt);
+	EXPECT_EQ(utils::CoarseClock::parseHttpDate("Sun Nov  6 08:49:37 1994"), std::nullopt);
+	EXPECT_EQ(utils::CoarseClock::parseHttpDate("Sun, 06 Nox 1994 08:49:37 GMT"), std::nullopt);
+	EXPECT_EQ(utils::CoarseClock::parseHttpDate("Sun, 06 Nov 1994 25:49:37 GMT"), std::nullopt);
+	EXPECT_EQ(utils::CoarseClock::parseHttpDate(""), std::nullopt);
+}
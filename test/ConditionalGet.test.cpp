@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "http/Request.hpp"
+#include "http/Response.hpp"
+#include "utils/CoarseClock.hpp"
+#include "utils/FileCache.hpp"
+
+using http::Header;
+using http::StatusCode;
+
+namespace {
+	class ConditionalGetTest : public ::testing::Test {
+		protected:
+			std::filesystem::path _path { std::filesystem::temp_directory_path() / "webserv_conditional_get.html" };
+			std::shared_ptr<const utils::CachedFile> _file;
+			http::Request _request;
+			http::Response _response { -1 };
+
+			void SetUp() override {
+				std::ofstream(_path, std::ios::binary | std::ios::trunc) << "<p>page</p>";
+				std::filesystem::last_write_time(_path, std::filesystem::file_time_type::clock::now() - std::chrono::hours(1));
+				utils::CoarseClock::local().update();
+				_file = utils::FileCache().open(_path);
+			}
+
+			void TearDown() override {
+				std::filesystem::remove(_path);
+			}
+
+			std::string strongTag() const {
+				return _file->entityTag.substr(2);
+			}
+
+			std::string answer() {
+				_response.setResource(_request, _file, "no-cache");
+
+				std::string message = _response.getHeader().toString();
+
+				if (_response.getBody() != nullptr) {
+					message += _response.getBody()->toString();
+				}
+
+				return message;
+			}
+	};
+}
+
+TEST_F(ConditionalGetTest, SendsValidators) {
+	const std::string message = answer();
+
+	EXPECT_EQ(_response.getStatusCode(), StatusCode::OK_200);
+	EXPECT_NE(message.find("\r\nETag: " + strongTag() + "\r\n"), std::string::npos);
+	EXPECT_NE(message.find("\r\nLast-Modified: " + _file->lastModified + "\r\n"), std::string::npos);
+	EXPECT_NE(message.find("\r\nCache-Control: no-cache\r\n"), std::string::npos);
+	EXPECT_TRUE(message.ends_with("\r\n\r\n<p>page</p>"));
+}
+
+// Weak comparison: the client's tag counts whether it kept the W/ or not
+TEST_F(ConditionalGetTest, AnswersMatchingEntityTagWith304) {
+	const std::string ifNoneMatch = "\"other\", W/" + strongTag();
+
+	_request.setHeader(Header::IF_NONE_MATCH, ifNoneMatch);
+
+	const std::string message = answer();
+
+	EXPECT_EQ(_response.getStatusCode(), StatusCode::NOT_MODIFIED_304);
+	EXPECT_EQ(_response.getBody(), nullptr);
+	EXPECT_NE(message.find("\r\nETag: " + strongTag() + "\r\n"), std::string::npos);
+	EXPECT_EQ(message.find("Content-Length"), std::string::npos);
+	EXPECT_TRUE(message.ends_with("\r\n\r\n"));
+}
+
+// If-None-Match decides alone when present, even if the date would match
+TEST_F(ConditionalGetTest, PrefersEntityTagsToDates) {
+	_request.setHeader(Header::IF_NONE_MATCH, "\"other\"");
+	_request.setHeader(Header::IF_MODIFIED_SINCE, _file->lastModified);
+	answer();
+
+	EXPECT_EQ(_response.getStatusCode(), StatusCode::OK_200);
+}
+
+TEST_F(ConditionalGetTest, ComparesModificationDates) {
+	const std::time_t modified = *utils::CoarseClock::parseHttpDate(_file->lastModified);
+	const auto dateOf = [](std::time_t time) {
+		const utils::CoarseClock::HttpDate date = utils::CoarseClock::formatHttpDate(time);
+		return std::string(date.data(), date.size());
+	};
+	const std::string since = dateOf(modified);
+	const std::string before = dateOf(modified - 1);
+	const std::string future = dateOf(utils::CoarseClock::local().wallTime() + 3600);
+
+	_request.setHeader(Header::IF_MODIFIED_SINCE, since);
+	answer();
+	EXPECT_EQ(_response.getStatusCode(), StatusCode::NOT_MODIFIED_304);
+
+	for (const std::string& date : { before, future, std::string("Sunday, 06-Nov-94 08:49:37 GMT") }) {
+		_response.clear();
+		_request.setHeader(Header::IF_MODIFIED_SINCE, date);
+		answer();
+		EXPECT_EQ(_response.getStatusCode(), StatusCode::OK_200) << date;
+	}
+}
+
+// The caller's fields go out ahead of the cached ones, even when it set
+// one the file has, and the cached block holds only the file's own
+TEST_F(ConditionalGetTest, CachesOnlyFieldsOfFile) {
+	const std::string date = "Date: " + std::string(utils::CoarseClock::local().httpDate()) + "\r\n";
+	const std::string fileFields = "Content-Type: text/html; charset=utf-8\r\nContent-Length: 11\r\n\r\n<p>page</p>";
+	http::Response other(-1);
+
+	_response.setHeader(Header::CONTENT_TYPE, "text/plain");
+	_response.setHeader("X-Caller", "1");
+	_response.setFile(StatusCode::OK_200, _file);
+	other.setFile(StatusCode::OK_200, _file);
+
+	EXPECT_EQ(_response.getHeader().toString() + _response.getBody()->toString(),
+		"HTTP/1.1 200 OK\r\n" + date + "X-Caller: 1\r\nCache-Control: no-store\r\n" + fileFields);
+	EXPECT_EQ(other.getHeader().toString() + other.getBody()->toString(),
+		"HTTP/1.1 200 OK\r\n" + date + "Cache-Control: no-store\r\n" + fileFields);
+}
@@ -0,0 +1,256 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <string>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "FastCgi.hpp"
+
+using namespace fastcgi;
+
+namespace {
+	struct Record {
+		RecordType type;
+		std::uint16_t requestId;
+		std::string content;
+	};
+
+	// Reads records from the server end of the socket until `isDone` is happy
+	std::vector<Record> readRecords(int fd, const std::function<bool(const std::vector<Record>&)>& isDone) {
+		std::vector<Record> records;
+		std::string buffer;
+		char chunk[4096];
+
+		while (!isDone(records)) {
+			const ssize_t bytesRead = ::read(fd, chunk, sizeof(chunk));
+
+			if (bytesRead <= 0) {
+				break;
+			}
+
+			buffer.append(chunk, static_cast<std::size_t>(bytesRead));
+
+			while (buffer.size() >= HEADER_SIZE) {
+				const Header header = parseHeader(reinterpret_cast<const std::uint8_t*>(buffer.data()));
+				const std::size_t size = HEADER_SIZE + header.contentLength + header.paddingLength;
+
+				if (buffer.size() < size) {
+					break;
+				}
+
+				records.push_back({ header.type, header.requestId, buffer.substr(HEADER_SIZE, header.contentLength) });
+				buffer.erase(0, size);
+			}
+		}
+
+		return records;
+	}
+
+	std::size_t countEndOfStdin(const std::vector<Record>& records) {
+		return std::count_if(records.begin(), records.end(), [](const Record& record) {
+			return record.type == RecordType::STDIN && record.content.empty();
+		});
+	}
+
+	class FastCgiConnectionTest : public ::testing::Test {
+		protected:
+			std::filesystem::path _path { std::filesystem::temp_directory_path() / "webserv_fastcgi.sock" };
+			int _listenFd { -1 };
+			std::map<int, std::string> _errorPages;
+
+			void SetUp() override {
+				sockaddr_un address {};
+
+				address.sun_family = AF_UNIX;
+				std::filesystem::remove(_path);
+				std::strncpy(address.sun_path, _path.c_str(), sizeof(address.sun_path) - 1);
+				_listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+				ASSERT_EQ(::bind(_listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+				ASSERT_EQ(::listen(_listenFd, 1), 0);
+			}
+
+			void TearDown() override {
+				::close(_listenFd);
+				std::filesystem::remove(_path);
+			}
+
+			void send(int fd, const std::string& records) {
+				ASSERT_EQ(::write(fd, records.data(), records.size()), static_cast<ssize_t>(records.size()));
+			}
+
+			// One round of the event loop for the connection
+			void poll(FastCgiConnection& connection, std::vector<int>& clientFds) {
+				pollfd pollFd { connection.getFd(), connection.getEvents(connection.getFd()), 0 };
+
+				ASSERT_GT(::poll(&pollFd, 1, 5000), 0);
+				connection.process(pollFd.fd, pollFd.revents, clientFds);
+			}
+	};
+}
+
+TEST(FastCgiRecordTest, EncodesNameValuesOfAnyLength) {
+	const std::string longValue(300, 'v');
+	std::string content;
+
+	appendNameValue(content, "SHORT", "value");
+	appendNameValue(content, "LONG", longValue);
+
+	EXPECT_EQ(content.substr(0, 2), std::string("\x05\x05", 2));
+	EXPECT_EQ(content.substr(12, 5), std::string("\x04\x80\x00\x01\x2c", 5));
+
+	const NameValues nameValues = parseNameValues(content);
+
+	ASSERT_EQ(nameValues.size(), 2u);
+	EXPECT_EQ(nameValues[0], std::make_pair(std::string("SHORT"), std::string("value")));
+	EXPECT_EQ(nameValues[1], std::make_pair(std::string("LONG"), longValue));
+
+	EXPECT_THROW(parseNameValues(content.substr(0, content.size() - 1)), std::invalid_argument);
+}
+
+TEST(FastCgiRecordTest, PadsRecordsToEightBytes) {
+	std::string out;
+
+	appendRecord(out, RecordType::STDIN, 0x0102, "abc");
+
+	ASSERT_EQ(out.size(), 16u);
+
+	const Header header = parseHeader(reinterpret_cast<const std::uint8_t*>(out.data()));
+
+	EXPECT_EQ(header.type, RecordType::STDIN);
+	EXPECT_EQ(header.requestId, 0x0102);
+	EXPECT_EQ(header.contentLength, 3);
+	EXPECT_EQ(header.paddingLength, 5);
+
+	out[0] = 2;
+	EXPECT_THROW(parseHeader(reinterpret_cast<const std::uint8_t*>(out.data())), std::invalid_argument);
+}
+
+TEST_F(FastCgiConnectionTest, MultiplexesRequests) {
+	FastCgiConnection connection("unix:" + _path.string());
+	const int serverFd = ::accept(_listenFd, nullptr, nullptr);
+	std::vector<int> clientFds;
+
+	ASSERT_GE(serverFd, 0);
+	EXPECT_EQ(connection.getCapacity(), 1u);
+
+	poll(connection, clientFds);
+
+	auto values = readRecords(serverFd, [](const std::vector<Record>& records) { return !records.empty(); });
+
+	ASSERT_EQ(values.size(), 1u);
+	EXPECT_EQ(values[0].type, RecordType::GET_VALUES);
+
+	std::string reply;
+	std::string out;
+
+	appendNameValue(reply, "FCGI_MAX_REQS", "10");
+	appendNameValue(reply, "FCGI_MPXS_CONNS", "1");
+	appendRecord(out, RecordType::GET_VALUES_RESULT, 0, reply);
+	send(serverFd, out);
+	poll(connection, clientFds);
+
+	EXPECT_EQ(connection.getCapacity(), 10u);
+
+	// The body is sent as it comes in
+	const auto input = std::make_shared<http::RequestBody>(4);
+	http::Response first(100);
+	http::Response second(101);
+
+	input->append(reinterpret_cast<const std::uint8_t*>("in"), 2);
+	connection.begin({ { "REQUEST_METHOD", "POST" } }, input, CgiOutput(first, _errorPages));
+	connection.begin({ { "REQUEST_METHOD", "GET" } }, nullptr, CgiOutput(second, _errorPages));
+	poll(connection, clientFds);
+
+	EXPECT_EQ(input->size(), 0u);
+
+	input->append(reinterpret_cast<const std::uint8_t*>("pu"), 2);
+	input->complete();
+	poll(connection, clientFds);
+
+	auto records = readRecords(serverFd, [](const std::vector<Record>& records) { return countEndOfStdin(records) == 2; });
+
+	ASSERT_EQ(countEndOfStdin(records), 2u);
+	EXPECT_EQ(records[0].type, RecordType::BEGIN_REQUEST);
+	EXPECT_EQ(records[0].requestId, 1);
+	EXPECT_TRUE(std::any_of(records.begin(), records.end(), [](const Record& record) {
+		return record.type == RecordType::STDIN && record.requestId == 1 && record.content == "in";
+	}));
+	EXPECT_TRUE(std::any_of(records.begin(), records.end(), [](const Record& record) {
+		return record.type == RecordType::STDIN && record.requestId == 1 && record.content == "pu";
+	}));
+
+	// Answered in the other order, and interleaved
+	const std::string endRequest(8, '\0');
+
+	out.clear();
+	appendRecord(out, RecordType::STDOUT, 2, "Content-Type: text/plain\r\n\r\nsec");
+	appendRecord(out, RecordType::STDOUT, 1, "Status: 201 Created\r\n\r\nfirst");
+	appendRecord(out, RecordType::STDOUT, 2, "ond");
+	appendRecord(out, RecordType::END_REQUEST, 2, endRequest);
+	appendRecord(out, RecordType::END_REQUEST, 1, endRequest);
+	send(serverFd, out);
+
+	while (connection.getRequestCount() > 0) {
+		poll(connection, clientFds);
+	}
+
+	EXPECT_EQ(first.getStatusCode(), http::StatusCode::CREATED_201);
+	EXPECT_EQ(second.getStatusCode(), http::StatusCode::OK_200);
+	EXPECT_TRUE(first.isComplete());
+	EXPECT_TRUE(second.isComplete());
+	EXPECT_NE(first.getBody()->toString().find("first"), std::string::npos);
+	EXPECT_NE(second.getBody()->toString().find("3\r\nond\r\n0\r\n\r\n"), std::string::npos);
+	EXPECT_NE(std::find(clientFds.begin(), clientFds.end(), 100), clientFds.end());
+	EXPECT_NE(std::find(clientFds.begin(), clientFds.end(), 101), clientFds.end());
+	EXPECT_TRUE(connection.isOpen());
+
+	// A server going away fails what it was running
+	http::Response third(102);
+
+	connection.begin({}, nullptr, CgiOutput(third, _errorPages));
+	::close(serverFd);
+
+	while (connection.isOpen()) {
+		poll(connection, clientFds);
+	}
+
+	EXPECT_EQ(third.getStatusCode(), http::StatusCode::BAD_GATEWAY_502);
+}
+
+// Once the header is out, a responder dying can only cut the body short
+TEST_F(FastCgiConnectionTest, CutsResponseShortWhenServerDies) {
+	FastCgiConnection connection("unix:" + _path.string());
+	const int serverFd = ::accept(_listenFd, nullptr, nullptr);
+	std::vector<int> clientFds;
+	http::Response response(100);
+
+	ASSERT_GE(serverFd, 0);
+	connection.begin({ { "REQUEST_METHOD", "GET" } }, nullptr, CgiOutput(response, _errorPages));
+	poll(connection, clientFds);
+	readRecords(serverFd, [](const std::vector<Record>& records) { return countEndOfStdin(records) == 1; });
+
+	std::string out;
+
+	appendRecord(out, RecordType::STDOUT, 1, "Content-Type: text/plain\r\n\r\npartial");
+	send(serverFd, out);
+	poll(connection, clientFds);
+
+	ASSERT_EQ(response.getStatus(), http::Response::Status::READY);
+	EXPECT_FALSE(response.isComplete());
+
+	::close(serverFd);
+
+	while (connection.isOpen()) {
+		poll(connection, clientFds);
+	}
+
+	EXPECT_EQ(response.getStatusCode(), http::StatusCode::OK_200);
+	EXPECT_TRUE(response.isComplete());
+	EXPECT_TRUE(response.isAborted());
+	EXPECT_EQ(response.getBody()->toString(), "7\r\npartial\r\n");
+}
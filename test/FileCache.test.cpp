@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "utils/CoarseClock.hpp"
+#include "utils/FileCache.hpp"
+#include "Error.hpp"
+
+namespace {
+	class FileCacheTest : public ::testing::Test {
+		protected:
+			std::filesystem::path _dir { std::filesystem::temp_directory_path() / "webserv_file_cache" };
+			utils::FileCache _cache;
+
+			void SetUp() override {
+				std::filesystem::create_directories(_dir);
+				write("a.html", "<p>a</p>");
+				write("b.css", "b {}");
+				write("c.txt", "c");
+			}
+
+			void TearDown() override {
+				std::filesystem::remove_all(_dir);
+			}
+
+			void write(const std::string& name, const std::string& content) {
+				std::ofstream(_dir / name, std::ios::binary | std::ios::trunc) << content;
+			}
+	};
+}
+
+TEST_F(FileCacheTest, CachesMetadataAndFd) {
+	auto file = _cache.find(_dir / "a.html");
+
+	ASSERT_NE(file, nullptr);
+	EXPECT_FALSE(file->isDirectory());
+	EXPECT_GE(file->fd, 0);
+	EXPECT_EQ(file->size, 8u);
+	EXPECT_EQ(file->contentLength, "8");
+	EXPECT_EQ(file->mimeType, "text/html; charset=utf-8");
+	EXPECT_EQ(_cache.find(_dir / "a.html"), file);
+	EXPECT_EQ(_cache.size(), 1u);
+}
+
+TEST_F(FileCacheTest, ReportsMissingFilesAndDirectories) {
+	EXPECT_EQ(_cache.find(_dir / "missing"), nullptr);
+	EXPECT_THROW(_cache.open(_dir / "missing"), FileNotFoundException);
+
+	auto directory = _cache.find(_dir);
+
+	ASSERT_NE(directory, nullptr);
+	EXPECT_TRUE(directory->isDirectory());
+	EXPECT_EQ(directory->fd, -1);
+}
+
+TEST_F(FileCacheTest, RevalidatesAfterValidity) {
+	_cache.configure(10, 20);
+
+	auto before = _cache.find(_dir / "a.html");
+
+	write("a.html", "<p>changed</p>");
+	EXPECT_EQ(_cache.find(_dir / "a.html"), before);
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(30));
+	utils::CoarseClock::local().update();
+
+	auto after = _cache.find(_dir / "a.html");
+
+	EXPECT_NE(after, before);
+	EXPECT_EQ(after->size, 14u);
+
+	std::filesystem::remove(_dir / "a.html");
+	std::this_thread::sleep_for(std::chrono::milliseconds(30));
+	utils::CoarseClock::local().update();
+	EXPECT_EQ(_cache.find(_dir / "a.html"), nullptr);
+	EXPECT_EQ(_cache.size(), 0u);
+}
+
+// With no validity every lookup checks the file, within the same instant
+TEST_F(FileCacheTest, RevalidatesEveryLookupWithoutValidity) {
+	_cache.configure(10, 0);
+
+	auto before = _cache.find(_dir / "a.html");
+
+	EXPECT_EQ(_cache.find(_dir / "a.html"), before);
+	write("a.html", "<p>changed</p>");
+	EXPECT_EQ(_cache.find(_dir / "a.html")->size, 14u);
+}
+
+TEST_F(FileCacheTest, EvictsLeastRecentlyUsed) {
+	_cache.configure(2, 1000);
+
+	auto a = _cache.find(_dir / "a.html");
+	auto b = _cache.find(_dir / "b.css");
+
+	_cache.find(_dir / "a.html");
+	_cache.find(_dir / "c.txt");
+
+	EXPECT_EQ(_cache.size(), 2u);
+	EXPECT_EQ(_cache.find(_dir / "a.html"), a);
+	EXPECT_NE(_cache.find(_dir / "b.css"), b);
+
+	// An evicted file stays open for whoever still holds it
+	char c;
+	EXPECT_EQ(::pread(b->fd, &c, 1, 0), 1);
+	EXPECT_EQ(c, 'b');
+}
+
+// Out of fds, the cache closes its least recently used files to open more
+TEST_F(FileCacheTest, EvictsWhenOutOfDescriptors) {
+	_cache.configure(10, 1000);
+	_cache.find(_dir / "a.html");
+	_cache.find(_dir / "b.css");
+	write("d.txt", "d");
+
+	struct rlimit limit;
+	const int nextFd = ::open("/dev/null", O_RDONLY);
+
+	ASSERT_EQ(::getrlimit(RLIMIT_NOFILE, &limit), 0);
+	::close(nextFd);
+
+	struct rlimit lowered = limit;
+
+	lowered.rlim_cur = nextFd;
+	ASSERT_EQ(::setrlimit(RLIMIT_NOFILE, &lowered), 0);
+
+	auto c = _cache.find(_dir / "c.txt");
+	auto d = _cache.find(_dir / "d.txt");
+
+	::setrlimit(RLIMIT_NOFILE, &limit);
+	ASSERT_NE(c, nullptr);
+	ASSERT_NE(d, nullptr);
+	EXPECT_EQ(_cache.size(), 2u);
+	EXPECT_EQ(_cache.find(_dir / "c.txt"), c);
+}
+
+TEST_F(FileCacheTest, DisabledCacheStillOpensFiles) {
+	_cache.configure(0, 1000);
+
+	auto file = _cache.find(_dir / "c.txt");
+
+	ASSERT_NE(file, nullptr);
+	EXPECT_EQ(_cache.size(), 0u);
+	EXPECT_NE(_cache.find(_dir / "c.txt"), file);
+}
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include <fcntl.h>
+#include <fstream>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "utils/Payload.hpp"
+#include "Error.hpp"
+
+namespace {
+	class FilePayloadTest : public ::testing::Test {
+		protected:
+			std::filesystem::path _path { std::filesystem::temp_directory_path() / "webserv_file_payload.bin" };
+			std::string _content;
+			int _sockets[2] { -1, -1 };
+
+			void SetUp() override {
+				std::mt19937 rng(3);
+
+				_content.resize(3 * 1024 * 1024 + 17);
+
+				for (auto& c : _content) {
+					c = static_cast<char>(rng());
+				}
+
+				utils::FileCache::local().clear();
+				std::ofstream(_path, std::ios::binary).write(_content.data(), _content.size());
+				ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, _sockets), 0);
+				::fcntl(_sockets[0], F_SETFL, O_NONBLOCK);
+			}
+
+			void TearDown() override {
+				::close(_sockets[0]);
+				::close(_sockets[1]);
+				std::filesystem::remove(_path);
+			}
+
+			// Alternates send() and draining the peer, as POLLOUT would.
+			std::string transfer(utils::Payload& payload) {
+				std::string received;
+				char buffer[65536];
+
+				while (!payload.isSent() || received.size() < payload.getSizeInBytes()) {
+					payload.send();
+
+					ssize_t bytesRead;
+
+					while ((bytesRead = ::recv(_sockets[1], buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+						received.append(buffer, bytesRead);
+					}
+				}
+
+				return received;
+			}
+	};
+}
+
+TEST_F(FilePayloadTest, SendsWholeFile) {
+	utils::FilePayload payload(_sockets[0], _path);
+
+	EXPECT_EQ(payload.getSizeInBytes(), _content.size());
+	EXPECT_EQ(transfer(payload), _content);
+}
+
+TEST_F(FilePayloadTest, MovedPayloadKeepsFileOpen) {
+	utils::FilePayload source(_sockets[0], _path);
+	utils::FilePayload payload(std::move(source));
+	utils::FilePayload other(_sockets[0], _path);
+
+	static_assert(!std::is_copy_constructible_v<utils::FilePayload>);
+	EXPECT_EQ(other.getFile().fd, payload.getFile().fd);
+	EXPECT_EQ(transfer(payload), _content);
+	EXPECT_EQ(transfer(other), _content);
+}
+
+TEST_F(FilePayloadTest, RejectsMissingFileAndDirectory) {
+	EXPECT_THROW(utils::FilePayload(_sockets[0], _path.string() + ".missing"), FileNotFoundException);
+	EXPECT_THROW(utils::FilePayload(_sockets[0], _path.parent_path()), std::ios_base::failure);
+}
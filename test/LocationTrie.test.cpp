@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "LocationTrie.hpp"
+
+namespace {
+	Location locationAt(const std::string& path, const std::string& index = "index.html") {
+		Location location;
+
+		location.path = path;
+		location.index = index;
+		return location;
+	}
+
+	std::string matchOf(const LocationTrie& trie, std::string_view path) {
+		const Location* location = trie.findLongestPrefix(path);
+
+		return location == nullptr ? "<none>" : location->path;
+	}
+}
+
+TEST(LocationTrieTest, FindsLongestPrefix) {
+	const LocationTrie trie({
+		locationAt("/"),
+		locationAt("/static/"),
+		locationAt("/static/images/"),
+		locationAt("/cgi-bin/"),
+		locationAt("/uploads/")
+	});
+
+	EXPECT_EQ(trie.size(), 5u);
+	EXPECT_EQ(matchOf(trie, "/"), "/");
+	EXPECT_EQ(matchOf(trie, "/index.html/"), "/");
+	EXPECT_EQ(matchOf(trie, "/static/"), "/static/");
+	EXPECT_EQ(matchOf(trie, "/static/style.css/"), "/static/");
+	EXPECT_EQ(matchOf(trie, "/static/images/logo.png/"), "/static/images/");
+	EXPECT_EQ(matchOf(trie, "/static/imag/"), "/static/");
+	EXPECT_EQ(matchOf(trie, "/cgi-bin/hello.py/"), "/cgi-bin/");
+	EXPECT_EQ(matchOf(trie, "/static"), "/");
+}
+
+TEST(LocationTrieTest, MatchesNothingWithoutACommonPrefix) {
+	const LocationTrie trie({ locationAt("/static/"), locationAt("/uploads/") });
+
+	EXPECT_EQ(matchOf(trie, "/"), "<none>");
+	EXPECT_EQ(matchOf(trie, "/stat/"), "<none>");
+	EXPECT_EQ(matchOf(trie, "/upload/"), "<none>");
+	EXPECT_EQ(matchOf(trie, ""), "<none>");
+}
+
+// Inserted in any order, paths sharing part of an edge split it and the
+// locations stay where they were
+TEST(LocationTrieTest, SplitsSharedEdges) {
+	const std::vector<std::string> paths { "/api/v2/users/", "/api/v1/", "/api/", "/apps/", "/api/v2/" };
+	LocationTrie trie;
+
+	for (const std::string& path : paths) {
+		trie.insert(locationAt(path));
+	}
+
+	EXPECT_EQ(matchOf(trie, "/api/v2/users/42/"), "/api/v2/users/");
+	EXPECT_EQ(matchOf(trie, "/api/v2/orders/"), "/api/v2/");
+	EXPECT_EQ(matchOf(trie, "/api/v1/users/"), "/api/v1/");
+	EXPECT_EQ(matchOf(trie, "/api/v3/"), "/api/");
+	EXPECT_EQ(matchOf(trie, "/apps/mail/"), "/apps/");
+	EXPECT_EQ(matchOf(trie, "/ap/"), "<none>");
+}
+
+TEST(LocationTrieTest, ReplacesALocationInsertedAgain) {
+	LocationTrie trie({ locationAt("/static/", "first.html") });
+
+	trie.insert(locationAt("/static/", "second.html"));
+
+	ASSERT_NE(trie.findLongestPrefix("/static/a/"), nullptr);
+	EXPECT_EQ(trie.findLongestPrefix("/static/a/")->index, "second.html");
+	EXPECT_EQ(trie.size(), 1u);
+}
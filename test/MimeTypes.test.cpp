@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+#include "http/MimeTypes.hpp"
+
+TEST(MimeTypesTest, FindsTypeOfExtension) {
+	const http::MimeTypes mimeTypes;
+
+	EXPECT_EQ(mimeTypes.typeOf("html"), "text/html; charset=utf-8");
+	EXPECT_EQ(mimeTypes.typeOf("htm"), "text/html; charset=utf-8");
+	EXPECT_EQ(mimeTypes.typeOf("PNG"), "image/png");
+	EXPECT_EQ(mimeTypes.typeOf("woff2"), "font/woff2");
+	EXPECT_EQ(mimeTypes.typeOf("7z"), "application/x-7z-compressed");
+	EXPECT_EQ(mimeTypes.typeOf("unknown"), http::MimeTypes::DEFAULT_TYPE);
+	EXPECT_EQ(mimeTypes.typeOf(""), http::MimeTypes::DEFAULT_TYPE);
+}
+
+// Parameters and case are ignored, and a type with several extensions
+// gets the one listed first
+TEST(MimeTypesTest, FindsExtensionOfType) {
+	const http::MimeTypes mimeTypes;
+
+	EXPECT_EQ(mimeTypes.extensionOf("text/html"), "html");
+	EXPECT_EQ(mimeTypes.extensionOf("Text/HTML; charset=UTF-8"), "html");
+	EXPECT_EQ(mimeTypes.extensionOf("image/jpeg"), "jpeg");
+	EXPECT_EQ(mimeTypes.extensionOf("application/x-bzip2"), "bz2");
+	EXPECT_EQ(mimeTypes.extensionOf("font/woff2"), "woff2");
+	EXPECT_EQ(mimeTypes.extensionOf("application/json;charset=utf-8"), "json");
+	EXPECT_EQ(mimeTypes.extensionOf("application/x-unknown"), http::MimeTypes::DEFAULT_EXTENSION);
+	EXPECT_EQ(mimeTypes.extensionOf(""), http::MimeTypes::DEFAULT_EXTENSION);
+}
+
+TEST(MimeTypesTest, AddsTypes) {
+	http::MimeTypes mimeTypes;
+
+	mimeTypes.add("application/wasm", { "wasm" });
+	mimeTypes.add("text/x-markdown", { "Markdown", "md" });
+	mimeTypes.add("image/jpeg", { "jpg", "jpe" });
+
+	EXPECT_EQ(mimeTypes.typeOf("wasm"), "application/wasm");
+	EXPECT_EQ(mimeTypes.extensionOf("application/wasm"), "wasm");
+	EXPECT_EQ(mimeTypes.typeOf("md"), "text/x-markdown");
+	EXPECT_EQ(mimeTypes.typeOf("markdown"), "text/x-markdown");
+	EXPECT_EQ(mimeTypes.extensionOf("text/x-markdown"), "markdown");
+	EXPECT_EQ(mimeTypes.typeOf("jpe"), "image/jpeg");
+	EXPECT_EQ(mimeTypes.typeOf("jpeg"), "image/jpeg");
+	EXPECT_EQ(mimeTypes.extensionOf("image/jpeg"), "jpg");
+	EXPECT_EQ(mimeTypes.typeOf("html"), "text/html; charset=utf-8");
+}
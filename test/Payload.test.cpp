@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+#include <fstream>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "http/Response.hpp"
+#include "http/ResponseCache.hpp"
+#include "utils/Payload.hpp"
+
+namespace {
+	std::string join(const std::vector<iovec>& iovecs) {
+		std::string result;
+
+		for (const iovec& chunk : iovecs) {
+			result.append(static_cast<const char*>(chunk.iov_base), chunk.iov_len);
+		}
+
+		return result;
+	}
+}
+
+TEST(PayloadTest, GathersUnsentBytes) {
+	utils::StringPayload payload(-1, "hello world");
+	std::vector<iovec> iovecs;
+
+	EXPECT_EQ(payload.consume(6), 6u);
+	EXPECT_TRUE(payload.gather(iovecs));
+	EXPECT_EQ(join(iovecs), "world");
+	EXPECT_EQ(payload.consume(100), 5u);
+	EXPECT_TRUE(payload.isSent());
+
+	iovecs.clear();
+	EXPECT_TRUE(payload.gather(iovecs));
+	EXPECT_TRUE(iovecs.empty());
+}
+
+TEST(PayloadTest, ResponseConsumesHeaderThenBody) {
+	http::Response response(-1);
+	std::vector<iovec> iovecs;
+
+	response.setText(http::StatusCode::OK_200, "body");
+
+	ASSERT_TRUE(response.gather(iovecs));
+	ASSERT_EQ(iovecs.size(), 2u);
+
+	const std::string whole = join(iovecs);
+	const std::size_t headerSize = iovecs[0].iov_len;
+
+	EXPECT_TRUE(whole.starts_with("HTTP/1.1 200 OK\r\n"));
+	EXPECT_TRUE(whole.ends_with("\r\n\r\nbody"));
+
+	// A partial write that ends inside the body
+	EXPECT_EQ(response.consume(headerSize + 2), headerSize + 2);
+	EXPECT_FALSE(response.isSent());
+
+	iovecs.clear();
+	response.gather(iovecs);
+	EXPECT_EQ(join(iovecs), "dy");
+	EXPECT_EQ(response.consume(10), 2u);
+	EXPECT_TRUE(response.isSent());
+}
+
+TEST(PayloadTest, FileBodyIsLeftToSend) {
+	const auto path = std::filesystem::temp_directory_path() / "webserv_payload_test.txt";
+	int sockets[2];
+
+	std::ofstream(path) << std::string(100 * 1024, 'x');
+	ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets), 0);
+
+	{
+		http::ResponseCache::local().configure(0, 0);
+
+		http::Response response(sockets[0]);
+		std::vector<iovec> iovecs;
+
+		response.setFile(http::StatusCode::OK_200, path);
+		EXPECT_FALSE(response.gather(iovecs));
+		ASSERT_EQ(iovecs.size(), 1u);
+		EXPECT_TRUE(join(iovecs).ends_with("\r\n\r\n"));
+	}
+
+	::close(sockets[0]);
+	::close(sockets[1]);
+	std::filesystem::remove(path);
+}
+
+TEST(PayloadTest, StreamsChunksUntilFinished) {
+	utils::StreamPayload payload(-1, true);
+	std::vector<iovec> iovecs;
+
+	EXPECT_FALSE(payload.isComplete());
+	EXPECT_FALSE(payload.isSent());
+
+	payload.append(reinterpret_cast<const std::uint8_t*>("hello"), 5);
+	EXPECT_TRUE(payload.gather(iovecs));
+	EXPECT_EQ(join(iovecs), "5\r\nhello\r\n");
+	EXPECT_EQ(payload.consume(100), 10u);
+	EXPECT_FALSE(payload.hasPendingBytes());
+	EXPECT_FALSE(payload.isSent());
+
+	payload.append(reinterpret_cast<const std::uint8_t*>("0123456789abcdefg"), 17);
+	payload.finish();
+	iovecs.clear();
+	EXPECT_TRUE(payload.gather(iovecs));
+	EXPECT_EQ(join(iovecs), "11\r\n0123456789abcdefg\r\n0\r\n\r\n");
+	EXPECT_EQ(payload.consume(100), 28u);
+	EXPECT_TRUE(payload.isComplete());
+	EXPECT_TRUE(payload.isSent());
+}
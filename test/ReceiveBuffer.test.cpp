@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "utils/ReceiveBuffer.hpp"
+
+namespace {
+	std::size_t append(utils::ReceiveBuffer& buffer, const std::string& bytes) {
+		return buffer.append(reinterpret_cast<const std::uint8_t*>(bytes.data()), bytes.size());
+	}
+
+	std::string contentOf(const utils::ReceiveBuffer& buffer) {
+		return std::string(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+	}
+}
+
+TEST(ReceiveBuffer, TakesNoMoreThanItsCapacity) {
+	utils::ReceiveBuffer buffer(8);
+
+	EXPECT_EQ(buffer.available(), 0u);
+	EXPECT_EQ(append(buffer, "0123456789"), 8u);
+	EXPECT_TRUE(buffer.isFull());
+	EXPECT_EQ(buffer.available(), 0u);
+	EXPECT_EQ(contentOf(buffer), "01234567");
+
+	buffer.consume(8);
+
+	EXPECT_TRUE(buffer.empty());
+	EXPECT_EQ(append(buffer, "89"), 2u);
+	EXPECT_EQ(contentOf(buffer), "89");
+}
+
+TEST(ReceiveBuffer, MovesWhatIsLeftOnlyWhenShortOfSpace) {
+	utils::ReceiveBuffer buffer(16);
+
+	append(buffer, "GET /");
+	buffer.consume(4);
+
+	// Consuming moves nothing, and nor does receiving with room to spare
+	const std::uint8_t* left = buffer.data();
+
+	buffer.prepare();
+	EXPECT_EQ(buffer.data(), left);
+	EXPECT_EQ(buffer.available(), 11u);
+
+	append(buffer, " HTTP/1.1\r\n");
+	buffer.consume(7);
+	EXPECT_EQ(contentOf(buffer), "1.1\r\n");
+
+	std::uint8_t* space = buffer.prepare();
+
+	EXPECT_NE(buffer.data(), left + 7);
+	EXPECT_EQ(buffer.available(), 11u);
+	EXPECT_EQ(contentOf(buffer), "1.1\r\n");
+
+	space[0] = 'G';
+	buffer.commit(1);
+
+	EXPECT_EQ(contentOf(buffer), "1.1\r\nG");
+}
+
+TEST(ReceiveBuffer, HoldsASlabOnlyWhileBytesAreBuffered) {
+	const utils::SlabPool& pool = utils::SlabPool::of(100);
+	const std::size_t borrowed = pool.getBorrowed();
+
+	{
+		utils::ReceiveBuffer buffer(100);
+
+		EXPECT_FALSE(buffer.hasStorage());
+
+		append(buffer, "GET");
+		buffer.release();
+
+		EXPECT_TRUE(buffer.hasStorage());
+		EXPECT_EQ(pool.getBorrowed(), borrowed + 1);
+
+		buffer.consume(3);
+		buffer.release();
+
+		EXPECT_FALSE(buffer.hasStorage());
+		EXPECT_EQ(pool.getBorrowed(), borrowed);
+
+		utils::ReceiveBuffer moved(std::move(buffer));
+
+		append(moved, "POST");
+		EXPECT_EQ(pool.getBorrowed(), borrowed + 1);
+	}
+
+	EXPECT_EQ(pool.getBorrowed(), borrowed);
+}
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "http/parser.hpp"
+#include "http/RequestBody.hpp"
+
+namespace {
+	std::vector<std::uint8_t> bytes(const std::string& string) {
+		return std::vector<std::uint8_t>(string.begin(), string.end());
+	}
+
+	std::string contentOf(const http::RequestBody& body) {
+		return std::string(reinterpret_cast<const char*>(body.data()), body.size());
+	}
+
+	// Decodes what `buffer` holds, and removes it as the connection does
+	void parse(std::vector<std::uint8_t>& buffer, http::RequestBody& body, http::ChunkDecoder& decoder) {
+		const std::size_t parsed = http::parseRequestBody(buffer.data(), buffer.size(), body, decoder);
+
+		buffer.erase(buffer.begin(), buffer.begin() + parsed);
+	}
+
+	void decode(const std::string& chunked, std::size_t maxBodySize = SIZE_MAX) {
+		http::RequestBody body;
+		http::ChunkDecoder decoder(maxBodySize);
+
+		decoder.decode(reinterpret_cast<const std::uint8_t*>(chunked.data()), chunked.size(), body);
+	}
+}
+
+TEST(RequestBody, StopsTakingBytesOnceFull) {
+	http::RequestBody body(http::RequestBody::MAX_BUFFERED * 2);
+	std::vector<std::uint8_t> buffer(http::RequestBody::MAX_BUFFERED * 2, 'x');
+	http::ChunkDecoder decoder;
+
+	parse(buffer, body, decoder);
+
+	// All of it fits in one go, but nothing more once the consumer is behind
+	EXPECT_TRUE(body.isFull());
+	EXPECT_TRUE(buffer.empty());
+	EXPECT_TRUE(body.isComplete());
+
+	body.consume(body.size() - 1);
+
+	EXPECT_FALSE(body.isFull());
+	EXPECT_FALSE(body.isDrained());
+
+	body.consume(1);
+
+	EXPECT_TRUE(body.isDrained());
+	EXPECT_EQ(body.getReceived(), http::RequestBody::MAX_BUFFERED * 2);
+}
+
+TEST(RequestBody, DecodesChunksAsTheyArrive) {
+	http::RequestBody body;
+	http::ChunkDecoder decoder(100);
+	std::vector<std::uint8_t> buffer = bytes("5\r\nhello\r\n4\r\n wo");
+
+	parse(buffer, body, decoder);
+
+	// The start of a chunk is passed on before the rest of it arrives
+	EXPECT_EQ(contentOf(body), "hello wo");
+	EXPECT_TRUE(buffer.empty());
+	EXPECT_FALSE(body.isComplete());
+
+	buffer = bytes("r\r\n0\r\n\r\nG");
+	parse(buffer, body, decoder);
+
+	EXPECT_EQ(contentOf(body), "hello wor");
+	EXPECT_TRUE(body.isComplete());
+	EXPECT_EQ(buffer, bytes("G"));
+}
+
+TEST(RequestBody, DecodesChunksSplitAnywhere) {
+	const std::string chunked = "1A;name=\"value\"\r\nabcdefghijklmnopqrstuvwxyz\r\n3\r\n123\r\n0\r\nExpires: never\r\n\r\n";
+	http::RequestBody body;
+	http::ChunkDecoder decoder;
+
+	for (char byte : chunked) {
+		const std::uint8_t value = static_cast<std::uint8_t>(byte);
+
+		ASSERT_EQ(decoder.decode(&value, 1, body), 1u);
+	}
+
+	EXPECT_TRUE(decoder.isComplete());
+	EXPECT_TRUE(body.isComplete());
+	EXPECT_EQ(contentOf(body), "abcdefghijklmnopqrstuvwxyz123");
+}
+
+TEST(RequestBody, RejectsBadChunks) {
+	EXPECT_THROW(decode("a\r\n0123456789\r\n", 10), std::invalid_argument);
+	EXPECT_THROW(decode("3\r\nabcd\r\n"), std::invalid_argument);
+	EXPECT_THROW(decode("\r\n"), std::invalid_argument);
+	EXPECT_THROW(decode("x\r\n"), std::invalid_argument);
+	EXPECT_THROW(decode("3\nabc\r\n"), std::invalid_argument);
+	EXPECT_THROW(decode("10000000000000000\r\n"), std::invalid_argument);
+	EXPECT_THROW(decode("0\r\n\rX"), std::invalid_argument);
+	EXPECT_THROW(decode("1;" + std::string(http::ChunkDecoder::MAX_LINE_SIZE, 'x')), std::invalid_argument);
+	EXPECT_NO_THROW(decode("ffffffffffffffff"));
+}
+
+TEST(RequestBody, PushesBytesToItsConsumer) {
+	http::RequestBody body(10);
+	std::string received;
+	int lastCalls = 0;
+
+	body.append(reinterpret_cast<const std::uint8_t*>("abc"), 3);
+	body.setConsumer([&](http::RequestBody& body) {
+		received += contentOf(body);
+		body.consume(body.size());
+		lastCalls += body.isComplete() || body.isFailed();
+	});
+
+	EXPECT_EQ(received, "abc");
+
+	body.append(reinterpret_cast<const std::uint8_t*>("def"), 3);
+	body.complete();
+	body.fail();
+
+	EXPECT_EQ(received, "abcdef");
+	EXPECT_EQ(lastCalls, 1);
+	EXPECT_TRUE(body.isDrained());
+}
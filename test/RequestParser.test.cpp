@@ -0,0 +1,229 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "http/parser.hpp"
+#include "http/utils.hpp"
+
+using http::Request;
+using http::RequestParser;
+
+namespace {
+	utils::ReceiveBuffer toBuffer(const std::string& raw) {
+		utils::ReceiveBuffer buffer;
+
+		buffer.append(reinterpret_cast<const std::uint8_t*>(raw.data()), raw.size());
+		return buffer;
+	}
+
+	std::string contentOf(const utils::ReceiveBuffer& buffer) {
+		return std::string(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+	}
+}
+
+TEST(RequestParserTest, ParsesWholeHeader) {
+	RequestParser parser;
+	Request request;
+	auto buffer = toBuffer(
+		"POST /uploads/a.txt?x=1#top HTTP/1.1\r\n"
+		"host: localhost:8080\r\n"
+		"Content-Length:  5 \r\n"
+		"X-Unknown: ignored\r\n"
+		"\r\n"
+		"hello"
+	);
+
+	parser.parseHeader(buffer, request);
+
+	EXPECT_EQ(request.getStatus(), Request::Status::HEADER_COMPLETE);
+	EXPECT_EQ(request.getMethod(), "POST");
+	EXPECT_EQ(request.getUri(), "/uploads/a.txt?x=1#top");
+	EXPECT_EQ(request.getUrl().host, "localhost");
+	EXPECT_EQ(request.getUrl().port, "8080");
+	EXPECT_EQ(request.getUrl().path, "/uploads/a.txt");
+	EXPECT_EQ(request.getUrl().query, "x=1");
+	EXPECT_EQ(request.getUrl().fragment, "top");
+	EXPECT_EQ(request.getContentLength(), 5u);
+	EXPECT_EQ(request.getHeader(http::Header::HOST).value_or(""), "localhost:8080");
+	EXPECT_EQ(contentOf(buffer), "hello");
+}
+
+TEST(RequestParserTest, ResumesAcrossReads) {
+	const std::string raw("GET / HTTP/1.1\r\nHost: example.com\r\nConnection: close\r\n\r\n");
+	RequestParser parser;
+	Request request;
+	utils::ReceiveBuffer buffer;
+
+	for (char c : raw) {
+		EXPECT_EQ(request.getStatus(), Request::Status::PENDING);
+		buffer.append(reinterpret_cast<const std::uint8_t*>(&c), 1);
+		parser.parseHeader(buffer, request);
+	}
+
+	EXPECT_EQ(request.getStatus(), Request::Status::HEADER_COMPLETE);
+	EXPECT_EQ(request.getHeader(http::Header::CONNECTION).value_or(""), "close");
+	EXPECT_TRUE(buffer.empty());
+}
+
+TEST(RequestParserTest, ParsesPipelinedRequests) {
+	RequestParser parser;
+	auto buffer = toBuffer("GET /a HTTP/1.1\r\nHost: h\r\n\r\nGET /b HTTP/1.1\r\nHost: h\r\n\r\n");
+
+	for (const char* path : { "/a", "/b" }) {
+		Request request;
+		parser.parseHeader(buffer, request);
+		EXPECT_EQ(request.getStatus(), Request::Status::HEADER_COMPLETE);
+		EXPECT_EQ(request.getUrl().path, path);
+	}
+}
+
+TEST(RequestParserTest, ParsesAbsoluteForm) {
+	RequestParser parser;
+	Request request;
+	auto buffer = toBuffer("GET https://user:pw@example.com:8443/docs HTTP/1.1\r\nHost: example.com\r\n\r\n");
+
+	parser.parseHeader(buffer, request);
+
+	EXPECT_EQ(request.getUrl().scheme, "https");
+	EXPECT_EQ(request.getUrl().user, "user");
+	EXPECT_EQ(request.getUrl().password, "pw");
+	EXPECT_EQ(request.getUrl().host, "example.com");
+	EXPECT_EQ(request.getUrl().port, "8443");
+	EXPECT_EQ(request.getUrl().path, "/docs");
+}
+
+TEST(RequestParserTest, FieldsOutliveReceiveBuffer) {
+	RequestParser parser;
+	Request parsed;
+	auto buffer = toBuffer(
+		"POST /upload HTTP/1.1\r\n"
+		"Host: example.com\r\n"
+		"Content-Type: multipart/form-data; BOUNDARY=\"abc\"\r\n"
+		"\r\n"
+	);
+
+	parser.parseHeader(buffer, parsed);
+	buffer.clear();
+	buffer = toBuffer(std::string(utils::ReceiveBuffer::DEFAULT_CAPACITY, 'x'));
+
+	Request request(std::move(parsed));
+
+	EXPECT_EQ(request.getMethod(), "POST");
+	EXPECT_EQ(request.getUrl().host, "example.com");
+	EXPECT_EQ(request.getUrl().path, "/upload");
+	EXPECT_TRUE(request.isMultipart());
+	EXPECT_EQ(request.getBoundary(), "abc");
+	EXPECT_FALSE(request.getHeader(http::Header::USER_AGENT).has_value());
+
+	request.clear();
+	EXPECT_EQ(request.getMethod(), "");
+	EXPECT_FALSE(request.getHeader(http::Header::HOST).has_value());
+}
+
+TEST(RequestParserTest, RejectsMalformedHeaders) {
+	const std::vector<std::string> rawRequests {
+		"GET / HTTP/1.0\r\nHost: h\r\n\r\n",
+		"FETCH / HTTP/1.1\r\nHost: h\r\n\r\n",
+		"GET  / HTTP/1.1\r\nHost: h\r\n\r\n",
+		"GET / HTTP/1.1\r\n\r\n",
+		"GET index.html HTTP/1.1\r\nHost: h\r\n\r\n",
+		"GET / HTTP/1.1\r\nHost: h:80x\r\n\r\n",
+		"POST / HTTP/1.1\r\nHost: h\r\nContent-Length: -1\r\n\r\n",
+		"GET / HTTP/1.1\r\nHost: h\r\nTransfer-Encoding: chunked\r\n\r\n",
+	};
+
+	for (const auto& raw : rawRequests) {
+		RequestParser parser;
+		Request request;
+		auto buffer = toBuffer(raw);
+
+		EXPECT_THROW(parser.parseHeader(buffer, request), std::invalid_argument) << raw;
+	}
+}
+
+TEST(RequestParserTest, RejectsOversizedHeader) {
+	RequestParser parser;
+	Request request;
+	auto buffer = toBuffer("GET / HTTP/1.1\r\nHost: h\r\nCookie: " + std::string(http::MAX_REQUEST_HEADER_SIZE, 'a'));
+
+	EXPECT_THROW(parser.parseHeader(buffer, request), std::invalid_argument);
+}
+
+namespace {
+	struct Part {
+		std::string name;
+		std::string fileName;
+		std::string contentType;
+		std::string content;
+	};
+
+	// Feeds `raw` the way a body arrives, `step` bytes at a time, passing
+	// on again what the parser left
+	std::vector<Part> parseParts(const std::string& raw, std::size_t step, bool& isComplete) {
+		std::vector<Part> parts;
+		http::MultipartParser parser(
+			"xyz",
+			[&](const http::MultipartElement& part) { parts.push_back({ part.name, part.fileName, part.contentType, "" }); },
+			[&](const std::uint8_t* data, std::size_t size) { parts.back().content.append(reinterpret_cast<const char*>(data), size); },
+			[]() {}
+		);
+		std::vector<std::uint8_t> pending;
+
+		for (std::size_t pos = 0; pos < raw.size(); pos += step) {
+			const std::string piece = raw.substr(pos, step);
+
+			pending.insert(pending.end(), piece.begin(), piece.end());
+			pending.erase(pending.begin(), pending.begin() + parser.parse(pending.data(), pending.size()));
+		}
+
+		isComplete = parser.isComplete();
+		return parts;
+	}
+}
+
+TEST(MultipartParserTest, FindsBoundariesAcrossPieces) {
+	const std::string raw =
+		"--xyz\r\n"
+		"Content-Disposition: form-data; name=\"field\"\r\n"
+		"\r\n"
+		"value\r\n"
+		"--xyz\r\n"
+		"content-disposition: form-data; name=file; filename=\"a \\\"b\\\".txt\"\r\n"
+		"Content-Type: text/plain\r\n"
+		"\r\n"
+		"line\r\n--xy not a boundary\r\n\r\n"
+		"--xyz--\r\n"
+		"epilogue";
+
+	for (std::size_t step = 1; step <= raw.size(); step++) {
+		bool isComplete = false;
+		const std::vector<Part> parts = parseParts(raw, step, isComplete);
+
+		ASSERT_EQ(parts.size(), 2u) << step;
+		EXPECT_TRUE(isComplete) << step;
+		EXPECT_EQ(parts[0].name, "field");
+		EXPECT_EQ(parts[0].fileName, "");
+		EXPECT_EQ(parts[0].content, "value");
+		EXPECT_EQ(parts[1].name, "file");
+		EXPECT_EQ(parts[1].fileName, "a \"b\".txt");
+		EXPECT_EQ(parts[1].contentType, "text/plain");
+		EXPECT_EQ(parts[1].content, "line\r\n--xy not a boundary\r\n") << step;
+	}
+}
+
+TEST(MultipartParserTest, RejectsMalformedParts) {
+	bool isComplete = true;
+
+	EXPECT_EQ(parseParts("--xyz\r\n\r\nno end\r\n--xyz\r\n\r\nagain", 7, isComplete).size(), 2u);
+	EXPECT_FALSE(isComplete);
+	EXPECT_THROW(parseParts("--xyz\r\nNo colon here\r\n\r\n", 4, isComplete), std::invalid_argument);
+	EXPECT_THROW(parseParts("--xyz\r\n\r\na\r\n--xyzjunk\r\n", 4, isComplete), std::invalid_argument);
+	EXPECT_THROW(parseParts("--xyz\r\nX: " + std::string(http::MultipartParser::MAX_HEADER_SIZE, 'a'), 512, isComplete), std::invalid_argument);
+}
+
+TEST(HttpUtilsTest, ValidatesHeaderFields) {
+	EXPECT_TRUE(http::isValidHeaderField("content-type: text/plain"));
+	EXPECT_TRUE(http::isValidHeaderField("Host:x"));
+	EXPECT_FALSE(http::isValidHeaderField("Host x"));
+	EXPECT_FALSE(http::isValidHeaderField("Ho st: x"));
+	EXPECT_FALSE(http::isValidHeaderField("X-Custom: x"));
+}
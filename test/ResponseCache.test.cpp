@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include <fstream>
+#include <string>
+#include <thread>
+#include "http/ResponseCache.hpp"
+#include "utils/CoarseClock.hpp"
+
+using http::ResponseCache;
+using http::StatusCode;
+
+namespace {
+	class ResponseCacheTest : public ::testing::Test {
+		protected:
+			std::filesystem::path _dir { std::filesystem::temp_directory_path() / "webserv_response_cache" };
+			utils::FileCache _files;
+			ResponseCache _cache;
+
+			void SetUp() override {
+				std::filesystem::create_directories(_dir);
+				_files.configure(10, 1);
+				write("page.html", "<p>page</p>");
+			}
+
+			void TearDown() override {
+				std::filesystem::remove_all(_dir);
+			}
+
+			void write(const std::string& name, const std::string& content) {
+				std::ofstream(_dir / name, std::ios::binary | std::ios::trunc) << content;
+			}
+	};
+}
+
+TEST_F(ResponseCacheTest, StoresHeaderAndBodyTogether) {
+	auto file = _files.open(_dir / "page.html");
+	auto response = _cache.insert(*file, StatusCode::OK_200, "HTTP/1.1 200 OK\r\n\r\n");
+
+	EXPECT_EQ(*response, "HTTP/1.1 200 OK\r\n\r\n<p>page</p>");
+	EXPECT_EQ(_cache.find(*file, StatusCode::OK_200), response);
+	EXPECT_EQ(_cache.find(*file, StatusCode::NOT_FOUND_404), nullptr);
+	EXPECT_EQ(_cache.getSizeInBytes(), response->size());
+}
+
+TEST_F(ResponseCacheTest, MissesOnceFileChanges) {
+	auto file = _files.open(_dir / "page.html");
+
+	_cache.insert(*file, StatusCode::OK_200, "H\r\n\r\n");
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	write("page.html", "<p>new page</p>");
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	utils::CoarseClock::local().update();
+
+	auto changed = _files.open(_dir / "page.html");
+
+	EXPECT_EQ(_cache.find(*changed, StatusCode::OK_200), nullptr);
+	EXPECT_EQ(_cache.size(), 0u);
+}
+
+TEST_F(ResponseCacheTest, EvictsByTotalSize) {
+	write("a.txt", std::string(40, 'a'));
+	write("b.txt", std::string(40, 'b'));
+	write("big.txt", std::string(200, 'c'));
+	_cache.configure(100, 64);
+
+	auto a = _files.open(_dir / "a.txt");
+	auto b = _files.open(_dir / "b.txt");
+
+	EXPECT_FALSE(_cache.isCacheable(*_files.open(_dir / "big.txt")));
+	EXPECT_FALSE(_cache.isCacheable(*_files.open(_dir)));
+
+	_cache.insert(*a, StatusCode::OK_200, "");
+	_cache.insert(*a, StatusCode::NOT_FOUND_404, "");
+	_cache.find(*a, StatusCode::OK_200);
+	_cache.insert(*b, StatusCode::OK_200, "");
+
+	EXPECT_EQ(_cache.size(), 2u);
+	EXPECT_LE(_cache.getSizeInBytes(), 100u);
+	EXPECT_NE(_cache.find(*a, StatusCode::OK_200), nullptr);
+	EXPECT_EQ(_cache.find(*a, StatusCode::NOT_FOUND_404), nullptr);
+}
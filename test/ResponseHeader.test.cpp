@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "http/Response.hpp"
+#include "http/utils.hpp"
+#include "utils/CoarseClock.hpp"
+
+namespace {
+	std::string dateField() {
+		return "Date: " + std::string(utils::CoarseClock::local().httpDate()) + "\r\n";
+	}
+}
+
+TEST(ResponseHeaderTest, PrecomputesStatusLines) {
+	EXPECT_EQ(http::statusLineOf(http::StatusCode::OK_200), "HTTP/1.1 200 OK\r\n");
+	EXPECT_EQ(http::statusLineOf(http::StatusCode::URI_TOO_LONG_414), "HTTP/1.1 414 URI Too Long\r\n");
+	EXPECT_EQ(http::statusLineOf(http::StatusCode::HTTP_VERSION_NOT_SUPPORTED_505), "HTTP/1.1 505 HTTP Version Not Supported\r\n");
+	EXPECT_EQ(http::statusLineOf(static_cast<http::StatusCode>(299)), "");
+	EXPECT_EQ(http::stringOf(http::Header::ETAG), "ETag");
+	EXPECT_EQ(http::stringOf(http::Header::WWW_AUTHENTICATE), "WWW-Authenticate");
+}
+
+// Fields come out in the order they were first set, a field set again
+// replacing its line, whatever the case of its name
+TEST(ResponseHeaderTest, SerializesFieldsInOrderSet) {
+	http::Response res(-1);
+
+	res.setStatusCode(http::StatusCode::CREATED_201);
+	res.setHeader(http::Header::LOCATION, "/uploads/a");
+	res.setHeader("X-Request-Id", "1");
+	res.setHeader(http::Header::CONTENT_LENGTH, "0");
+	res.setHeader("x-request-id", "2");
+	res.setHeader("location", "/uploads/b");
+	res.build();
+
+	EXPECT_EQ(res.getHeader().toString(),
+		"HTTP/1.1 201 Created\r\n"
+		+ dateField() +
+		"Content-Length: 0\r\n"
+		"x-request-id: 2\r\n"
+		"Location: /uploads/b\r\n"
+		"\r\n");
+}
+
+TEST(ResponseHeaderTest, ClearsFieldsForReuse) {
+	http::Response res(-1);
+
+	res.setStatusCode(static_cast<http::StatusCode>(299));
+	res.setHeader(http::Header::CONTENT_LENGTH, "0");
+	res.build();
+	EXPECT_EQ(res.getHeader().toString(), "HTTP/1.1 299 Unknown\r\n" + dateField() + "Content-Length: 0\r\n\r\n");
+
+	res.clear();
+	res.setStatusCode(http::StatusCode::NO_CONTENT_204);
+	res.build();
+	EXPECT_EQ(res.getHeader().toString(), "HTTP/1.1 204 No Content\r\n" + dateField() + "\r\n");
+}
+
+// A Date set by the handler, e.g. a CGI script, replaces the cached one
+TEST(ResponseHeaderTest, KeepsDateSetByHandler) {
+	http::Response res(-1);
+
+	res.setStatusCode(http::StatusCode::OK_200);
+	res.setHeader("date", "Sun, 06 Nov 1994 08:49:37 GMT");
+	res.build();
+
+	EXPECT_EQ(res.getHeader().toString(), "HTTP/1.1 200 OK\r\nDate: Sun, 06 Nov 1994 08:49:37 GMT\r\n\r\n");
+}
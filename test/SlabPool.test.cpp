@@ -0,0 +1,35 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "utils/SlabPool.hpp"
+
+TEST(SlabPool, ReusesReleasedSlabs) {
+	utils::SlabPool pool(64);
+	utils::SlabPool::Slab slab = pool.acquire();
+	const std::uint8_t* address = slab.get();
+
+	EXPECT_EQ(pool.getBorrowed(), 1u);
+
+	pool.release(std::move(slab));
+
+	EXPECT_EQ(pool.getBorrowed(), 0u);
+	EXPECT_EQ(pool.getIdle(), 1u);
+	EXPECT_EQ(pool.acquire().get(), address);
+}
+
+TEST(SlabPool, KeepsABoundedNumberOfIdleSlabs) {
+	utils::SlabPool pool(16);
+	std::vector<utils::SlabPool::Slab> slabs;
+
+	for (std::size_t i = 0; i < utils::SlabPool::MAX_IDLE_SLABS + 10; i++) {
+		slabs.push_back(pool.acquire());
+	}
+
+	for (utils::SlabPool::Slab& slab : slabs) {
+		pool.release(std::move(slab));
+	}
+
+	EXPECT_EQ(pool.getBorrowed(), 0u);
+	EXPECT_EQ(pool.getIdle(), utils::SlabPool::MAX_IDLE_SLABS);
+	EXPECT_EQ(&utils::SlabPool::of(16), &utils::SlabPool::of(16));
+	EXPECT_NE(&utils::SlabPool::of(16), &utils::SlabPool::of(32));
+}
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+#include "TimerWheel.hpp"
+
+namespace {
+	struct Expiry {
+		std::size_t id;
+		std::uint64_t firedAt;
+	};
+}
+
+TEST(TimerWheelTest, FiresAtDeadline) {
+	TimerWheel wheel(1000);
+	TimerWheel::Timer timer;
+	std::vector<std::uint64_t> fired;
+
+	wheel.schedule(timer, 1050);
+	EXPECT_EQ(wheel.getTimeout(1000), 50);
+
+	wheel.advance(1049, [&](TimerWheel::Timer&) { fired.push_back(1049); });
+	EXPECT_TRUE(fired.empty());
+
+	wheel.advance(1050, [&](TimerWheel::Timer&) { fired.push_back(1050); });
+	ASSERT_EQ(fired.size(), 1u);
+	EXPECT_FALSE(timer.isArmed());
+	EXPECT_EQ(wheel.size(), 0u);
+	EXPECT_EQ(wheel.getTimeout(1050), -1);
+}
+
+TEST(TimerWheelTest, CancelAndReschedule) {
+	TimerWheel wheel(0);
+	TimerWheel::Timer timer;
+	int count = 0;
+
+	wheel.schedule(timer, 30000);
+	wheel.schedule(timer, 100);
+	EXPECT_EQ(wheel.size(), 1u);
+
+	wheel.cancel(timer);
+	wheel.advance(40000, [&](TimerWheel::Timer&) { count++; });
+	EXPECT_EQ(count, 0);
+}
+
+TEST(TimerWheelTest, CallbackMayRearm) {
+	TimerWheel wheel(0);
+	TimerWheel::Timer timer;
+	int count = 0;
+
+	wheel.schedule(timer, 10);
+	wheel.advance(100, [&](TimerWheel::Timer& t) {
+		if (++count < 5) {
+			wheel.schedule(t, 10 + count * 10);
+		}
+	});
+	EXPECT_EQ(count, 5);
+}
+
+// Every timer must fire exactly once, no earlier than its deadline and no
+// later than the first advance past it, across all levels of the wheel.
+TEST(TimerWheelTest, MatchesDeadlinesAcrossLevels) {
+	std::mt19937_64 rng(42);
+	const std::uint64_t start = 123456789;
+	TimerWheel wheel(start);
+	std::vector<TimerWheel::Timer> timers(5000);
+	std::vector<std::uint64_t> deadlines(timers.size());
+	std::vector<Expiry> expiries;
+
+	for (std::size_t i = 0; i < timers.size(); i++) {
+		const std::uint64_t ranges[] = { 64, 4096, 262144, 4000000 };
+		deadlines[i] = start + 1 + rng() % ranges[i % 4];
+		timers[i].data = reinterpret_cast<void*>(i);
+		wheel.schedule(timers[i], deadlines[i]);
+	}
+
+	std::uint64_t now = start;
+
+	while (wheel.size() > 0) {
+		now += 1 + rng() % 20000;
+		wheel.advance(now, [&](TimerWheel::Timer& t) {
+			expiries.push_back({ reinterpret_cast<std::size_t>(t.data), now });
+		});
+	}
+
+	ASSERT_EQ(expiries.size(), timers.size());
+
+	std::vector<bool> seen(timers.size());
+	for (const auto& [id, firedAt] : expiries) {
+		EXPECT_FALSE(seen[id]);
+		seen[id] = true;
+		EXPECT_GE(firedAt, deadlines[id]);
+		EXPECT_LT(firedAt - deadlines[id], 20000u);
+	}
+}
+
+TEST(TimerWheelTest, TimeoutPointsAtNextDeadline) {
+	TimerWheel wheel(0);
+	TimerWheel::Timer near;
+	TimerWheel::Timer far;
+
+	wheel.schedule(far, 5000);
+	wheel.schedule(near, 70);
+
+	int fired = 0;
+	std::uint64_t now = 0;
+
+	// Following the suggested timeouts must never overshoot a deadline
+	while (wheel.size() > 0) {
+		const int timeout = wheel.getTimeout(now);
+		ASSERT_GE(timeout, 0);
+		now += timeout;
+		wheel.advance(now, [&](TimerWheel::Timer& t) {
+			EXPECT_EQ(now, t.expiry);
+			fired++;
+		});
+	}
+	EXPECT_EQ(fired, 2);
+}
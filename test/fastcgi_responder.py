@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+"""Stand-in FastCGI responder for trying out fastcgi_pass locally.
+
+Usage: fastcgi_responder.py unix:/tmp/fcgi.sock | 127.0.0.1:9000
+
+Requests are multiplexed on each connection and answered from their own
+thread. The response echoes the request: its params, then its body. A
+`sleep=<seconds>` query delays the answer, and `size=<bytes>` answers that
+many bytes of body instead.
+"""
+
+import os
+import socket
+import struct
+import sys
+import threading
+import time
+from urllib.parse import parse_qs
+
+VERSION = 1
+BEGIN_REQUEST, ABORT_REQUEST, END_REQUEST, PARAMS, STDIN, STDOUT, STDERR = 1, 2, 3, 4, 5, 6, 7
+GET_VALUES, GET_VALUES_RESULT, UNKNOWN_TYPE = 9, 10, 11
+MAX_REQS = 32
+
+
+def record(type, request_id, content=b""):
+    padding = (8 - len(content) % 8) % 8
+    header = struct.pack("!BBHHBx", VERSION, type, request_id, len(content), padding)
+    return header + content + b"\0" * padding
+
+
+def encode_length(length):
+    return bytes([length]) if length < 128 else struct.pack("!I", length | 0x80000000)
+
+
+def name_values(pairs):
+    return b"".join(encode_length(len(n)) + encode_length(len(v)) + n + v for n, v in pairs)
+
+
+def parse_name_values(data):
+    pairs, i = {}, 0
+    while i < len(data):
+        lengths = []
+        for _ in range(2):
+            if data[i] < 128:
+                lengths.append(data[i])
+                i += 1
+            else:
+                lengths.append(struct.unpack("!I", data[i:i + 4])[0] & 0x7fffffff)
+                i += 4
+        name = data[i:i + lengths[0]]
+        value = data[i + lengths[0]:i + lengths[0] + lengths[1]]
+        pairs[name.decode()] = value.decode(errors="replace")
+        i += lengths[0] + lengths[1]
+    return pairs
+
+
+class Connection:
+    def __init__(self, sock):
+        self.sock = sock
+        self.lock = threading.Lock()
+        self.requests = {}
+
+    def send(self, data):
+        with self.lock:
+            self.sock.sendall(data)
+
+    def respond(self, request_id, params, body):
+        query = parse_qs(params.get("QUERY_STRING", ""))
+        time.sleep(float(query.get("sleep", ["0"])[0]))
+        size = int(query.get("size", ["-1"])[0])
+
+        if size >= 0:
+            output = b"Content-Type: application/octet-stream\r\n\r\n" + b"x" * size
+        else:
+            lines = ["%s=%s" % item for item in sorted(params.items())]
+            output = ("Content-Type: text/plain\r\n\r\nHello from FastCGI\n%s\n" % "\n".join(lines)).encode() + body
+
+        for offset in range(0, len(output), 65535):
+            self.send(record(STDOUT, request_id, output[offset:offset + 65535]))
+        self.send(record(STDOUT, request_id) + record(END_REQUEST, request_id, struct.pack("!IB3x", 0, 0)))
+
+    def handle(self, type, request_id, content):
+        if type == GET_VALUES:
+            values = {"FCGI_MAX_REQS": str(MAX_REQS), "FCGI_MPXS_CONNS": "1", "FCGI_MAX_CONNS": "8"}
+            asked = parse_name_values(content)
+            reply = [(n.encode(), values[n].encode()) for n in asked if n in values]
+            self.send(record(GET_VALUES_RESULT, 0, name_values(reply)))
+        elif type == BEGIN_REQUEST:
+            self.requests[request_id] = [b"", b""]
+        elif type == PARAMS and request_id in self.requests:
+            self.requests[request_id][0] += content
+        elif type == STDIN and request_id in self.requests:
+            if content:
+                self.requests[request_id][1] += content
+                return
+            params, body = self.requests.pop(request_id)
+            threading.Thread(target=self.respond, args=(request_id, parse_name_values(params), body), daemon=True).start()
+        elif type == ABORT_REQUEST:
+            self.requests.pop(request_id, None)
+            self.send(record(END_REQUEST, request_id, struct.pack("!IB3x", 1, 0)))
+        elif type not in (PARAMS, STDIN):
+            self.send(record(UNKNOWN_TYPE, 0, bytes([type]) + b"\0" * 7))
+
+    def run(self):
+        buffer = b""
+        while True:
+            data = self.sock.recv(65536)
+            if not data:
+                break
+            buffer += data
+            while len(buffer) >= 8:
+                _, type, request_id, length, padding = struct.unpack("!BBHHBx", buffer[:8])
+                if len(buffer) < 8 + length + padding:
+                    break
+                self.handle(type, request_id, buffer[8:8 + length])
+                buffer = buffer[8 + length + padding:]
+        self.sock.close()
+
+
+def main():
+    address = sys.argv[1] if len(sys.argv) > 1 else "unix:/tmp/webserv-fastcgi.sock"
+
+    if address.startswith("unix:"):
+        path = address[5:]
+        if os.path.exists(path):
+            os.unlink(path)
+        server = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        server.bind(path)
+    else:
+        host, port = address.rsplit(":", 1)
+        server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        server.bind((host, int(port)))
+
+    server.listen(64)
+    print("FastCGI responder listening on", address, flush=True)
+
+    while True:
+        sock, _ = server.accept()
+        threading.Thread(target=Connection(sock).run, daemon=True).start()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include "utils/scan.hpp"
+
+namespace {
+	const std::vector<utils::SimdLevel> LEVELS {
+		utils::SimdLevel::SCALAR, utils::SimdLevel::SSE42, utils::SimdLevel::AVX2
+	};
+
+	bool isTokenChar(unsigned char c) {
+		return std::isalnum(c) || std::string_view("!#$%&'*+-.^_`|~").find(c) != std::string_view::npos;
+	}
+
+	class ScanTest : public ::testing::TestWithParam<utils::SimdLevel> {
+		protected:
+			void SetUp() override {
+				utils::setSimdLevel(GetParam());
+			}
+
+			void TearDown() override {
+				utils::setSimdLevel(utils::getMaxSimdLevel());
+			}
+	};
+}
+
+TEST_P(ScanTest, FindByteMatchesStdFind) {
+	std::mt19937 rng(42);
+	std::vector<std::uint8_t> data(300);
+
+	for (std::size_t offset = 0; offset < 40; offset++) {
+		for (std::size_t length = 0; length + offset <= data.size(); length += 7) {
+			std::generate(data.begin(), data.end(), [&] { return static_cast<std::uint8_t>('a' + rng() % 26); });
+
+			if (length > 0 && rng() % 4 != 0) {
+				data[offset + rng() % length] = '\n';
+			}
+
+			const std::uint8_t* begin = data.data() + offset;
+			const std::uint8_t* end = begin + length;
+
+			EXPECT_EQ(utils::findByte(begin, end, '\n'), std::find(begin, end, '\n'));
+		}
+	}
+}
+
+TEST_P(ScanTest, FindSequenceMatchesStdSearch) {
+	std::mt19937 rng(7);
+	const std::vector<std::string> needles { "\r\n\r\n", "\r\n", "--boundary--\r\n", "--a-much-longer-multipart-boundary-of-44" };
+	std::vector<std::uint8_t> data(400);
+
+	for (const auto& needle : needles) {
+		for (std::size_t offset = 0; offset < 33; offset++) {
+			for (std::size_t length = 0; length + offset <= data.size(); length += 11) {
+				// A small alphabet produces many partial matches
+				std::generate(data.begin(), data.end(), [&] { return static_cast<std::uint8_t>("\r\n-ab"[rng() % 5]); });
+
+				if (length >= needle.size() && rng() % 2 == 0) {
+					std::copy(needle.begin(), needle.end(), data.begin() + offset + rng() % (length - needle.size() + 1));
+				}
+
+				const std::uint8_t* begin = data.data() + offset;
+				const std::uint8_t* end = begin + length;
+
+				EXPECT_EQ(utils::findSequence(begin, end, needle), std::search(begin, end, needle.begin(), needle.end()));
+			}
+		}
+	}
+}
+
+TEST_P(ScanTest, FindNonTokenClassifiesEveryByte) {
+	for (int c = 0; c < 256; c++) {
+		for (std::size_t position : { 0u, 15u, 16u, 31u, 40u }) {
+			std::vector<std::uint8_t> data(48, 'x');
+
+			data[position] = static_cast<std::uint8_t>(c);
+
+			const std::uint8_t* expected = isTokenChar(c) ? data.data() + data.size() : data.data() + position;
+			EXPECT_EQ(utils::findNonToken(data.data(), data.data() + data.size()), expected) << "byte " << c;
+		}
+	}
+}
+
+TEST_P(ScanTest, SelectedLevelIsClampedToCpu) {
+	EXPECT_EQ(utils::getSimdLevel(), std::min(GetParam(), utils::getMaxSimdLevel()));
+}
+
+INSTANTIATE_TEST_SUITE_P(AllLevels, ScanTest, ::testing::ValuesIn(LEVELS));